@@ -16,13 +16,33 @@
 #include <QCoreApplication>
 #include <QDateTime>
 #include <QBitArray>
+#include <QScopeGuard>
 #include <QUrl>
 
 #include <stdlib.h>
 
+#include <memory>
+
 namespace
 {
     const int CMD_MIMETYPE = 70; // Should be declared in KIOCore/KIO/Global, but it's missing. Why?
+
+    // get() reads this many sectors at once. The device backend splits
+    // the reads according to the maximum transfer length of the drive.
+    const int READ_SECTORS = 256;
+
+    // the primary volume descriptor is used to recognize a medium
+    // on drives which do not report media events
+    const unsigned int PRIMARY_VOLUME_DESCRIPTOR_SECTOR = 16;
+
+    QByteArray readVolumeDescriptor( K3b::Device::Device* dev )
+    {
+        QByteArray descriptor( 2048, '\0' );
+        if( dev->read10( reinterpret_cast<unsigned char*>( descriptor.data() ), descriptor.size(),
+                         PRIMARY_VOLUME_DESCRIPTOR_SECTOR, 1 ) )
+            return descriptor;
+        return QByteArray();
+    }
 } // namespace
 
 using namespace KIO;
@@ -65,6 +85,50 @@ extern "C"
 
 
 
+/**
+ * The opened filesystem of the medium in one device.
+ */
+class kio_videodvdProtocol::CachedMedium
+{
+public:
+    explicit CachedMedium( K3b::Device::Device* dev )
+        : device( dev ),
+          useMediaEvents( true ) {
+    }
+
+    /**
+     * Check if the medium is still the one the filesystem has been read from.
+     */
+    bool isValid();
+
+    K3b::Device::Device* device;
+    std::unique_ptr<K3b::Iso9660> iso;
+    QByteArray volumeDescriptor;
+    bool useMediaEvents;
+};
+
+
+bool kio_videodvdProtocol::CachedMedium::isValid()
+{
+    //
+    // Media events are cheap and also report a medium which has been replaced
+    // in the meantime. Any event including an eject request invalidates the
+    // cache.
+    //
+    if( useMediaEvents ) {
+        K3b::Device::Device::MediaEvent event = K3b::Device::Device::MediaEventNone;
+        bool mediumPresent = false;
+        if( device->getMediaEventStatus( event, mediumPresent ) )
+            return( mediumPresent && event == K3b::Device::Device::MediaEventNone );
+        useMediaEvents = false;
+    }
+
+    const QByteArray descriptor = readVolumeDescriptor( device );
+    return( !descriptor.isEmpty() && descriptor == volumeDescriptor );
+}
+
+
+
 // FIXME: Does it really make sense to use a static device manager? Are all instances
 // of videodvd started in another process?
 K3b::Device::DeviceManager* kio_videodvdProtocol::s_deviceManager = nullptr;
@@ -87,6 +151,10 @@ kio_videodvdProtocol::kio_videodvdProtocol(const QByteArray &pool_socket, const
 kio_videodvdProtocol::~kio_videodvdProtocol()
 {
     qCDebug(KIO_VIDEODVD_LOG) << "kio_videodvdProtocol::~kio_videodvdProtocol()";
+    // close the devices before the device manager goes away
+    qDeleteAll( m_media );
+    m_media.clear();
+
     s_instanceCnt--;
     if( s_instanceCnt == 0 )
     {
@@ -126,40 +194,84 @@ KIO::UDSEntry kio_videodvdProtocol::createUDSEntry( const K3b::Iso9660Entry* e )
 }
 
 
-// FIXME: remember the iso instance for quicker something and search for the videodvd
-//        in the available devices.
-KIO::WorkerResult kio_videodvdProtocol::openIso( const QUrl& url, std::unique_ptr<K3b::Iso9660>* isoPtr, QString* plainIsoPath )
+K3b::Iso9660* kio_videodvdProtocol::cachedIso( K3b::Device::Device* dev )
+{
+    CachedMedium* medium = m_media.value( dev );
+    if( medium ) {
+        if( medium->isValid() )
+            return medium->iso.get();
+
+        qCDebug(KIO_VIDEODVD_LOG) << "(kio_videodvdProtocol) medium changed in" << dev->blockDeviceName();
+        m_media.remove( dev );
+        delete medium;
+    }
+
+    K3b::Device::DiskInfo di = dev->diskInfo();
+
+    // we search for a DVD with a single track.
+    // this time let K3b::Iso9660 decide if we need dvdcss or not
+    // FIXME: check for encryption and libdvdcss and report an error
+    if( !K3b::Device::isDvdMedia( di.mediaType() ) || di.numTracks() != 1 )
+        return nullptr;
+
+    medium = new CachedMedium( dev );
+
+    // drop the events which led to the current medium
+    K3b::Device::Device::MediaEvent event;
+    bool mediumPresent;
+    medium->useMediaEvents = dev->getMediaEventStatus( event, mediumPresent );
+
+    medium->iso.reset( new K3b::Iso9660( dev ) );
+    medium->iso->setPlainIso9660( true );
+    if( !medium->iso->open() ) {
+        delete medium;
+        return nullptr;
+    }
+    medium->volumeDescriptor = readVolumeDescriptor( dev );
+
+    m_media.insert( dev, medium );
+    return medium->iso.get();
+}
+
+
+void kio_videodvdProtocol::releaseDevices()
+{
+    Q_FOREACH( CachedMedium* medium, m_media ) {
+        medium->iso->closeBackend();
+    }
+}
+
+
+KIO::WorkerResult kio_videodvdProtocol::openIso( const QUrl& url, K3b::Iso9660** isoPtr, QString* plainIsoPath )
 {
     // get the volume id from the url
     QString volumeId = url.path().section( '/', 1, 1 );
 
     qCDebug(KIO_VIDEODVD_LOG) << "(kio_videodvdProtocol) searching for Video dvd: " << volumeId;
 
-
-    // now search the devices for this volume id
-    // FIXME: use the cache created in listVideoDVDs
+    // now search the devices for this volume id. If no medium matches we
+    // fall back to the first DVD like we always did.
+    K3b::Iso9660* firstIso = nullptr;
     QList<K3b::Device::Device *> items(s_deviceManager->dvdReader());
     for( QList<K3b::Device::Device *>::const_iterator it = items.constBegin();
          it != items.constEnd(); ++it ) {
-        K3b::Device::Device* dev = *it;
-        K3b::Device::DiskInfo di = dev->diskInfo();
-
-        // we search for a DVD with a single track.
-        // this time let K3b::Iso9660 decide if we need dvdcss or not
-        // FIXME: check for encryption and libdvdcss and report an error
-        if( K3b::Device::isDvdMedia( di.mediaType() ) && di.numTracks() == 1 ) {
-            K3b::Iso9660* iso = new K3b::Iso9660( dev );
-            iso->setPlainIso9660( true );
-            if( iso->open() /*&& iso->primaryDescriptor().volumeId == volumeId*/ ) {
-                *plainIsoPath = url.path().section( '/', 2, -1 ) + '/';
-                (*isoPtr).reset(iso);
-                qCDebug(KIO_VIDEODVD_LOG) << "(kio_videodvdProtocol) using iso path: " << *plainIsoPath;
-                return KIO::WorkerResult::pass();
+        if( K3b::Iso9660* iso = cachedIso( *it ) ) {
+            if( iso->primaryDescriptor().volumeId == volumeId ) {
+                firstIso = iso;
+                break;
             }
-            delete iso;
+            if( !firstIso )
+                firstIso = iso;
         }
     }
 
+    if( firstIso ) {
+        *plainIsoPath = url.path().section( '/', 2, -1 ) + '/';
+        *isoPtr = firstIso;
+        qCDebug(KIO_VIDEODVD_LOG) << "(kio_videodvdProtocol) using iso path: " << *plainIsoPath;
+        return KIO::WorkerResult::pass();
+    }
+
     return KIO::WorkerResult::fail( ERR_WORKER_DEFINED, i18n("No Video DVD found") );
 }
 
@@ -168,8 +280,10 @@ KIO::WorkerResult kio_videodvdProtocol::get(const QUrl& url )
 {
     qCDebug(KIO_VIDEODVD_LOG) << "kio_videodvd::get(const QUrl& url)" << url;
 
+    const auto deviceReleaser = qScopeGuard( [this] { releaseDevices(); } );
+
     QString isoPath;
-    std::unique_ptr<K3b::Iso9660> iso;
+    K3b::Iso9660* iso = nullptr;
     const KIO::WorkerResult openIsoResult = openIso(url, &iso, &isoPath);
     if (!openIsoResult.success()) {
         return openIsoResult;
@@ -180,21 +294,19 @@ KIO::WorkerResult kio_videodvdProtocol::get(const QUrl& url )
     {
         const K3b::Iso9660File* file = static_cast<const K3b::Iso9660File*>( e );
         totalSize( file->size() );
-        QByteArray buffer( 10*2048, '\n' );
+        // Reading whole sectors at sector aligned positions lets Iso9660File read
+        // directly into the buffer
+        QByteArray buffer( READ_SECTORS*2048, '\n' );
         int read = 0;
-        int cnt = 0;
         KIO::filesize_t totalRead = 0;
         while( (read = file->read( totalRead, buffer.data(), buffer.size() )) > 0 )
         {
-            buffer.resize( read );
-            data(buffer);
-            ++cnt;
+            if( read < buffer.size() )
+                data( QByteArray::fromRawData( buffer.constData(), read ) );
+            else
+                data( buffer );
             totalRead += read;
-            if( cnt == 10 )
-            {
-                cnt = 0;
-                processedSize( totalRead );
-            }
+            processedSize( totalRead );
         }
 
         data(QByteArray()); // empty array means we're done sending the data
@@ -214,6 +326,8 @@ KIO::WorkerResult kio_videodvdProtocol::listDir( const QUrl& url )
 {
     qCDebug(KIO_VIDEODVD_LOG) << "kio_videodvd::listDir(const QUrl& url)" << url;
 
+    const auto deviceReleaser = qScopeGuard( [this] { releaseDevices(); } );
+
     if( isRootDirectory( url ) ) {
 #ifdef Q_OS_WIN32
     qCWarning(KIO_VIDEODVD_LOG) << "fix of root path required";
@@ -222,7 +336,7 @@ KIO::WorkerResult kio_videodvdProtocol::listDir( const QUrl& url )
     }
 
     QString isoPath;
-    std::unique_ptr<K3b::Iso9660> iso;
+    K3b::Iso9660* iso = nullptr;
     const KIO::WorkerResult openIsoResult = openIso(url, &iso, &isoPath);
     if (!openIsoResult.success()) {
         return openIsoResult;
@@ -257,31 +371,20 @@ KIO::WorkerResult kio_videodvdProtocol::listVideoDVDs()
     QList<K3b::Device::Device *> items(s_deviceManager->dvdReader());
     for( QList<K3b::Device::Device *>::const_iterator it = items.constBegin();
          it != items.constEnd(); ++it ) {
-        K3b::Device::Device* dev = *it;
-        K3b::Device::DiskInfo di = dev->diskInfo();
-
-        // we search for a DVD with a single track.
-        if( K3b::Device::isDvdMedia( di.mediaType() ) && di.numTracks() == 1 ) {
-            //
-            // now do a quick check for VideoDVD.
-            // - no dvdcss for speed
-            // - only a check for the VIDEO_TS dir
-            //
-            K3b::Iso9660 iso( new K3b::Iso9660DeviceBackend(dev) );
-            iso.setPlainIso9660( true );
-            if( iso.open() && iso.firstIsoDirEntry()->entry( "VIDEO_TS" ) != nullptr ) {
-                // FIXME: cache the entry for speedup
-
-                UDSEntry uds;
-                uds.fastInsert( KIO::UDSEntry::UDS_NAME,iso.primaryDescriptor().volumeId );
-                uds.fastInsert( KIO::UDSEntry::UDS_FILE_TYPE, S_IFDIR );
-                uds.fastInsert( KIO::UDSEntry::UDS_MIME_TYPE, "inode/directory" );
-                uds.fastInsert( KIO::UDSEntry::UDS_ICON_NAME, "media-optical-video" );
-                uds.fastInsert( KIO::UDSEntry::UDS_SIZE, iso.primaryDescriptor().volumeSetSize );
-
-                udsl.append( uds );
-                listEntries( udsl );
-            }
+        //
+        // a quick check for VideoDVD: only check for the VIDEO_TS dir
+        //
+        K3b::Iso9660* iso = cachedIso( *it );
+        if( iso && iso->firstIsoDirEntry()->entry( "VIDEO_TS" ) != nullptr ) {
+            UDSEntry uds;
+            uds.fastInsert( KIO::UDSEntry::UDS_NAME,iso->primaryDescriptor().volumeId );
+            uds.fastInsert( KIO::UDSEntry::UDS_FILE_TYPE, S_IFDIR );
+            uds.fastInsert( KIO::UDSEntry::UDS_MIME_TYPE, "inode/directory" );
+            uds.fastInsert( KIO::UDSEntry::UDS_ICON_NAME, "media-optical-video" );
+            uds.fastInsert( KIO::UDSEntry::UDS_SIZE, iso->primaryDescriptor().volumeSetSize );
+
+            udsl.append( uds );
+            listEntries( udsl );
         }
     }
 
@@ -296,6 +399,8 @@ KIO::WorkerResult kio_videodvdProtocol::stat( const QUrl& url )
 {
     qCDebug(KIO_VIDEODVD_LOG) << "kio_videodvd::stat(const QUrl& url)" << url;
 
+    const auto deviceReleaser = qScopeGuard( [this] { releaseDevices(); } );
+
     if( isRootDirectory( url ) ) {
 #ifdef Q_OS_WIN32
     qCWarning(KIO_VIDEODVD_LOG) << "fix root path detection";
@@ -313,7 +418,7 @@ KIO::WorkerResult kio_videodvdProtocol::stat( const QUrl& url )
     }
 
     QString isoPath;
-    std::unique_ptr<K3b::Iso9660> iso;
+    K3b::Iso9660* iso = nullptr;
     const KIO::WorkerResult openIsoResult = openIso(url, &iso, &isoPath);
     if (!openIsoResult.success()) {
         return openIsoResult;
@@ -337,12 +442,14 @@ KIO::WorkerResult kio_videodvdProtocol::mimetype( const QUrl& url )
 {
     qCDebug(KIO_VIDEODVD_LOG) << "kio_videodvd::mimetype(const QUrl& url)" << url;
 
+    const auto deviceReleaser = qScopeGuard( [this] { releaseDevices(); } );
+
     if( isRootDirectory( url ) ) {
         return KIO::WorkerResult::fail( ERR_UNSUPPORTED_ACTION, KIO::unsupportedActionErrorString("videodvd", CMD_MIMETYPE) );
     }
 
     QString isoPath;
-    std::unique_ptr<K3b::Iso9660> iso;
+    K3b::Iso9660* iso = nullptr;
     const KIO::WorkerResult openIsoResult = openIso(url, &iso, &isoPath);
     if (!openIsoResult.success()) {
         return openIsoResult;
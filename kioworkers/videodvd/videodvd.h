@@ -7,6 +7,7 @@
 #ifndef _videodvd_H_
 #define _videodvd_H_
 
+#include <QHash>
 #include <QString>
 
 #include "k3biso9660.h"
@@ -14,10 +15,9 @@
 
 #include <KIO/WorkerBase>
 
-#include <memory>
-
 namespace K3b {
     namespace Device {
+        class Device;
         class DeviceManager;
     }
 }
@@ -34,10 +34,28 @@ public:
     KIO::WorkerResult listDir(const QUrl& url) override;
 
 private:
-    KIO::WorkerResult openIso( const QUrl& url, std::unique_ptr<K3b::Iso9660>* iso, QString* plainIsoPath );
+    class CachedMedium;
+
+    /**
+     * The opened filesystem of the medium in @p dev or 0 if it does not contain
+     * a single track DVD. The filesystem is kept open and reused until the medium
+     * changes.
+     */
+    K3b::Iso9660* cachedIso( K3b::Device::Device* dev );
+
+    /**
+     * Close the devices of all cached media while keeping their filesystems.
+     * This is done after each request so the media can be ejected and other
+     * applications are able to use the devices while the worker idles.
+     */
+    void releaseDevices();
+
+    KIO::WorkerResult openIso( const QUrl& url, K3b::Iso9660** iso, QString* plainIsoPath );
     KIO::UDSEntry createUDSEntry( const K3b::Iso9660Entry* e ) const;
     KIO::WorkerResult listVideoDVDs();
 
+    QHash<K3b::Device::Device*, CachedMedium*> m_media;
+
     static K3b::Device::DeviceManager* s_deviceManager;
     static int s_instanceCnt;
 };
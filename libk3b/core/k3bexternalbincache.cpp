@@ -0,0 +1,278 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bexternalbincache.h"
+#include "k3bexternalbinmanager.h"
+#include "k3bcore.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QStringList>
+
+#ifndef Q_OS_WIN32
+#include <sys/stat.h>
+#endif
+
+
+namespace {
+    const quint32 s_magic = 0x4b334542; // "K3EB"
+    const quint32 s_version = 1;
+
+    struct FileId {
+        FileId()
+            : inode( 0 ),
+              size( 0 ),
+              modified( 0 ),
+              changed( 0 ) {
+        }
+
+        bool operator==( const FileId& other ) const {
+            return inode == other.inode &&
+                size == other.size &&
+                modified == other.modified &&
+                changed == other.changed;
+        }
+
+        quint64 inode;
+        qint64 size;
+        qint64 modified;
+        qint64 changed;
+    };
+
+    bool fileId( const QString& path, FileId& id )
+    {
+        // QFileInfo follows symlinks just like stat does, which is what we want since
+        // cdrecord and friends are often links to the actual binary
+        QFileInfo fi( path );
+        if( !fi.exists() )
+            return false;
+
+        id.size = fi.size();
+        id.modified = fi.lastModified().toMSecsSinceEpoch();
+        // the status change time covers changes of the permissions (suid root)
+        id.changed = fi.metadataChangeTime().toMSecsSinceEpoch();
+#ifndef Q_OS_WIN32
+        struct stat st;
+        if( ::stat( QFile::encodeName( path ), &st ) == 0 )
+            id.inode = st.st_ino;
+#endif
+        return true;
+    }
+
+    struct Record {
+        FileId id;
+        QString version;
+        QString copyright;
+        QStringList features;
+    };
+
+    QDataStream& operator<<( QDataStream& s, const Record& r )
+    {
+        return s << r.id.inode << r.id.size << r.id.modified << r.id.changed
+                 << r.version << r.copyright << r.features;
+    }
+
+    QDataStream& operator>>( QDataStream& s, Record& r )
+    {
+        return s >> r.id.inode >> r.id.size >> r.id.modified >> r.id.changed
+                 >> r.version >> r.copyright >> r.features;
+    }
+
+    QString recordKey( const K3b::ExternalBin& bin )
+    {
+        return bin.name() + QLatin1Char( ':' ) + bin.path();
+    }
+
+    Q_GLOBAL_STATIC( K3b::ExternalBinCache, s_instance )
+}
+
+
+class K3b::ExternalBinCache::Private
+{
+public:
+    Private()
+        : loaded( false ),
+          dirty( false ) {
+    }
+
+    void load();
+
+    QString filename;
+    bool loaded;
+    bool dirty;
+    QHash<QString, Record> records;
+
+    mutable QMutex mutex;
+};
+
+
+void K3b::ExternalBinCache::Private::load()
+{
+    if( loaded )
+        return;
+    loaded = true;
+
+    QFile f( filename );
+    if( !f.open( QIODevice::ReadOnly ) )
+        return;
+
+    QDataStream s( &f );
+    s.setVersion( QDataStream::Qt_5_15 );
+
+    // the parsing of the program output changes between K3b versions
+    quint32 magic, version;
+    QString k3bVersion;
+    s >> magic >> version >> k3bVersion;
+    if( magic != s_magic || version != s_version || k3bVersion != QLatin1String( LIBK3B_VERSION ) ) {
+        qDebug() << "(K3b::ExternalBinCache) ignoring incompatible cache" << filename;
+        return;
+    }
+
+    s >> records;
+    if( s.status() != QDataStream::Ok ) {
+        qDebug() << "(K3b::ExternalBinCache) corrupt cache" << filename;
+        records.clear();
+    }
+}
+
+
+K3b::ExternalBinCache::ExternalBinCache( const QString& filename )
+    : d( new Private() )
+{
+    if( filename.isEmpty() )
+        d->filename = QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) + QLatin1String( "/externalbins" );
+    else
+        d->filename = filename;
+}
+
+
+K3b::ExternalBinCache::~ExternalBinCache()
+{
+    delete d;
+}
+
+
+K3b::ExternalBinCache* K3b::ExternalBinCache::instance()
+{
+    return s_instance();
+}
+
+
+QString K3b::ExternalBinCache::filename() const
+{
+    return d->filename;
+}
+
+
+bool K3b::ExternalBinCache::find( ExternalBin& bin )
+{
+    FileId id;
+    if( !fileId( bin.path(), id ) )
+        return false;
+
+    QMutexLocker locker( &d->mutex );
+    d->load();
+
+    QHash<QString, Record>::const_iterator it = d->records.constFind( recordKey( bin ) );
+    if( it == d->records.constEnd() || !( it->id == id ) )
+        return false;
+
+    bin.setVersion( Version( it->version ) );
+    bin.setCopyright( it->copyright );
+    // only successful probes are cached, see insert()
+    bin.setNeedGroup( "" );
+    Q_FOREACH( const QString& feature, it->features ) {
+        bin.addFeature( feature );
+    }
+    return true;
+}
+
+
+void K3b::ExternalBinCache::insert( const ExternalBin& bin )
+{
+    if( !bin.needGroup().isEmpty() )
+        return;
+
+    Record record;
+    if( !fileId( bin.path(), record.id ) )
+        return;
+
+    if( !bin.isEmpty() ) {
+        record.version = bin.version().toString();
+        record.copyright = bin.copyright();
+        record.features = bin.features();
+    }
+
+    QMutexLocker locker( &d->mutex );
+    d->load();
+    d->records.insert( recordKey( bin ), record );
+    d->dirty = true;
+}
+
+
+void K3b::ExternalBinCache::clear()
+{
+    QMutexLocker locker( &d->mutex );
+    d->loaded = true;
+    d->dirty = true;
+    d->records.clear();
+}
+
+
+int K3b::ExternalBinCache::count() const
+{
+    QMutexLocker locker( &d->mutex );
+    d->load();
+    return d->records.count();
+}
+
+
+bool K3b::ExternalBinCache::save()
+{
+    QMutexLocker locker( &d->mutex );
+
+    for( QHash<QString, Record>::iterator it = d->records.begin(); it != d->records.end(); ) {
+        const QString path = it.key().section( QLatin1Char( ':' ), 1, -1 );
+        if( !QFileInfo::exists( path ) ) {
+            it = d->records.erase( it );
+            d->dirty = true;
+        }
+        else {
+            ++it;
+        }
+    }
+
+    if( !d->dirty )
+        return true;
+
+    QDir().mkpath( QFileInfo( d->filename ).absolutePath() );
+
+    QSaveFile f( d->filename );
+    if( !f.open( QIODevice::WriteOnly ) ) {
+        qDebug() << "(K3b::ExternalBinCache) unable to open" << d->filename;
+        return false;
+    }
+
+    QDataStream s( &f );
+    s.setVersion( QDataStream::Qt_5_15 );
+    s << s_magic << s_version << QString( QLatin1String( LIBK3B_VERSION ) ) << d->records;
+
+    if( s.status() != QDataStream::Ok || !f.commit() ) {
+        qDebug() << "(K3b::ExternalBinCache) failed to write" << d->filename;
+        return false;
+    }
+
+    d->dirty = false;
+    return true;
+}
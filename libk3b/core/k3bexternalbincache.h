@@ -0,0 +1,88 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef _K3B_EXTERNAL_BIN_CACHE_H_
+#define _K3B_EXTERNAL_BIN_CACHE_H_
+
+#include "k3b_export.h"
+
+#include <QString>
+
+
+namespace K3b {
+    class ExternalBin;
+
+    /**
+     * Persistent cache of the probed version and features of external programs.
+     *
+     * Probing a program means running it (typically with --version and --help)
+     * and parsing its output, which adds up to a noticeable delay on startup.
+     * The cache stores the results on disk so only binaries which changed since
+     * the last run need to be probed again.
+     *
+     * Entries are keyed by the program name and the path of the binary and are
+     * only used as long as the inode, size, modification and status change time
+     * of the binary are unchanged. Results of probes which failed due to missing
+     * permissions are never cached since they depend on the user rather than on
+     * the binary.
+     *
+     * All methods are thread-safe.
+     */
+    class LIBK3B_EXPORT ExternalBinCache
+    {
+    public:
+        /**
+         * @param filename The file the cache is stored in. If empty a file
+         *                 in the user's cache location is used.
+         */
+        explicit ExternalBinCache( const QString& filename = QString() );
+        ~ExternalBinCache();
+
+        /**
+         * The cache used by ExternalBinManager::search().
+         */
+        static ExternalBinCache* instance();
+
+        QString filename() const;
+
+        /**
+         * Restore the version, copyright and features of @p bin from the cache.
+         *
+         * \return true if an entry for the current version of the binary exists.
+         *         An empty bin (see ExternalBin::isEmpty()) means the binary
+         *         was found to be unusable before.
+         */
+        bool find( ExternalBin& bin );
+
+        /**
+         * Remember the probed data of @p bin. Insert an empty bin to remember
+         * that the binary is unusable. Bins with a needed group are ignored.
+         */
+        void insert( const ExternalBin& bin );
+
+        /**
+         * Drop all entries. This does not touch the file on disk until the
+         * next save().
+         */
+        void clear();
+
+        int count() const;
+
+        /**
+         * Write the cache to disk if it has been changed since it was loaded
+         * or saved the last time. Entries for binaries which do not exist
+         * anymore are dropped.
+         */
+        bool save();
+
+    private:
+        class Private;
+        Private* const d;
+
+        Q_DISABLE_COPY( ExternalBinCache )
+    };
+}
+
+#endif
@@ -7,6 +7,7 @@
 */
 
 #include "k3bexternalbinmanager.h"
+#include "k3bexternalbincache.h"
 #include "k3bglobals.h"
 
 #include <KConfigGroup>
@@ -18,12 +19,15 @@
 #include <QFile>
 #include <QtGlobal>
 #include <QRegularExpression>
+#include <QThread>
+#include <QThreadPool>
 
 #ifndef Q_OS_WIN32
 #include <unistd.h>
 #include <sys/stat.h>
 #include <stdlib.h>
 #include <grp.h>
+#include <errno.h>
 #endif
 
 
@@ -34,6 +38,32 @@ namespace {
     }
 
     const int EXECUTE_TIMEOUT = 5000; // in seconds
+
+    /**
+     * The name of group @p gid or an empty string. Uses getgrgid_r() since
+     * the programs are scanned in parallel.
+     */
+    QString groupName( gid_t gid )
+    {
+        long bufSize = ::sysconf( _SC_GETGR_R_SIZE_MAX );
+        if( bufSize <= 0 )
+            bufSize = 1024;
+
+        QByteArray buf;
+        struct group grp;
+        struct group* result = 0;
+        int err = 0;
+        do {
+            buf.resize( bufSize );
+            err = ::getgrgid_r( gid, &grp, buf.data(), buf.size(), &result );
+            bufSize *= 2;
+        } while( err == ERANGE && bufSize <= 1024*1024 );
+
+        if( err == 0 && result )
+            return QString::fromLocal8Bit( result->gr_name );
+        else
+            return QString();
+    }
 }
 
 
@@ -340,11 +370,22 @@ bool K3b::SimpleExternalProgram::scan( const QString& p )
     if ( QFile::exists( path ) ) {
         K3b::ExternalBin* bin = new ExternalBin( *this, path );
 
+        if ( ExternalBinCache::instance()->find( *bin ) ) {
+            if ( bin->isEmpty() ) {
+                delete bin;
+                return false;
+            }
+            addBin( bin );
+            return true;
+        }
+
         if ( ( !scanVersion( *bin ) || !scanFeatures( *bin ) ) && bin->needGroup().isEmpty() )  {
+            // not cached: the probe might just have timed out
             delete bin;
             return false;
         }
 
+        ExternalBinCache::instance()->insert( *bin );
         addBin( bin );
         return true;
     }
@@ -367,7 +408,7 @@ bool K3b::SimpleExternalProgram::scanVersion( ExternalBin& bin ) const
             // K3b::SystemProblemDialog::checkSystem work
             struct stat st;
             if( !::stat( QFile::encodeName(bin.path()), &st ) ) {
-                QString group( getgrgid( st.st_gid )->gr_name );
+                const QString group = groupName( st.st_gid );
                 qDebug() << "Should be member of \"" << group << "\"";
                 bin.setNeedGroup( group.isEmpty() ? "N/A" : group );
             } else
@@ -633,11 +674,20 @@ void K3b::ExternalBinManager::search()
             paths.append(p);
     }
 
-    Q_FOREACH( const QString& path, paths ) {
-        Q_FOREACH( K3b::ExternalProgram* program, d->programs ) {
-            program->scan( path );
-        }
+    // Probing means running the programs and waiting for them. Each program scans the
+    // paths in order in its own task so its bins are never touched concurrently.
+    QThreadPool pool;
+    pool.setMaxThreadCount( qMax( 4, QThread::idealThreadCount() ) );
+    Q_FOREACH( K3b::ExternalProgram* program, d->programs ) {
+        pool.start( [program, paths]() {
+            Q_FOREACH( const QString& path, paths ) {
+                program->scan( path );
+            }
+        } );
     }
+    pool.waitForDone();
+
+    ExternalBinCache::instance()->save();
 }
 
 
@@ -93,6 +93,10 @@ namespace K3b {
          * this scans for the program in the given path,
          * adds the found bin object to the list and returns true.
          * if nothing could be found false is returned.
+         *
+         * ExternalBinManager::search() scans different programs
+         * concurrently. Implementations should use ExternalBinCache
+         * to avoid running the program on every startup.
          */
         virtual bool scan( const QString& ) = 0;
 
@@ -124,6 +128,10 @@ namespace K3b {
         explicit SimpleExternalProgram( const QString& name );
         ~SimpleExternalProgram() override;
 
+        /**
+         * Probes the binary via scanVersion() and scanFeatures() unless
+         * ExternalBinCache already knows about it.
+         */
         bool scan( const QString& path ) override;
 
         /**
@@ -191,6 +199,11 @@ namespace K3b {
         explicit ExternalBinManager( QObject* parent = 0 );
         ~ExternalBinManager() override;
 
+        /**
+         * Search all programs in the search path and in $PATH. Only binaries
+         * which are not yet known to ExternalBinCache are actually probed,
+         * the programs are scanned in parallel.
+         */
         void search();
 
         /**
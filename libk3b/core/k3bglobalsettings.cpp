@@ -18,7 +18,10 @@ K3b::GlobalSettings::GlobalSettings()
       m_overburn(false),
       m_useManualBufferSize(false),
       m_bufferSize(4),
-      m_force(false)
+      m_pipeBufferSize(4),
+      m_force(false),
+      m_useAudioRipCache(false),
+      m_audioRipCacheSize(4)
 {
 }
 
@@ -35,7 +38,10 @@ void K3b::GlobalSettings::readSettings( const KConfigGroup& c )
     m_overburn = c.readEntry( "Allow overburning", false );
     m_useManualBufferSize = c.readEntry( "Manual buffer size", false );
     m_bufferSize = c.readEntry( "Fifo buffer", 4 );
+    m_pipeBufferSize = qMax( 1, c.readEntry( "Pipe buffer", 4 ) );
     m_force = c.readEntry( "Force unsafe operations", false );
+    m_useAudioRipCache = c.readEntry( "Audio rip cache", false );
+    m_audioRipCacheSize = qMax( 1, c.readEntry( "Audio rip cache size", 4 ) );
 	m_defaultTempPath = c.readPathEntry("Temp Dir",
             QStandardPaths::writableLocation(QStandardPaths::MoviesLocation));
     QFileInfo checkPath(m_defaultTempPath);
@@ -53,6 +59,9 @@ void K3b::GlobalSettings::saveSettings( KConfigGroup c )
     c.writeEntry( "Allow overburning", m_overburn );
     c.writeEntry( "Manual buffer size", m_useManualBufferSize );
     c.writeEntry( "Fifo buffer", m_bufferSize );
+    c.writeEntry( "Pipe buffer", m_pipeBufferSize );
     c.writeEntry( "Force unsafe operations", m_force );
+    c.writeEntry( "Audio rip cache", m_useAudioRipCache );
+    c.writeEntry( "Audio rip cache size", m_audioRipCacheSize );
     c.writeEntry( "Temp Dir", m_defaultTempPath );
 }
@@ -40,6 +40,13 @@ namespace K3b {
         bool useManualBufferSize() const { return m_useManualBufferSize; }
         int bufferSize() const { return m_bufferSize; }
 
+        /**
+         * The size in MB of the buffer K3b uses between reading and writing
+         * when it pumps data itself, for example from mkisofs to the
+         * writing application.
+         */
+        int pipeBufferSize() const { return m_pipeBufferSize; }
+
         /**
          * If force is set to true K3b will continue in certain "unsafe" situations.
          * The most common being a medium not suitable for the writer in terms of
@@ -53,13 +60,27 @@ namespace K3b {
          */
         QString defaultTempPath() const { return m_defaultTempPath; }
 
+        /**
+         * If enabled audio tracks read from CDs are kept in the AudioRipCache
+         * so they do not need to be read from the disc again.
+         */
+        bool useAudioRipCache() const { return m_useAudioRipCache; }
+
+        /**
+         * The maximum size of the audio rip cache in GB.
+         */
+        int audioRipCacheSize() const { return m_audioRipCacheSize; }
+
         void setEjectMedia( bool b ) { m_eject = b; }
         void setBurnfree( bool b ) { m_burnfree = b; }
         void setOverburn( bool b ) { m_overburn = b; }
         void setUseManualBufferSize( bool b ) { m_useManualBufferSize = b; }
         void setBufferSize( int size ) { m_bufferSize = size; }
+        void setPipeBufferSize( int size ) { m_pipeBufferSize = size; }
         void setForce( bool b ) { m_force = b; }
         void setDefaultTempPath( const QString& s ) { m_defaultTempPath = s; }
+        void setUseAudioRipCache( bool b ) { m_useAudioRipCache = b; }
+        void setAudioRipCacheSize( int size ) { m_audioRipCacheSize = size; }
 
     private:
         // FIXME: d-pointer
@@ -68,8 +89,11 @@ namespace K3b {
         bool m_overburn;
         bool m_useManualBufferSize;
         int m_bufferSize;
+        int m_pipeBufferSize;
         bool m_force;
         QString m_defaultTempPath;
+        bool m_useAudioRipCache;
+        int m_audioRipCacheSize;
     };
 }
 
@@ -14,13 +14,116 @@
 
 #include <QDebug>
 #include <QFile>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QQueue>
+#include <QThread>
+#include <QWaitCondition>
 
 #include <unistd.h>
 
 
 
-// FIXME: determine max DMA buffer size
-static int s_bufferSizeSectors = 10;
+// the number of blocks the reading thread may get ahead of the writing
+static const int s_readAheadBlocks = 4;
+
+
+namespace {
+    /**
+     * Hands the blocks read from the drive to the writing side. The drive
+     * is read in a dedicated thread which only waits if all blocks are
+     * filled. Thus, the drive keeps streaming while the previous block is
+     * written.
+     */
+    class ReadAheadQueue
+    {
+    public:
+        struct Block {
+            unsigned char* data;
+            int sectors; // -1 on a read error
+        };
+
+        ReadAheadQueue( int blockCount, int blockSize )
+            : m_finished( false ),
+              m_stopped( false ) {
+            for( int i = 0; i < blockCount; ++i ) {
+                Block* block = new Block;
+                block->data = new unsigned char[blockSize];
+                block->sectors = 0;
+                m_blocks.append( block );
+                m_free.enqueue( block );
+            }
+        }
+
+        ~ReadAheadQueue() {
+            Q_FOREACH( Block* block, m_blocks ) {
+                delete [] block->data;
+                delete block;
+            }
+        }
+
+        /**
+         * Used by the reading side. \return 0 if the writing side stopped.
+         */
+        Block* takeFree() {
+            QMutexLocker locker( &m_mutex );
+            while( m_free.isEmpty() && !m_stopped )
+                m_condition.wait( &m_mutex );
+            return m_stopped ? 0 : m_free.dequeue();
+        }
+
+        void putFilled( Block* block ) {
+            QMutexLocker locker( &m_mutex );
+            m_filled.enqueue( block );
+            m_condition.wakeAll();
+        }
+
+        /**
+         * To be called by the reading side once it is done.
+         */
+        void finish() {
+            QMutexLocker locker( &m_mutex );
+            m_finished = true;
+            m_condition.wakeAll();
+        }
+
+        /**
+         * Used by the writing side. \return 0 once all blocks have been taken
+         * after finish().
+         */
+        Block* takeFilled() {
+            QMutexLocker locker( &m_mutex );
+            while( m_filled.isEmpty() && !m_finished )
+                m_condition.wait( &m_mutex );
+            return m_filled.isEmpty() ? 0 : m_filled.dequeue();
+        }
+
+        void putFree( Block* block ) {
+            QMutexLocker locker( &m_mutex );
+            m_free.enqueue( block );
+            m_condition.wakeAll();
+        }
+
+        /**
+         * To be called by the writing side if it gives up early.
+         */
+        void stop() {
+            QMutexLocker locker( &m_mutex );
+            m_stopped = true;
+            m_condition.wakeAll();
+        }
+
+    private:
+        QList<Block*> m_blocks;
+        QQueue<Block*> m_free;
+        QQueue<Block*> m_filled;
+        bool m_finished;
+        bool m_stopped;
+        QMutex m_mutex;
+        QWaitCondition m_condition;
+    };
+}
 
 
 class K3b::DataTrackReader::Private
@@ -245,57 +348,67 @@ bool K3b::DataTrackReader::run()
     //
     d->device->setSpeed( 0xffff, 0xffff );
 
-#ifdef Q_OS_NETBSD
-    s_bufferSizeSectors = 31;
-#else
-    s_bufferSizeSectors = 128;
-#endif
-    unsigned char* buffer = new unsigned char[d->usedSectorSize*s_bufferSizeSectors];
-    while( s_bufferSizeSectors > 0 && read( buffer, d->firstSector.lba(), s_bufferSizeSectors ) < 0 ) {
-        qDebug() << "(K3b::DataTrackReader) determine max read sectors: "
-                 << s_bufferSizeSectors << " too high." << Qt::endl;
-        s_bufferSizeSectors /= 2;
-    }
-    qDebug() << "(K3b::DataTrackReader) determine max read sectors: "
-             << s_bufferSizeSectors << " is max." << Qt::endl;
-
-    //    s_bufferSizeSectors = K3b::Device::determineMaxReadingBufferSize( d->device, d->firstSector );
-    if( s_bufferSizeSectors <= 0 ) {
-        emit infoMessage( i18n("Error while reading sector %1.",d->firstSector.lba()), K3b::Job::MessageError );
-        d->device->block( false );
-        k3bcore->unblockDevice( d->device );
-        return false;
-    }
+    //
+    // Read as much as the device can transfer with one command
+    //
+    int bufferSizeSectors = qMax( d->device->maxTransferLength() / d->usedSectorSize, 1 );
 
-    qDebug() << "(K3b::DataTrackReader) using buffer size of " << s_bufferSizeSectors << " blocks.";
-    emit debuggingOutput( "K3b::DataTrackReader", QString("using buffer size of %1 blocks.").arg( s_bufferSizeSectors ) );
+    qDebug() << "(K3b::DataTrackReader) using buffer size of " << bufferSizeSectors << " blocks.";
+    emit debuggingOutput( "K3b::DataTrackReader", QString("using buffer size of %1 blocks.").arg( bufferSizeSectors ) );
 
     // 2. get it on
-    K3b::Msf currentSector = d->firstSector;
-    K3b::Msf totalReadSectors;
     d->nextReadSector = 0;
     d->errorSectorCount = 0;
+    int bufferLen = bufferSizeSectors*d->usedSectorSize;
+    ReadAheadQueue queue( s_readAheadBlocks, bufferLen );
+
+    //
+    // The drive is read in a separate thread while this thread writes the data.
+    //
+    QThread* readThread = QThread::create( [this, &queue, bufferLen]() {
+        K3b::Msf sector = d->firstSector;
+        while( !canceled() && sector <= d->lastSector ) {
+            ReadAheadQueue::Block* block = queue.takeFree();
+            if( !block )
+                break;
+
+            int maxReadSectors = qMin( bufferLen/d->usedSectorSize, d->lastSector.lba()-sector.lba()+1 );
+
+            int readSectors = read( block->data,
+                                    sector.lba(),
+                                    maxReadSectors );
+            if( readSectors < 0 ) {
+                if( retryRead( block->data,
+                               sector.lba(),
+                               maxReadSectors ) )
+                    readSectors = maxReadSectors;
+            }
+
+            block->sectors = readSectors;
+            queue.putFilled( block );
+            if( readSectors < 0 )
+                break;
+
+            sector += readSectors;
+        }
+        queue.finish();
+    } );
+    readThread->start();
+
+    K3b::Msf currentSector = d->firstSector;
+    K3b::Msf totalReadSectors;
     bool writeError = false;
     bool readError = false;
     int lastPercent = 0;
     unsigned long lastReadMb = 0;
-    int bufferLen = s_bufferSizeSectors*d->usedSectorSize;
-    while( !canceled() && currentSector <= d->lastSector ) {
-
-        int maxReadSectors = qMin( bufferLen/d->usedSectorSize, d->lastSector.lba()-currentSector.lba()+1 );
+    ReadAheadQueue::Block* block = 0;
+    while( !canceled() && ( block = queue.takeFilled() ) ) {
 
-        int readSectors = read( buffer,
-                                currentSector.lba(),
-                                maxReadSectors );
+        int readSectors = block->sectors;
         if( readSectors < 0 ) {
-            if( !retryRead( buffer,
-                            currentSector.lba(),
-                            maxReadSectors ) ) {
-                readError = true;
-                break;
-            }
-            else
-                readSectors = maxReadSectors;
+            queue.putFree( block );
+            readError = true;
+            break;
         }
 
         totalReadSectors += readSectors;
@@ -303,28 +416,30 @@ bool K3b::DataTrackReader::run()
         int readBytes = readSectors * d->usedSectorSize;
 
         if( d->ioDevice ) {
-            if( d->ioDevice->write( reinterpret_cast<char*>(buffer ), readBytes ) != readBytes ) {
+            if( d->ioDevice->write( reinterpret_cast<char*>( block->data ), readBytes ) != readBytes ) {
                 qDebug() << "(K3b::DataTrackReader::WorkThread) error while writing to dev " << d->ioDevice
                          << " current sector: " << (currentSector.lba()-d->firstSector.lba()) << Qt::endl;
                 emit debuggingOutput( "K3b::DataTrackReader",
                                       QString("Error while writing to IO device. Current sector is %2.")
                                       .arg(currentSector.lba()-d->firstSector.lba()) );
                 writeError = true;
-                break;
             }
         }
         else {
-            if( file.write( reinterpret_cast<char*>(buffer), readBytes ) != readBytes ) {
+            if( file.write( reinterpret_cast<char*>( block->data ), readBytes ) != readBytes ) {
                 qDebug() << "(K3b::DataTrackReader::WorkThread) error while writing to file " << d->imagePath
                          << " current sector: " << (currentSector.lba()-d->firstSector.lba()) << Qt::endl;
                 emit debuggingOutput( "K3b::DataTrackReader",
                                       QString("Error while writing to file %1. Current sector is %2.")
                                       .arg(d->imagePath).arg(currentSector.lba()-d->firstSector.lba()) );
                 writeError = true;
-                break;
             }
         }
 
+        queue.putFree( block );
+        if( writeError )
+            break;
+
         currentSector += readSectors;
 
         int currentPercent = 100 * (currentSector.lba() - d->firstSector.lba() + 1 ) /
@@ -342,6 +457,11 @@ bool K3b::DataTrackReader::run()
         }
     }
 
+    // make sure the reading thread does not wait for free blocks anymore
+    queue.stop();
+    readThread->wait();
+    delete readThread;
+
     if( d->errorSectorCount > 0 )
         emit infoMessage( i18np("Ignored %1 erroneous sector.", "Ignored a total of %1 erroneous sectors.", d->errorSectorCount ),
                           K3b::Job::MessageError );
@@ -356,7 +476,6 @@ bool K3b::DataTrackReader::run()
     if( d->useLibdvdcss )
         d->libcss->close();
     d->device->close();
-    delete [] buffer;
 
     emit debuggingOutput( "K3b::DataTrackReader",
                           QString("Read a total of %1 sectors (%2 bytes)")
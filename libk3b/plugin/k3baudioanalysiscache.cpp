@@ -0,0 +1,269 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3baudioanalysiscache.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QVector>
+
+#include <algorithm>
+
+
+namespace {
+    const quint32 s_magic = 0x4b334141; // "K3AA"
+    const quint32 s_version = 1;
+
+    // Entries not used for the longest time are dropped beyond this count
+    const int s_maxEntries = 20000;
+
+    struct Record {
+        Record()
+            : size( 0 ),
+              modified( 0 ),
+              lastUsed( 0 ) {
+        }
+
+        QString decoderType;
+        qint64 size;
+        qint64 modified;
+        quint64 lastUsed;
+        K3b::AudioAnalysisCache::Entry entry;
+    };
+
+    QDataStream& operator<<( QDataStream& s, const Record& r )
+    {
+        return s << r.decoderType << r.size << r.modified << r.lastUsed
+                 << qint32( r.entry.length.totalFrames() )
+                 << qint32( r.entry.samplerate )
+                 << qint32( r.entry.channels )
+                 << r.entry.metaInfo
+                 << r.entry.decoderData;
+    }
+
+    QDataStream& operator>>( QDataStream& s, Record& r )
+    {
+        qint32 length, samplerate, channels;
+        s >> r.decoderType >> r.size >> r.modified >> r.lastUsed
+          >> length >> samplerate >> channels
+          >> r.entry.metaInfo
+          >> r.entry.decoderData;
+        r.entry.length = length;
+        r.entry.samplerate = samplerate;
+        r.entry.channels = channels;
+        return s;
+    }
+
+    Q_GLOBAL_STATIC( K3b::AudioAnalysisCache, s_instance )
+}
+
+
+class K3b::AudioAnalysisCache::Private
+{
+public:
+    Private()
+        : loaded( false ),
+          dirty( false ),
+          usageCounter( 0 ) {
+    }
+
+    void load();
+
+    QString filename;
+    bool loaded;
+    bool dirty;
+    quint64 usageCounter;
+    QHash<QString, Record> records;
+
+    mutable QMutex mutex;
+};
+
+
+void K3b::AudioAnalysisCache::Private::load()
+{
+    if( loaded )
+        return;
+    loaded = true;
+
+    QFile f( filename );
+    if( !f.open( QIODevice::ReadOnly ) )
+        return;
+
+    QDataStream s( &f );
+    s.setVersion( QDataStream::Qt_5_15 );
+
+    quint32 magic, version;
+    s >> magic >> version;
+    if( magic != s_magic || version != s_version ) {
+        qDebug() << "(K3b::AudioAnalysisCache) ignoring incompatible cache" << filename;
+        return;
+    }
+
+    qint32 count;
+    s >> count;
+    for( qint32 i = 0; i < count && s.status() == QDataStream::Ok; ++i ) {
+        QString path;
+        Record record;
+        s >> path >> record;
+        if( s.status() == QDataStream::Ok ) {
+            records.insert( path, record );
+            usageCounter = qMax( usageCounter, record.lastUsed );
+        }
+    }
+
+    if( s.status() != QDataStream::Ok ) {
+        qDebug() << "(K3b::AudioAnalysisCache) corrupt cache" << filename;
+        records.clear();
+        usageCounter = 0;
+    }
+}
+
+
+K3b::AudioAnalysisCache::AudioAnalysisCache( const QString& filename )
+    : d( new Private() )
+{
+    if( filename.isEmpty() )
+        d->filename = QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) + QLatin1String( "/audioanalysis" );
+    else
+        d->filename = filename;
+}
+
+
+K3b::AudioAnalysisCache::~AudioAnalysisCache()
+{
+    delete d;
+}
+
+
+K3b::AudioAnalysisCache* K3b::AudioAnalysisCache::instance()
+{
+    return s_instance();
+}
+
+
+QString K3b::AudioAnalysisCache::filename() const
+{
+    return d->filename;
+}
+
+
+bool K3b::AudioAnalysisCache::find( const QString& decoderType, const QString& path, Entry& entry )
+{
+    QFileInfo fi( path );
+    if( !fi.isFile() )
+        return false;
+
+    QMutexLocker locker( &d->mutex );
+    d->load();
+
+    QHash<QString, Record>::iterator it = d->records.find( path );
+    if( it == d->records.end() ||
+        it->decoderType != decoderType ||
+        it->size != fi.size() ||
+        it->modified != fi.lastModified().toMSecsSinceEpoch() )
+        return false;
+
+    // only remember the usage, this is no reason to save the cache
+    it->lastUsed = ++d->usageCounter;
+    entry = it->entry;
+    return true;
+}
+
+
+void K3b::AudioAnalysisCache::insert( const QString& decoderType, const QString& path, const Entry& entry )
+{
+    QFileInfo fi( path );
+    if( !fi.isFile() )
+        return;
+
+    Record record;
+    record.decoderType = decoderType;
+    record.size = fi.size();
+    record.modified = fi.lastModified().toMSecsSinceEpoch();
+    record.entry = entry;
+
+    QMutexLocker locker( &d->mutex );
+    d->load();
+
+    record.lastUsed = ++d->usageCounter;
+    d->records.insert( path, record );
+    d->dirty = true;
+}
+
+
+void K3b::AudioAnalysisCache::clear()
+{
+    QMutexLocker locker( &d->mutex );
+    d->loaded = true;
+    d->dirty = true;
+    d->records.clear();
+    d->usageCounter = 0;
+}
+
+
+int K3b::AudioAnalysisCache::count() const
+{
+    QMutexLocker locker( &d->mutex );
+    d->load();
+    return d->records.count();
+}
+
+
+bool K3b::AudioAnalysisCache::save()
+{
+    QMutexLocker locker( &d->mutex );
+
+    if( !d->dirty )
+        return true;
+
+    if( d->records.count() > s_maxEntries ) {
+        QVector<quint64> usage;
+        usage.reserve( d->records.count() );
+        for( QHash<QString, Record>::const_iterator it = d->records.constBegin();
+             it != d->records.constEnd(); ++it )
+            usage.append( it->lastUsed );
+        std::nth_element( usage.begin(), usage.end() - s_maxEntries, usage.end() );
+        const quint64 minUsage = *( usage.end() - s_maxEntries );
+
+        for( QHash<QString, Record>::iterator it = d->records.begin(); it != d->records.end(); ) {
+            if( it->lastUsed < minUsage )
+                it = d->records.erase( it );
+            else
+                ++it;
+        }
+    }
+
+    QDir().mkpath( QFileInfo( d->filename ).absolutePath() );
+
+    QSaveFile f( d->filename );
+    if( !f.open( QIODevice::WriteOnly ) ) {
+        qDebug() << "(K3b::AudioAnalysisCache) unable to open" << d->filename;
+        return false;
+    }
+
+    QDataStream s( &f );
+    s.setVersion( QDataStream::Qt_5_15 );
+    s << s_magic << s_version << qint32( d->records.count() );
+    for( QHash<QString, Record>::const_iterator it = d->records.constBegin();
+         it != d->records.constEnd(); ++it )
+        s << it.key() << it.value();
+
+    if( s.status() != QDataStream::Ok || !f.commit() ) {
+        qDebug() << "(K3b::AudioAnalysisCache) failed to write" << d->filename;
+        return false;
+    }
+
+    d->dirty = false;
+    return true;
+}
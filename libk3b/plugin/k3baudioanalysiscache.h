@@ -0,0 +1,106 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef _K3B_AUDIO_ANALYSIS_CACHE_H_
+#define _K3B_AUDIO_ANALYSIS_CACHE_H_
+
+#include "k3bmsf.h"
+#include "k3b_export.h"
+
+#include <QByteArray>
+#include <QMap>
+#include <QString>
+
+
+namespace K3b {
+    /**
+     * Persistent cache of the results of AudioDecoder::analyseFile().
+     *
+     * Analysing a file may require to read all of it (for example to count
+     * the frames of a MP3 file). The cache stores the results of the analysis
+     * on disk so adding the same files again does not require another scan.
+     *
+     * Entries are keyed by the local path of the file and are only used as
+     * long as the size and modification time of the file are unchanged and
+     * the same decoder type is used.
+     *
+     * All methods are thread-safe.
+     */
+    class LIBK3B_EXPORT AudioAnalysisCache
+    {
+    public:
+        struct Entry {
+            Entry()
+                : samplerate( 0 ),
+                  channels( 0 ) {
+            }
+
+            Msf length;
+            int samplerate;
+            int channels;
+
+            /**
+             * The meta data of the file, indexed by AudioDecoder::MetaDataField.
+             */
+            QMap<int, QString> metaInfo;
+
+            /**
+             * Decoder specific data as returned by AudioDecoder::analysisData().
+             */
+            QByteArray decoderData;
+        };
+
+        /**
+         * @param filename The file the cache is stored in. If empty a file
+         *                 in the user's cache location is used.
+         */
+        explicit AudioAnalysisCache( const QString& filename = QString() );
+        ~AudioAnalysisCache();
+
+        /**
+         * The cache used by AudioDecoder.
+         */
+        static AudioAnalysisCache* instance();
+
+        QString filename() const;
+
+        /**
+         * Search the cached analysis of @p path.
+         *
+         * \return true if an entry for @p path exists which was created by
+         *         a decoder of type @p decoderType for the current version of
+         *         the file.
+         */
+        bool find( const QString& decoderType, const QString& path, Entry& entry );
+
+        /**
+         * Remember the analysis of @p path. The entry is tagged with the
+         * current size and modification time of the file.
+         */
+        void insert( const QString& decoderType, const QString& path, const Entry& entry );
+
+        /**
+         * Drop all entries. This does not touch the file on disk until the
+         * next save().
+         */
+        void clear();
+
+        int count() const;
+
+        /**
+         * Write the cache to disk if it has been changed since it was loaded
+         * or saved the last time.
+         */
+        bool save();
+
+    private:
+        class Private;
+        Private* const d;
+
+        Q_DISABLE_COPY( AudioAnalysisCache )
+    };
+}
+
+#endif
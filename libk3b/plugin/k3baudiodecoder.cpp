@@ -6,6 +6,8 @@
 
 #include "k3bcore.h"
 #include "k3baudiodecoder.h"
+#include "k3baudioanalysiscache.h"
+#include "k3bpcmconversion.h"
 #include "k3bpluginmanager.h"
 #include "k3b_i18n.h"
 
@@ -15,6 +17,7 @@
 #include <KFileMetaData/Properties>
 
 #include <QDebug>
+#include <QFile>
 #include <QMap>
 #include <QMimeDatabase>
 #include <QMimeType>
@@ -23,14 +26,13 @@
 
 #include <samplerate.h>
 
-#if !(HAVE_LRINT && HAVE_LRINTF)
-#define lrint(dbl)              ((int) (dbl+0.5))
-#define lrintf(flt)             ((int) (flt+0.5))
-#endif
 
 // use a one second buffer
 static const int DECODING_BUFFER_SIZE = 75*2352;
 
+// the number of bytes passed to AudioDecoderFactory::checkSignature
+static const int SIGNATURE_SIZE = 4096;
+
 namespace
 {
 
@@ -75,6 +77,14 @@ private:
     MetaInfoMap& metaInfoMap_;
 };
 
+
+void setMetaInfoMap( const QMap<int, QString>& cached, MetaInfoMap& metaInfoMap )
+{
+    metaInfoMap.clear();
+    for( QMap<int, QString>::const_iterator it = cached.constBegin(); it != cached.constEnd(); ++it )
+        metaInfoMap.insert( static_cast<K3b::AudioDecoder::MetaDataField>( it.key() ), it.value() );
+}
+
 } // namespace
 
 class K3b::AudioDecoder::Private
@@ -91,6 +101,7 @@ public:
           monoBuffer(0),
           decodingBufferPos(0),
           decodingBufferFill(0),
+          metaInfoCollected(false),
           valid(true) {
     }
 
@@ -139,6 +150,9 @@ public:
     QMap<QString, QString> technicalInfoMap;
     MetaInfoMap metaInfoMap;
 
+    // true if metaInfoMap holds all meta data of the file
+    bool metaInfoCollected;
+
     bool valid;
 };
 
@@ -185,11 +199,46 @@ bool K3b::AudioDecoder::analyseFile()
 {
     d->technicalInfoMap.clear();
     d->metaInfoMap.clear();
+    d->metaInfoCollected = false;
     d->mimeType = QMimeType();
 
     cleanup();
 
-    bool ret = analyseFileInternal( m_length, d->samplerate, d->channels );
+    const QString decoderType = QString::fromLatin1( metaObject()->className() );
+    K3b::AudioAnalysisCache* cache = K3b::AudioAnalysisCache::instance();
+    K3b::AudioAnalysisCache::Entry entry;
+
+    bool ret = false;
+    if( cache->find( decoderType, m_fileName, entry ) && restoreAnalysisData( entry.decoderData ) ) {
+        m_length = entry.length;
+        d->samplerate = entry.samplerate;
+        d->channels = entry.channels;
+        setMetaInfoMap( entry.metaInfo, d->metaInfoMap );
+        d->metaInfoCollected = true;
+        ret = true;
+    }
+    else {
+        ret = analyseFileInternal( m_length, d->samplerate, d->channels );
+        if( ret ) {
+            entry.decoderData = analysisData();
+            if( !entry.decoderData.isNull() ) {
+                entry.length = m_length;
+                entry.samplerate = d->samplerate;
+                entry.channels = d->channels;
+                for( int f = META_TITLE; f <= META_COMMENT; ++f ) {
+                    QString value = metaInfo( static_cast<MetaDataField>( f ) );
+                    if( !value.isEmpty() )
+                        entry.metaInfo.insert( f, value );
+                }
+                cache->insert( decoderType, m_fileName, entry );
+
+                // no need to ask the decoder again
+                setMetaInfoMap( entry.metaInfo, d->metaInfoMap );
+                d->metaInfoCollected = true;
+            }
+        }
+    }
+
     if( ret && ( d->channels == 1 || d->channels == 2 ) && m_length > 0 ) {
         d->valid = initDecoder();
         return d->valid;
@@ -201,6 +250,28 @@ bool K3b::AudioDecoder::analyseFile()
 }
 
 
+void K3b::AudioDecoder::updateAnalysisCache()
+{
+    // only decoders supporting the cache collect the meta data
+    if( !d->valid || !d->metaInfoCollected )
+        return;
+
+    K3b::AudioAnalysisCache::Entry entry;
+    entry.decoderData = analysisData();
+    if( entry.decoderData.isNull() )
+        return;
+
+    entry.length = m_length;
+    entry.samplerate = d->samplerate;
+    entry.channels = d->channels;
+    for( MetaInfoMap::const_iterator it = d->metaInfoMap.constBegin(); it != d->metaInfoMap.constEnd(); ++it )
+        entry.metaInfo.insert( it.key(), it.value() );
+
+    K3b::AudioAnalysisCache* cache = K3b::AudioAnalysisCache::instance();
+    cache->insert( QString::fromLatin1( metaObject()->className() ), m_fileName, entry );
+}
+
+
 bool K3b::AudioDecoder::initDecoder( const K3b::Msf& startOffset )
 {
     if( initDecoder() ) {
@@ -286,10 +357,7 @@ int K3b::AudioDecoder::decode( char* _data, int maxLen )
                 if( (read = decodeInternal( d->monoBuffer, DECODING_BUFFER_SIZE/2 )) == 0 )
                     d->decoderFinished = true;
 
-                for( int i = 0; i < read; i+=2 ) {
-                    d->decodingBuffer[2*i] = d->decodingBuffer[2*i+2] = d->monoBuffer[i];
-                    d->decodingBuffer[2*i+1] = d->decodingBuffer[2*i+3] = d->monoBuffer[i+1];
-                }
+                K3b::PcmConversion::monoToStereo16( d->monoBuffer, d->decodingBuffer, read/2 );
 
                 read *= 2;
             }
@@ -389,10 +457,12 @@ int K3b::AudioDecoder::resample( char* data, int maxLen )
     if( d->channels == 2 )
         fromFloatTo16BitBeSigned( d->outBuffer, data, d->resampleData->output_frames_gen*d->channels );
     else {
-        for( int i = 0; i < d->resampleData->output_frames_gen; ++i ) {
-            fromFloatTo16BitBeSigned( &d->outBuffer[i], &data[4*i], 1 );
-            fromFloatTo16BitBeSigned( &d->outBuffer[i], &data[4*i+2], 1 );
+        // convert to mono 16 bit first and duplicate the frames afterwards
+        if( !d->monoBuffer ) {
+            d->monoBuffer = new char[DECODING_BUFFER_SIZE/2];
         }
+        K3b::PcmConversion::floatToBigEndian16( d->outBuffer, d->monoBuffer, d->resampleData->output_frames_gen );
+        K3b::PcmConversion::monoToStereo16( d->monoBuffer, data, d->resampleData->output_frames_gen );
     }
 
     d->inBufferPos += d->resampleData->input_frames_used*d->channels;
@@ -410,54 +480,19 @@ int K3b::AudioDecoder::resample( char* data, int maxLen )
 
 void K3b::AudioDecoder::from16bitBeSignedToFloat( char* src, float* dest, int samples )
 {
-    while( samples ) {
-        samples--;
-        dest[samples] = static_cast<float>( qint16(((src[2*samples]<<8)&0xff00)|(src[2*samples+1]&0x00ff)) / 32768.0 );
-    }
+    K3b::PcmConversion::bigEndian16ToFloat( src, dest, samples );
 }
 
 
 void K3b::AudioDecoder::fromFloatTo16BitBeSigned( float* src, char* dest, int samples )
 {
-    while( samples ) {
-        samples--;
-
-        float scaled = src[samples] * 32768.0;
-        qint16 val = 0;
-
-        // clipping
-        if( scaled >= ( 1.0 * 0x7FFF ) )
-            val = 32767;
-        else if( scaled <= ( -8.0 * 0x1000 ) )
-            val = -32768;
-        else
-            val = lrintf(scaled);
-
-        dest[2*samples]   = val>>8;
-        dest[2*samples+1] = val;
-    }
+    K3b::PcmConversion::floatToBigEndian16( src, dest, samples );
 }
 
 
 void K3b::AudioDecoder::from8BitTo16BitBeSigned( char* src, char* dest, int samples )
 {
-    while( samples ) {
-        samples--;
-
-        float scaled = static_cast<float>(quint8(src[samples])-128) / 128.0 * 32768.0;
-        qint16 val = 0;
-
-        // clipping
-        if( scaled >= ( 1.0 * 0x7FFF ) )
-            val = 32767;
-        else if( scaled <= ( -8.0 * 0x1000 ) )
-            val = -32768;
-        else
-            val = lrintf(scaled);
-
-        dest[2*samples]   = val>>8;
-        dest[2*samples+1] = val;
-    }
+    K3b::PcmConversion::unsigned8ToBigEndian16( src, dest, samples );
 }
 
 
@@ -545,8 +580,8 @@ void K3b::AudioDecoder::cleanup()
 
 QString K3b::AudioDecoder::metaInfo( MetaDataField f )
 {
-    if( d->metaInfoMap.contains( f ) )
-        return d->metaInfoMap[f];
+    if( d->metaInfoMap.contains( f ) || d->metaInfoCollected )
+        return d->metaInfoMap.value( f );
 
     // fall back to KFileMetaData
     if( !d->mimeType.isValid() )
@@ -568,6 +603,12 @@ QString K3b::AudioDecoder::metaInfo( MetaDataField f )
 }
 
 
+bool K3b::AudioDecoder::metaInfoCollected() const
+{
+    return d->metaInfoCollected;
+}
+
+
 void K3b::AudioDecoder::addMetaInfo( MetaDataField f, const QString& value )
 {
     if( !value.isEmpty() )
@@ -599,23 +640,79 @@ void K3b::AudioDecoder::addTechnicalInfo( const QString& key, const QString& val
 }
 
 
+K3b::AudioDecoderFactory::FileSignature K3b::AudioDecoderFactory::checkSignature( const QByteArray& ) const
+{
+    return SignatureUnknown;
+}
+
+
+QByteArray K3b::AudioDecoderFactory::readSignatureHeader( const QString& filename )
+{
+    QFile f( filename );
+    if( !f.open( QIODevice::ReadOnly ) )
+        return QByteArray();
+
+    QByteArray header = f.read( SIGNATURE_SIZE );
+
+    // skip an ID3v2 tag which may precede MPEG and FLAC data
+    if( header.size() >= 10 && header.startsWith( "ID3" ) &&
+        (uchar)header[3] < 0xff && (uchar)header[4] < 0xff ) {
+        // the size is saved as a synchsafe int meaning bit 7 is always cleared to 0
+        qint64 size = ( ( header[6] & 0x7f ) << 21 ) |
+                      ( ( header[7] & 0x7f ) << 14 ) |
+                      ( ( header[8] & 0x7f ) << 7 ) |
+                      ( header[9] & 0x7f );
+        size += 10;
+        if( header[5] & 0x10 )
+            size += 10; // footer
+
+        if( size < header.size() )
+            header = header.mid( static_cast<int>( size ) ) + f.read( size );
+        else if( f.seek( size ) )
+            header = f.read( SIGNATURE_SIZE );
+        else
+            header.clear();
+    }
+
+    return header;
+}
+
+
 K3b::AudioDecoder* K3b::AudioDecoderFactory::createDecoder( const QUrl& url )
 {
     qDebug() << "(K3b::AudioDecoderFactory::createDecoder( " << url.toLocalFile() << " )";
     QList<K3b::Plugin*> fl = k3bcore->pluginManager()->plugins( "AudioDecoder" );
 
-    // first search for a single format decoder
+    const QByteArray header = readSignatureHeader( url.toLocalFile() );
+
+    //
+    // The order of the candidates: single format decoders recognizing the
+    // signature, single format decoders which cannot tell, and then the
+    // multi format decoders.
+    //
+    QList<K3b::AudioDecoderFactory*> matching, unknown, multiFormatMatching, multiFormatUnknown;
     Q_FOREACH( K3b::Plugin* plugin, fl ) {
         K3b::AudioDecoderFactory* f = dynamic_cast<K3b::AudioDecoderFactory*>( plugin );
-        if( f && !f->multiFormatDecoder() && f->canDecode( url ) ) {
-            qDebug() << "1"; return f->createDecoder();}
+        if( !f )
+            continue;
+
+        switch( f->checkSignature( header ) ) {
+        case SignatureMatch:
+            ( f->multiFormatDecoder() ? multiFormatMatching : matching ).append( f );
+            break;
+        case SignatureUnknown:
+            ( f->multiFormatDecoder() ? multiFormatUnknown : unknown ).append( f );
+            break;
+        case SignatureMismatch:
+            break;
+        }
     }
 
-    // no single format decoder. Search for a multi format decoder
-    Q_FOREACH( K3b::Plugin* plugin, fl ) {
-        K3b::AudioDecoderFactory* f = dynamic_cast<K3b::AudioDecoderFactory*>( plugin );
-        if( f && f->multiFormatDecoder() && f->canDecode( url ) ) {
-            qDebug() << "2"; return f->createDecoder();}
+    Q_FOREACH( K3b::AudioDecoderFactory* f, matching + unknown + multiFormatMatching + multiFormatUnknown ) {
+        if( f->canDecode( url ) ) {
+            qDebug() << "(K3b::AudioDecoderFactory::createDecoder) using" << f->metaObject()->className();
+            return f->createDecoder();
+        }
     }
 
     qDebug() << "(K3b::AudioDecoderFactory::createDecoder( " << url.toLocalFile() << " ) no success";
@@ -39,6 +39,10 @@ namespace K3b {
          * Since this may take a while depending on the filetype it is best
          * to run it in a separate thread.
          *
+         * Decoders which implement analysisData() store the results in the
+         * AudioAnalysisCache and reuse them when the same file is analysed
+         * again.
+         *
          * This method will also call initDecoder().
          *
          * \sa AudioFielAnalyzerJob
@@ -154,6 +158,42 @@ namespace K3b {
          */
         void addTechnicalInfo( const QString&, const QString& );
 
+        /**
+         * @return true if the meta data has been collected by analyseFile().
+         * This is the case if the analysis has been restored from the
+         * AudioAnalysisCache or has been stored in it.
+         * Reimplementations of @p metaInfo should then use the default
+         * implementation which returns the collected data.
+         */
+        bool metaInfoCollected() const;
+
+        /**
+         * Reimplement this to make the results of analyseFileInternal() cacheable.
+         * The returned data has to contain everything restoreAnalysisData()
+         * needs to bring the decoder into the state analyseFileInternal() would
+         * leave it in. It is called right after a successful analysis.
+         *
+         * The default implementation returns a null array which disables caching.
+         */
+        virtual QByteArray analysisData() const { return QByteArray(); }
+
+        /**
+         * Restore the state saved by analysisData() instead of calling
+         * analyseFileInternal(). Return false if the data cannot be used,
+         * the file is analysed in that case.
+         */
+        virtual bool restoreAnalysisData( const QByteArray& ) { return false; }
+
+        /**
+         * Store the current analysisData() in the AudioAnalysisCache. Decoders
+         * which complete their analysis data lazily, for example with a seek table
+         * built on the first seek, use this to make the additional data persistent.
+         *
+         * This only updates the cache in memory since it may be called while
+         * decoding. The cache is written by the next AudioAnalysisCache::save().
+         */
+        void updateAnalysisCache();
+
         /**
          * This will be called once before the first call to decodeInternal.
          * Use it to initialize decoding structures if necessary.
@@ -221,6 +261,44 @@ namespace K3b {
          */
         virtual bool multiFormatDecoder() const { return false; }
 
+        enum FileSignature {
+            /**
+             * The decoder cannot handle the file.
+             */
+            SignatureMismatch,
+
+            /**
+             * The decoder cannot tell from the first bytes of the file.
+             */
+            SignatureUnknown,
+
+            /**
+             * The file starts with the signature of a format handled by the decoder.
+             */
+            SignatureMatch
+        };
+
+        /**
+         * Check the first bytes of a file against the signatures of the formats
+         * supported by the decoder. createDecoder() reads these bytes once and
+         * only asks the decoders which do not return SignatureMismatch if they
+         * can decode the file, starting with the ones returning SignatureMatch.
+         *
+         * This must not do any I/O.
+         *
+         * The default implementation returns SignatureUnknown.
+         *
+         * @param header The first bytes of the file, up to 4 KiB. An ID3v2 tag at
+         *               the beginning of the file has already been skipped.
+         */
+        virtual FileSignature checkSignature( const QByteArray& header ) const;
+
+        /**
+         * Read the bytes of @p filename which are passed to checkSignature(),
+         * skipping an ID3v2 tag at the beginning of the file.
+         */
+        static QByteArray readSignatureHeader( const QString& filename );
+
         /**
          * This is the most important method of the AudioDecoderFactory.
          * It is used to determine if a certain file can be decoded by the
@@ -236,7 +314,8 @@ namespace K3b {
         /**
          * Searching for an audiodecoder for @p filename.
          *
-         * It first searches the single format decoder and the multiformat decoder.
+         * It first searches the single format decoders and then the multiformat
+         * decoders. Decoders are skipped if checkSignature() rules them out.
          *
          * @returns a newly created decoder on success and 0 when no decoder could be found.
          */
@@ -0,0 +1,178 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <config-libk3b.h>
+
+#include "k3bpcmconversion.h"
+
+#include <QtGlobal>
+
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define K3B_PCM_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+// AArch64 is required for the round to nearest conversion
+#define K3B_PCM_NEON
+#include <arm_neon.h>
+#endif
+
+#if !(HAVE_LRINT && HAVE_LRINTF)
+#define lrintf(flt)             ((int) (flt+0.5))
+#endif
+
+
+namespace {
+    inline void storeBigEndian16( qint16 val, char* dest )
+    {
+        dest[0] = val>>8;
+        dest[1] = val;
+    }
+
+    inline qint16 floatToInt16( float sample )
+    {
+        float scaled = sample * 32768.0;
+
+        // clipping
+        if( scaled >= ( 1.0 * 0x7FFF ) )
+            return 32767;
+        else if( scaled <= ( -8.0 * 0x1000 ) )
+            return -32768;
+        else
+            return lrintf(scaled);
+    }
+}
+
+
+void K3b::PcmConversion::bigEndian16ToFloat( const char* src, float* dest, int samples )
+{
+    int i = 0;
+
+#if defined(K3B_PCM_SSE2)
+    const __m128 scale = _mm_set1_ps( 1.0f/32768.0f );
+    for( ; i + 8 <= samples; i += 8 ) {
+        __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + 2*i ) );
+        v = _mm_or_si128( _mm_slli_epi16( v, 8 ), _mm_srli_epi16( v, 8 ) );
+        // sign extend by moving the samples into the upper half
+        const __m128i lo = _mm_srai_epi32( _mm_unpacklo_epi16( v, v ), 16 );
+        const __m128i hi = _mm_srai_epi32( _mm_unpackhi_epi16( v, v ), 16 );
+        _mm_storeu_ps( dest + i, _mm_mul_ps( _mm_cvtepi32_ps( lo ), scale ) );
+        _mm_storeu_ps( dest + i + 4, _mm_mul_ps( _mm_cvtepi32_ps( hi ), scale ) );
+    }
+#elif defined(K3B_PCM_NEON)
+    for( ; i + 8 <= samples; i += 8 ) {
+        const int16x8_t v = vreinterpretq_s16_u8( vrev16q_u8( vld1q_u8( reinterpret_cast<const uint8_t*>( src + 2*i ) ) ) );
+        vst1q_f32( dest + i, vmulq_n_f32( vcvtq_f32_s32( vmovl_s16( vget_low_s16( v ) ) ), 1.0f/32768.0f ) );
+        vst1q_f32( dest + i + 4, vmulq_n_f32( vcvtq_f32_s32( vmovl_s16( vget_high_s16( v ) ) ), 1.0f/32768.0f ) );
+    }
+#endif
+
+    for( ; i < samples; ++i )
+        dest[i] = static_cast<float>( qint16(((src[2*i]<<8)&0xff00)|(src[2*i+1]&0x00ff)) / 32768.0 );
+}
+
+
+void K3b::PcmConversion::floatToBigEndian16( const float* src, char* dest, int samples )
+{
+    int i = 0;
+
+    //
+    // Scaling by a power of two is exact, so the vectorized versions
+    // only need to clip before rounding to the nearest value. NaN is mapped
+    // to 0 just like the scalar version does on these platforms.
+    //
+#if defined(K3B_PCM_SSE2)
+    const __m128 scale = _mm_set1_ps( 32768.0f );
+    const __m128 maxVal = _mm_set1_ps( 32767.0f );
+    const __m128 minVal = _mm_set1_ps( -32768.0f );
+    for( ; i + 8 <= samples; i += 8 ) {
+        __m128 a = _mm_mul_ps( _mm_loadu_ps( src + i ), scale );
+        __m128 b = _mm_mul_ps( _mm_loadu_ps( src + i + 4 ), scale );
+        a = _mm_and_ps( a, _mm_cmpord_ps( a, a ) );
+        b = _mm_and_ps( b, _mm_cmpord_ps( b, b ) );
+        a = _mm_max_ps( _mm_min_ps( a, maxVal ), minVal );
+        b = _mm_max_ps( _mm_min_ps( b, maxVal ), minVal );
+        __m128i v = _mm_packs_epi32( _mm_cvtps_epi32( a ), _mm_cvtps_epi32( b ) );
+        v = _mm_or_si128( _mm_slli_epi16( v, 8 ), _mm_srli_epi16( v, 8 ) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( dest + 2*i ), v );
+    }
+#elif defined(K3B_PCM_NEON)
+    const float32x4_t maxVal = vdupq_n_f32( 32767.0f );
+    const float32x4_t minVal = vdupq_n_f32( -32768.0f );
+    for( ; i + 8 <= samples; i += 8 ) {
+        float32x4_t a = vmulq_n_f32( vld1q_f32( src + i ), 32768.0f );
+        float32x4_t b = vmulq_n_f32( vld1q_f32( src + i + 4 ), 32768.0f );
+        a = vreinterpretq_f32_u32( vandq_u32( vreinterpretq_u32_f32( a ), vceqq_f32( a, a ) ) );
+        b = vreinterpretq_f32_u32( vandq_u32( vreinterpretq_u32_f32( b ), vceqq_f32( b, b ) ) );
+        a = vmaxq_f32( vminq_f32( a, maxVal ), minVal );
+        b = vmaxq_f32( vminq_f32( b, maxVal ), minVal );
+        const int16x8_t v = vcombine_s16( vqmovn_s32( vcvtnq_s32_f32( a ) ), vqmovn_s32( vcvtnq_s32_f32( b ) ) );
+        vst1q_u8( reinterpret_cast<uint8_t*>( dest + 2*i ), vrev16q_u8( vreinterpretq_u8_s16( v ) ) );
+    }
+#endif
+
+    for( ; i < samples; ++i )
+        storeBigEndian16( floatToInt16( src[i] ), dest + 2*i );
+}
+
+
+void K3b::PcmConversion::unsigned8ToBigEndian16( const char* src, char* dest, int samples )
+{
+    //
+    // (sample-128)*256 never needs clipping. Thus, the high byte is the
+    // sample with the sign bit flipped and the low byte is zero.
+    //
+    int i = 0;
+
+#if defined(K3B_PCM_SSE2)
+    const __m128i signBit = _mm_set1_epi8( char( 0x80 ) );
+    const __m128i zero = _mm_setzero_si128();
+    for( ; i + 16 <= samples; i += 16 ) {
+        const __m128i v = _mm_xor_si128( _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + i ) ), signBit );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( dest + 2*i ), _mm_unpacklo_epi8( v, zero ) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( dest + 2*i + 16 ), _mm_unpackhi_epi8( v, zero ) );
+    }
+#elif defined(K3B_PCM_NEON)
+    uint8x16x2_t v;
+    v.val[1] = vdupq_n_u8( 0 );
+    for( ; i + 16 <= samples; i += 16 ) {
+        v.val[0] = veorq_u8( vld1q_u8( reinterpret_cast<const uint8_t*>( src + i ) ), vdupq_n_u8( 0x80 ) );
+        vst2q_u8( reinterpret_cast<uint8_t*>( dest + 2*i ), v );
+    }
+#endif
+
+    for( ; i < samples; ++i ) {
+        dest[2*i]   = src[i] ^ 0x80;
+        dest[2*i+1] = 0;
+    }
+}
+
+
+void K3b::PcmConversion::monoToStereo16( const char* src, char* dest, int frames )
+{
+    int i = 0;
+
+#if defined(K3B_PCM_SSE2)
+    for( ; i + 8 <= frames; i += 8 ) {
+        const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + 2*i ) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( dest + 4*i ), _mm_unpacklo_epi16( v, v ) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( dest + 4*i + 16 ), _mm_unpackhi_epi16( v, v ) );
+    }
+#elif defined(K3B_PCM_NEON)
+    for( ; i + 8 <= frames; i += 8 ) {
+        const uint16x8_t v = vreinterpretq_u16_u8( vld1q_u8( reinterpret_cast<const uint8_t*>( src + 2*i ) ) );
+        const uint8x16_t lo = vreinterpretq_u8_u16( vzip1q_u16( v, v ) );
+        const uint8x16_t hi = vreinterpretq_u8_u16( vzip2q_u16( v, v ) );
+        vst1q_u8( reinterpret_cast<uint8_t*>( dest + 4*i ), lo );
+        vst1q_u8( reinterpret_cast<uint8_t*>( dest + 4*i + 16 ), hi );
+    }
+#endif
+
+    for( ; i < frames; ++i ) {
+        dest[4*i] = dest[4*i+2] = src[2*i];
+        dest[4*i+1] = dest[4*i+3] = src[2*i+1];
+    }
+}
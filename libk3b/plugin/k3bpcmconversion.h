@@ -0,0 +1,43 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef _K3B_PCM_CONVERSION_H_
+#define _K3B_PCM_CONVERSION_H_
+
+
+namespace K3b {
+    /**
+     * Conversion kernels used by AudioDecoder to bring decoded data into
+     * the 16 bit big endian stereo format K3b works with.
+     *
+     * The kernels use SSE2 on x86-64 and NEON on AArch64 and fall back to
+     * plain C++ otherwise. All implementations produce the same output.
+     */
+    namespace PcmConversion {
+        /**
+         * Converts 16 bit big endian signed samples to floats in [-1.0, 1.0).
+         */
+        void bigEndian16ToFloat( const char* src, float* dest, int samples );
+
+        /**
+         * Converts floats to 16 bit big endian signed samples, rounding to
+         * the nearest value and clipping to the 16 bit range.
+         */
+        void floatToBigEndian16( const float* src, char* dest, int samples );
+
+        /**
+         * Converts 8 bit unsigned samples to 16 bit big endian signed samples.
+         */
+        void unsigned8ToBigEndian16( const char* src, char* dest, int samples );
+
+        /**
+         * Duplicates every 16 bit sample of a mono stream to create a stereo
+         * stream. @p dest needs to hold 4*@p frames bytes.
+         */
+        void monoToStereo16( const char* src, char* dest, int frames );
+    }
+}
+
+#endif
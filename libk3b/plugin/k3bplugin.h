@@ -11,7 +11,7 @@
 #include <KPluginMetaData>
 #include <QObject>
 
-#define K3B_PLUGIN_SYSTEM_VERSION 5
+#define K3B_PLUGIN_SYSTEM_VERSION 6
 
 
 
@@ -108,6 +108,23 @@ void K3b::PluginManager::loadAll()
     }
 }
 
+K3b::Plugin* K3b::PluginManager::createInstance( const Plugin* plugin ) const
+{
+    const KPluginMetaData metadata = plugin->pluginMetaData();
+    if( !metadata.isValid() )
+        return 0;
+
+    KPluginFactory::Result<K3b::Plugin> result = KPluginFactory::instantiatePlugin<K3b::Plugin>( metadata );
+    if( !result ) {
+        qDebug() << "failed to instantiate plugin" << metadata.fileName() << result.errorString;
+        return 0;
+    }
+
+    result.plugin->d->metadata = metadata;
+    return result.plugin;
+}
+
+
 int K3b::PluginManager::pluginSystemVersion() const
 {
     return K3B_PLUGIN_SYSTEM_VERSION;
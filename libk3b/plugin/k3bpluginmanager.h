@@ -43,6 +43,15 @@ namespace K3b {
         QStringList categories() const;
 
         int pluginSystemVersion() const;
+
+        /**
+         * Create another instance of @p plugin. This allows to use plugins
+         * which keep state, like audio encoders, from several threads at once.
+         *
+         * \return the new instance which is owned by the caller or 0 if
+         *         the plugin could not be instantiated again.
+         */
+        Plugin* createInstance( const Plugin* plugin ) const;
         
         bool hasPluginDialog( Plugin* plugin ) const;
 
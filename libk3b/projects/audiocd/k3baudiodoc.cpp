@@ -19,6 +19,7 @@
 #include "k3bcdtextvalidator.h"
 #include "k3bcore.h"
 #include "k3baudiodecoder.h"
+#include "k3baudioanalysiscache.h"
 #include "k3b_i18n.h"
 
 #include <KConfig>
@@ -29,11 +30,33 @@
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPointer>
+#include <QSet>
 #include <QStringList>
 #include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
 #include <QDomElement>
 
 
+namespace {
+    // Analysing is mostly I/O bound, more threads only make the disk seek
+    const int s_maxAnalysisThreads = 4;
+
+    void applyMetaInfo( K3b::AudioTrack* track, K3b::AudioDecoder* decoder )
+    {
+        track->setTitle( decoder->metaInfo( K3b::AudioDecoder::META_TITLE ) );
+        track->setArtist( decoder->metaInfo( K3b::AudioDecoder::META_ARTIST ) );
+        track->setSongwriter( decoder->metaInfo( K3b::AudioDecoder::META_SONGWRITER ) );
+        track->setComposer( decoder->metaInfo( K3b::AudioDecoder::META_COMPOSER ) );
+        track->setCdTextMessage( decoder->metaInfo( K3b::AudioDecoder::META_COMMENT ) );
+    }
+}
+
+
 class K3b::AudioDoc::Private
 {
 public:
@@ -74,6 +97,23 @@ public:
     // used to check if we already have a decoder for a specific file
     QMap<QString, AudioDecoder*> decoderPresenceMap;
 
+    //
+    // background analysis
+    // --------------------------------------------------
+    QThreadPool analysisPool;
+
+    // protects analysingDecoders and analysedDecoders
+    mutable QMutex analysisMutex;
+    // queued or running, or finished but not handled yet
+    QSet<AudioDecoder*> analysingDecoders;
+    // finished but not handled yet
+    QList<AudioDecoder*> analysedDecoders;
+
+    // decoders no longer used by any source but still being analysed
+    QSet<AudioDecoder*> orphanedDecoders;
+    // tracks which get their CD-Text from the meta data once analysed
+    QMultiHash<AudioDecoder*, QPointer<AudioTrack> > tracksToTag;
+
     K3b::CdTextValidator* cdTextValidator;
 };
 
@@ -82,10 +122,22 @@ K3b::AudioDoc::AudioDoc( QObject* parent )
     : K3b::Doc( parent )
 {
     d = new Private;
+    d->analysisPool.setMaxThreadCount( qBound( 1, QThread::idealThreadCount(), s_maxAnalysisThreads ) );
 }
 
 K3b::AudioDoc::~AudioDoc()
 {
+    // no need to analyse what is deleted anyway
+    d->analysisPool.clear();
+    d->analysisPool.waitForDone();
+    {
+        QMutexLocker locker( &d->analysisMutex );
+        d->analysingDecoders.clear();
+        d->analysedDecoders.clear();
+    }
+    qDeleteAll( d->orphanedDecoders );
+    d->orphanedDecoders.clear();
+
     // delete all tracks
     int i = 1;
     int cnt = numOfTracks();
@@ -96,6 +148,9 @@ K3b::AudioDoc::~AudioDoc()
         ++i;
     }
 
+    // keep the seek tables the decoders built lazily
+    K3b::AudioAnalysisCache::instance()->save();
+
     delete d;
 }
 
@@ -253,13 +308,7 @@ void K3b::AudioDoc::addTracks( const QList<QUrl>& urls, int position )
 
         if( K3b::AudioTrack* track = createTrack( url ) ) {
             addTrack( track, position );
-
-            K3b::AudioDecoder* dec = static_cast<K3b::AudioFile*>( track->firstSource() )->decoder();
-            track->setTitle( dec->metaInfo( K3b::AudioDecoder::META_TITLE ) );
-            track->setArtist( dec->metaInfo( K3b::AudioDecoder::META_ARTIST ) );
-            track->setSongwriter( dec->metaInfo( K3b::AudioDecoder::META_SONGWRITER ) );
-            track->setComposer( dec->metaInfo( K3b::AudioDecoder::META_COMPOSER ) );
-            track->setCdTextMessage( dec->metaInfo( K3b::AudioDecoder::META_COMMENT ) );
+            setTrackMetaInfo( track );
         }
     }
 
@@ -350,7 +399,7 @@ void K3b::AudioDoc::addSources( K3b::AudioTrack* parent,
     QList<QUrl> allUrls = extractUrlList( urls );
     QList<QUrl>::const_iterator end(allUrls.constEnd());
     for( QList<QUrl>::const_iterator it = allUrls.constBegin(); it != end; ++it ) {
-        if( K3b::AudioFile* file = createAudioFile( *it ) ) {
+        if( K3b::AudioFile* file = createPlaceholderAudioFile( *it ) ) {
             if( sourceAfter )
                 file->moveAfter( sourceAfter );
             else
@@ -475,10 +524,132 @@ K3b::AudioFile* K3b::AudioDoc::createAudioFile( const QUrl& url )
 }
 
 
+K3b::AudioFile* K3b::AudioDoc::createPlaceholderAudioFile( const QUrl& url )
+{
+    if( !QFile::exists( url.toLocalFile() ) ) {
+        qDebug() << "(K3b::AudioDoc) could not find file " << url.toLocalFile();
+        return 0;
+    }
+
+    bool reused;
+    K3b::AudioDecoder* decoder = getDecoderForUrl( url, &reused );
+    if( decoder ) {
+        K3b::AudioFile* file = new K3b::AudioFile( decoder, this );
+        if( !reused )
+            analyseDecoder( decoder );
+        return file;
+    }
+    else {
+        qDebug() << "(K3b::AudioDoc) unknown file type in file " << url.toLocalFile();
+        return 0;
+    }
+}
+
+
+void K3b::AudioDoc::analyseDecoder( K3b::AudioDecoder* decoder )
+{
+    {
+        QMutexLocker locker( &d->analysisMutex );
+        if( d->analysingDecoders.contains( decoder ) )
+            return;
+        d->analysingDecoders.insert( decoder );
+    }
+
+    d->analysisPool.start( [this, decoder]() {
+        decoder->analyseFile();
+
+        QMutexLocker locker( &d->analysisMutex );
+        d->analysedDecoders.append( decoder );
+        // one call handles all decoders finished until then
+        if( d->analysedDecoders.count() == 1 )
+            QMetaObject::invokeMethod( this, [this]() { handleAnalysedDecoders(); }, Qt::QueuedConnection );
+    } );
+}
+
+
+bool K3b::AudioDoc::isAnalysing( K3b::AudioDecoder* decoder ) const
+{
+    QMutexLocker locker( &d->analysisMutex );
+    return d->analysingDecoders.contains( decoder );
+}
+
+
+void K3b::AudioDoc::waitForAnalysis()
+{
+    d->analysisPool.waitForDone();
+    handleAnalysedDecoders();
+}
+
+
+void K3b::AudioDoc::setTrackMetaInfo( K3b::AudioTrack* track )
+{
+    K3b::AudioFile* file = dynamic_cast<K3b::AudioFile*>( track->firstSource() );
+    if( !file )
+        return;
+
+    if( isAnalysing( file->decoder() ) )
+        d->tracksToTag.insert( file->decoder(), track );
+    else
+        applyMetaInfo( track, file->decoder() );
+}
+
+
+void K3b::AudioDoc::handleAnalysedDecoders()
+{
+    QSet<K3b::AudioDecoder*> analysed;
+    bool finished = false;
+    {
+        QMutexLocker locker( &d->analysisMutex );
+        Q_FOREACH( K3b::AudioDecoder* decoder, d->analysedDecoders ) {
+            d->analysingDecoders.remove( decoder );
+            analysed.insert( decoder );
+        }
+        d->analysedDecoders.clear();
+        finished = d->analysingDecoders.isEmpty();
+    }
+
+    if( analysed.isEmpty() )
+        return;
+
+    Q_FOREACH( K3b::AudioDecoder* decoder, d->orphanedDecoders ) {
+        if( analysed.remove( decoder ) ) {
+            d->orphanedDecoders.remove( decoder );
+            delete decoder;
+        }
+    }
+
+    // a single pass over the project even when many files have been analysed
+    for( K3b::AudioTrack* track = d->firstTrack; track; track = track->next() ) {
+        for( K3b::AudioDataSource* source = track->firstSource(); source; source = source->next() ) {
+            K3b::AudioFile* file = dynamic_cast<K3b::AudioFile*>( source );
+            if( file && analysed.contains( file->decoder() ) )
+                file->decoderAnalysed();
+        }
+    }
+
+    for( QMultiHash<K3b::AudioDecoder*, QPointer<K3b::AudioTrack> >::iterator it = d->tracksToTag.begin();
+         it != d->tracksToTag.end(); ) {
+        if( analysed.contains( it.key() ) ) {
+            if( it.value() )
+                applyMetaInfo( it.value(), it.key() );
+            it = d->tracksToTag.erase( it );
+        }
+        else {
+            ++it;
+        }
+    }
+
+    if( finished )
+        K3b::AudioAnalysisCache::instance()->save();
+
+    emit changed();
+}
+
+
 K3b::AudioTrack* K3b::AudioDoc::createTrack( const QUrl& url )
 {
     qDebug() << "(K3b::AudioDoc::createTrack( " << url.toLocalFile() << " )";
-    if( K3b::AudioFile* file = createAudioFile( url ) ) {
+    if( K3b::AudioFile* file = createPlaceholderAudioFile( url ) ) {
         K3b::AudioTrack* newTrack = new K3b::AudioTrack( this );
         newTrack->setFirstSource( file );
         return newTrack;
@@ -777,6 +948,9 @@ bool K3b::AudioDoc::loadDocumentData( QDomElement* root )
         }
     }
 
+    // the files have been analysed right away since the indices need the lengths
+    K3b::AudioAnalysisCache::instance()->save();
+
     setModified(false);
 
     return true;
@@ -999,6 +1173,8 @@ bool K3b::AudioDoc::normalize() const
 
 K3b::BurnJob* K3b::AudioDoc::newBurnJob( K3b::JobHandler* hdl, QObject* parent )
 {
+    // the job needs the final lengths of all sources
+    waitForAnalysis();
     return new K3b::AudioJob( this, hdl, parent );
 }
 
@@ -1046,7 +1222,12 @@ void K3b::AudioDoc::decreaseDecoderUsage( K3b::AudioDecoder* decoder )
     if( d->decoderUsageCounterMap[decoder] <= 0 ) {
         d->decoderUsageCounterMap.remove(decoder);
         d->decoderPresenceMap.remove(decoder->filename());
-        delete decoder;
+        d->tracksToTag.remove(decoder);
+        // the analysis thread still uses the decoder
+        if( isAnalysing( decoder ) )
+            d->orphanedDecoders.insert( decoder );
+        else
+            delete decoder;
     }
 }
 
@@ -129,6 +129,37 @@ namespace K3b {
          */
         AudioDecoder* getDecoderForUrl( const QUrl& url, bool* reused = 0 );
 
+        /**
+         * Analyse a decoder returned by getDecoderForUrl() which was not reused
+         * in the background. The analysis runs on a small thread pool shared by
+         * all decoders of the project.
+         *
+         * Until the analysis is done the AudioFile sources using the decoder
+         * report a length of 0. They are updated once it is finished.
+         *
+         * \see AudioDecoder::analyseFile
+         */
+        void analyseDecoder( AudioDecoder* decoder );
+
+        /**
+         * \return true if @p decoder has been passed to analyseDecoder() and
+         *         the analysis has not been finished yet.
+         */
+        bool isAnalysing( AudioDecoder* decoder ) const;
+
+        /**
+         * Blocks until all decoders passed to analyseDecoder() have been analysed
+         * and the sources have been updated.
+         */
+        void waitForAnalysis();
+
+        /**
+         * Initialize the CD-Text of @p track from the meta data of the file
+         * used by its first source. If the file is still being analysed this
+         * happens once the analysis is done.
+         */
+        void setTrackMetaInfo( AudioTrack* track );
+
         /**
          * Transforms given url list into flat file list.
          * Each directory and M3U playlist is expanded into the files.
@@ -202,6 +233,17 @@ namespace K3b {
         // ---------------------------------------------------------
         AudioTrack* createTrack( const QUrl& url );
 
+        /**
+         * Like createAudioFile but the file is analysed in the background.
+         */
+        AudioFile* createPlaceholderAudioFile( const QUrl& url );
+
+        /**
+         * Update the sources and tracks of the decoders the analysis of which
+         * has been finished.
+         */
+        void handleAnalysedDecoders();
+
         /**
          * Used by AudioTrack to update the track list
          */
@@ -47,7 +47,10 @@ K3b::AudioFile::~AudioFile()
 
 QString K3b::AudioFile::type() const
 {
-    return d->decoder->fileType();
+    if( d->doc->isAnalysing( d->decoder ) )
+        return QString();
+    else
+        return d->decoder->fileType();
 }
 
 
@@ -77,13 +80,20 @@ K3b::AudioDoc* K3b::AudioFile::doc() const
 
 bool K3b::AudioFile::isValid() const
 {
-    return d->decoder->isValid();
+    // we do not know any better yet
+    if( d->doc->isAnalysing( d->decoder ) )
+        return true;
+    else
+        return d->decoder->isValid();
 }
 
 
 K3b::Msf K3b::AudioFile::originalLength() const
 {
-    return d->decoder->length();
+    if( d->doc->isAnalysing( d->decoder ) )
+        return 0;
+    else
+        return d->decoder->length();
 }
 
 
@@ -97,3 +107,9 @@ QIODevice* K3b::AudioFile::createReader( QObject* parent )
 {
     return new AudioFileReader( *this, parent );
 }
+
+
+void K3b::AudioFile::decoderAnalysed()
+{
+    emitChange();
+}
@@ -27,6 +27,8 @@ namespace K3b {
      */
     class LIBK3B_EXPORT AudioFile : public AudioDataSource
     {
+        friend class AudioDoc;
+
     public:
         /**
          * The AudioFile registers itself with the doc. This is part of the
@@ -52,6 +54,9 @@ namespace K3b {
 
         /**
          * The complete length of the file used by this source.
+         * This is 0 as long as the file is being analysed.
+         *
+         * \see AudioDoc::analyseDecoder
          */
         Msf originalLength() const override;
 
@@ -65,6 +70,12 @@ namespace K3b {
         QIODevice* createReader( QObject* parent = 0 ) override;
 
     private:
+        /**
+         * Used by AudioDoc to inform about the finished analysis of the decoder.
+         */
+        void decoderAnalysed();
+
+
         class Private;
         QScopedPointer<Private> d;
     };
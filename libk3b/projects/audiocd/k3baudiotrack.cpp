@@ -592,7 +592,8 @@ void K3b::AudioTrack::sourceChanged( K3b::AudioDataSource* )
 
     // TODO: update indices
 
-    if( d->index0Offset > length() )
+    // sources which are still being analysed do not have a length yet
+    if( length() > 0 && d->index0Offset > length() )
         d->index0Offset = length()-1;
 
     emitChanged();
@@ -21,6 +21,8 @@
 #include "k3bmsf.h"
 #include "k3biso9660.h"
 #include "k3bisooptions.h"
+#include "k3bisosizecalculator.h"
+#include "k3bfilestatcache.h"
 #include "k3bdevicehandler.h"
 #include "k3bdevice.h"
 #include "k3btoc.h"
@@ -37,14 +39,103 @@
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
+#include <QSet>
 #include <QStringList>
+#include <QThread>
+#include <QThreadPool>
 #include <QTimer>
+#include <QVector>
 #include <QApplication>
 #include <QDomElement>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+#include <algorithm>
 
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+    // below this number of items the thread start-up costs more than it gains
+    const long PARALLEL_PREPARATION_THRESHOLD = 10000;
+
+    void collectDirs( K3b::DirItem* dir, QList<K3b::DirItem*>& dirs )
+    {
+        dirs.append( dir );
+        Q_FOREACH( K3b::DataItem* item, dir->children() ) {
+            if( item->isDir() )
+                collectDirs( static_cast<K3b::DirItem*>( item ), dirs );
+        }
+    }
+
+    /**
+     * Collect the items below @p item (including itself) which count
+     * towards the project size. The UNRESOLVED files do not count until
+     * their local file has been checked and are collected in @p unresolved.
+     */
+    void collectSizeItems( K3b::DataItem* item, QList<K3b::DataItem*>& items, QList<K3b::FileItem*>& unresolved )
+    {
+        if( item->isDir() ) {
+            // folders from an old session may still contain new files
+            Q_FOREACH( K3b::DataItem* child, static_cast<K3b::DirItem*>( item )->children() ) {
+                collectSizeItems( child, items, unresolved );
+            }
+        }
+        else if( item->flags().testFlag( K3b::DataItem::UNRESOLVED ) ) {
+            unresolved.append( static_cast<K3b::FileItem*>( item ) );
+        }
+        else if( !item->isFromOldSession() ) {
+            items.append( item );
+        }
+    }
+
+    // number of files which are stat'ed together while loading a project
+    const int LOAD_BATCH_SIZE = 4096;
+
+    /**
+     * A file read from a project file whose item has not been created yet
+     * or an UNRESOLVED item whose local file is being checked.
+     */
+    struct PendingFile {
+        PendingFile()
+            : parent( 0 ),
+              item( 0 ),
+              sortWeight( 0 ),
+              statOk( false ),
+              followedStatOk( false ),
+              readable( false ) {
+        }
+
+        K3b::DirItem* parent;
+        K3b::FileItem* item;
+        QString path;
+        QString name;
+        long sortWeight;
+
+        k3b_struct_stat statBuf;
+        k3b_struct_stat followedStatBuf;
+        bool statOk;
+        bool followedStatOk;
+        bool readable;
+    };
+
+    void statPendingFile( PendingFile& file )
+    {
+        const QByteArray encodedPath = QFile::encodeName( file.path );
+        file.statOk = ( k3b_lstat( encodedPath.constData(), &file.statBuf ) == 0 );
+        file.followedStatOk = ( k3b_stat( encodedPath.constData(), &file.followedStatBuf ) == 0 );
+        file.readable = ( file.followedStatOk &&
+                          S_ISREG( file.followedStatBuf.st_mode ) &&
+                          ::access( encodedPath.constData(), R_OK ) == 0 );
+    }
+}
 
 
 class K3b::DataDoc::Private
@@ -54,13 +145,16 @@ public:
     :
         oldSessionSize( 0 ),
         root( 0 ),
+        isoSizeCalculator( 0 ),
+        fileStatCache( 0 ),
         dataMode( 0 ),
         verifyData( false ),
         importedSession( -1 ),
         bootCataloge( 0 ),
         bExistingItemsReplaceAll( false ),
         bExistingItemsIgnoreAll( false ),
-        needToCutFilenames( false )
+        needToCutFilenames( false ),
+        fileResolutionScheduled( false )
     {
         sizeHandler = new K3b::FileCompilationSizeHandler();
     }
@@ -68,6 +162,8 @@ public:
     ~Private()
     {
         delete root;
+        delete isoSizeCalculator;
+        delete fileStatCache;
         delete sizeHandler;
         //  delete oldSessionSizeHandler;
     }
@@ -82,6 +178,12 @@ public:
 
     RootItem* root;
 
+    IsoSizeCalculator* isoSizeCalculator;
+    FileStatCache* fileStatCache;
+
+    // the folders of the local files, see sharedLocalDir()
+    QSet<QString> localDirs;
+
     int dataMode;
 
     bool verifyData;
@@ -101,6 +203,25 @@ public:
 
     bool needToCutFilenames;
     QList<DataItem*> needToCutFilenameItems;
+
+    // files collected while loading a project, see loadPendingFiles()
+    QVector<PendingFile> pendingFiles;
+    QSet<QPair<DirItem*, QString> > pendingNames;
+
+    //
+    // checking the local files of UNRESOLVED items, see resolveFiles()
+    // --------------------------------------------------
+    QThreadPool resolvePool;
+    // the UNRESOLVED items in the project
+    QSet<FileItem*> unresolvedFiles;
+    // not passed to resolvePool yet
+    QVector<PendingFile> filesToResolve;
+    bool fileResolutionScheduled;
+
+    // protects resolvedFiles
+    QMutex resolveMutex;
+    // checked but not handled yet
+    QVector<PendingFile> resolvedFiles;
 };
 
 
@@ -114,11 +235,18 @@ K3b::DataDoc::DataDoc( QObject* parent )
     : K3b::Doc( parent ),
       d( new Private )
 {
+    d->isoSizeCalculator = new K3b::IsoSizeCalculator( this );
+    d->fileStatCache = new K3b::FileStatCache();
+    // each batch is stat'ed in parallel by itself
+    d->resolvePool.setMaxThreadCount( 1 );
 }
 
 
 K3b::DataDoc::~DataDoc()
 {
+    // no need to check files which are deleted anyway
+    d->resolvePool.clear();
+    d->resolvePool.waitForDone();
     delete d;
 }
 
@@ -151,6 +279,7 @@ void K3b::DataDoc::clear()
             removeItem( d->root->children().first() );
     }
     d->sizeHandler->clear();
+    d->localDirs.clear();
     emit importedSessionChanged( importedSession() );
 }
 
@@ -170,10 +299,34 @@ const K3b::IsoOptions& K3b::DataDoc::isoOptions() const
 void K3b::DataDoc::setIsoOptions( const K3b::IsoOptions& isoOptions )
 {
     d->isoOptions = isoOptions;
+    d->isoSizeCalculator->invalidateAll();
     emit changed();
 }
 
 
+K3b::IsoSizeCalculator* K3b::DataDoc::isoSizeCalculator() const
+{
+    return d->isoSizeCalculator;
+}
+
+
+K3b::FileStatCache* K3b::DataDoc::fileStatCache() const
+{
+    return d->fileStatCache;
+}
+
+
+QString K3b::DataDoc::sharedLocalDir( const QString& dir )
+{
+    QSet<QString>::const_iterator it = d->localDirs.constFind( dir );
+    if( it != d->localDirs.constEnd() )
+        return *it;
+
+    d->localDirs.insert( dir );
+    return dir;
+}
+
+
 void K3b::DataDoc::setVolumeID( const QString& v )
 {
     d->isoOptions.setVolumeID( v );
@@ -393,6 +546,70 @@ bool K3b::DataDoc::loadDocumentData( QDomElement* rootElem )
 }
 
 
+bool K3b::DataDoc::loadDocumentStream( QXmlStreamReader& reader )
+{
+    if( !root() )
+        newDocument();
+
+    // the small sections are read into a DOM to share the parsing with loadDocumentData()
+    QDomDocument doc;
+
+    if( !reader.readNextStartElement() || reader.name() != QLatin1String( "general" ) ) {
+        qDebug() << "(K3b::DataDoc) could not find 'general' section.";
+        return false;
+    }
+    if( !readGeneralDocumentData( readDomElement( reader, doc ) ) )
+        return false;
+
+    if( !reader.readNextStartElement() || reader.name() != QLatin1String( "options" ) ) {
+        qDebug() << "(K3b::DataDoc) could not find 'options' section.";
+        return false;
+    }
+    if( !loadDocumentDataOptions( readDomElement( reader, doc ) ) )
+        return false;
+
+    if( !reader.readNextStartElement() || reader.name() != QLatin1String( "header" ) ) {
+        qDebug() << "(K3b::DataDoc) could not find 'header' section.";
+        return false;
+    }
+    if( !loadDocumentDataHeader( readDomElement( reader, doc ) ) )
+        return false;
+
+    if( !reader.readNextStartElement() || reader.name() != QLatin1String( "files" ) ) {
+        qDebug() << "(K3b::DataDoc) could not find 'files' section.";
+        return false;
+    }
+
+    if( d->root == 0 )
+        d->root = new K3b::RootItem( *this );
+
+    bool success = true;
+    while( success && reader.readNextStartElement() )
+        success = loadDataItem( reader, root() );
+
+    // ignore everything following the files just like loadDocumentData() does
+    if( success ) {
+        reader.skipCurrentElement();
+        success = !reader.hasError();
+    }
+    if( !success ) {
+        qDebug() << "(K3b::DataDoc) parsing failed:" << reader.errorString();
+        d->pendingFiles.clear();
+        d->pendingNames.clear();
+        return false;
+    }
+
+    loadPendingFiles();
+
+    if( !d->bootImages.isEmpty() && !d->bootCataloge )
+        createBootCatalogeItem( d->bootImages.first()->parent() );
+
+    informAboutNotFoundFiles();
+
+    return true;
+}
+
+
 bool K3b::DataDoc::loadDocumentDataOptions( QDomElement elem )
 {
     QDomNodeList headerList = elem.childNodes();
@@ -651,6 +868,209 @@ bool K3b::DataDoc::loadDataItem( QDomElement& elem, K3b::DirItem* parent )
 }
 
 
+bool K3b::DataDoc::loadDataItem( QXmlStreamReader& reader, K3b::DirItem* parent )
+{
+    if( !parent )
+        return false;
+
+    const QXmlStreamAttributes attributes = reader.attributes();
+
+    if( reader.name() == QLatin1String( "file" ) && !attributes.hasAttribute( "bootimage" ) ) {
+        if( !reader.readNextStartElement() ) {
+            qDebug() << "(K3b::DataDoc) file-element without url!";
+            return false;
+        }
+        PendingFile file;
+        file.parent = parent;
+        file.path = reader.readElementText();
+        file.name = attributes.value( "name" ).toString();
+        file.sortWeight = attributes.value( "sort_weight" ).toInt();
+        reader.skipCurrentElement();
+
+        // the files are checked and created in batches, see loadPendingFiles()
+        d->pendingFiles.append( file );
+        d->pendingNames.insert( qMakePair( parent, file.name ) );
+        if( d->pendingFiles.count() >= LOAD_BATCH_SIZE )
+            loadPendingFiles();
+    }
+    else if( reader.name() == QLatin1String( "directory" ) ) {
+        const QString name = attributes.value( "name" ).toString();
+
+        // a file of the same name has to exist before we can detect the clash
+        if( d->pendingNames.contains( qMakePair( parent, name ) ) )
+            loadPendingFiles();
+
+        // This is for the VideoDVD project which already contains the *_TS folders
+        K3b::DirItem* newDirItem = 0;
+        if( K3b::DataItem* item = parent->find( name ) ) {
+            if( item->isDir() ) {
+                newDirItem = static_cast<K3b::DirItem*>(item);
+            }
+            else {
+                qCritical() << "(K3b::DataDoc) INVALID DOCUMENT: item " << item->k3bPath() << " saved twice" << Qt::endl;
+                return false;
+            }
+        }
+
+        if( !newDirItem ) {
+            newDirItem = new K3b::DirItem( name );
+            parent->addDataItem( newDirItem );
+        }
+
+        while( reader.readNextStartElement() ) {
+            if( !loadDataItem( reader, newDirItem ) )
+                return false;
+        }
+        if( reader.hasError() )
+            return false;
+
+        newDirItem->setSortWeight( attributes.value( "sort_weight" ).toInt() );
+    }
+    else {
+        // boot images and the boot catalog
+        QDomDocument doc;
+        QDomElement elem = readDomElement( reader, doc );
+        if( reader.hasError() || !loadDataItem( elem, parent ) )
+            return false;
+    }
+
+    return true;
+}
+
+
+void K3b::DataDoc::loadPendingFiles()
+{
+    const PendingFile* files = d->pendingFiles.constData();
+    const int count = d->pendingFiles.count();
+
+    K3b::DirItem::Children items;
+    for( int i = 0; i < count; ++i ) {
+        const PendingFile& file = files[i];
+
+        // the local file is checked in the background, see resolveFiles()
+        K3b::FileItem* item = new K3b::FileItem( 0, 0, file.path, *this, file.name, K3b::DataItem::UNRESOLVED );
+        item->setSortWeight( file.sortWeight );
+        items.append( item );
+
+        // add all files of a folder at once
+        if( i + 1 == count || files[i+1].parent != file.parent ) {
+            file.parent->addDataItems( items );
+            items.clear();
+        }
+    }
+
+    d->pendingFiles.clear();
+    d->pendingNames.clear();
+}
+
+
+void K3b::DataDoc::resolveFiles( const QList<K3b::FileItem*>& items )
+{
+    Q_FOREACH( K3b::FileItem* item, items ) {
+        d->unresolvedFiles.insert( item );
+        PendingFile file;
+        file.item = item;
+        file.path = item->localPath();
+        d->filesToResolve.append( file );
+    }
+
+    if( d->filesToResolve.count() >= LOAD_BATCH_SIZE ) {
+        startFileResolution();
+    }
+    else if( !d->fileResolutionScheduled ) {
+        // collect the files added until the event loop is reached
+        d->fileResolutionScheduled = true;
+        QTimer::singleShot( 0, this, [this]() {
+            d->fileResolutionScheduled = false;
+            startFileResolution();
+        } );
+    }
+}
+
+
+void K3b::DataDoc::startFileResolution()
+{
+    if( d->filesToResolve.isEmpty() )
+        return;
+
+    QVector<PendingFile> batch;
+    batch.swap( d->filesToResolve );
+
+    d->resolvePool.start( [this, batch]() mutable {
+        PendingFile* files = batch.data();
+        K3b::FileStatCache::statInParallel( batch.count(), [files]( int i ) {
+            statPendingFile( files[i] );
+        } );
+
+        QMutexLocker locker( &d->resolveMutex );
+        const bool handlerQueued = !d->resolvedFiles.isEmpty();
+        d->resolvedFiles += batch;
+        // one call handles all batches finished until then
+        if( !handlerQueued )
+            QMetaObject::invokeMethod( this, [this]() { handleResolvedFiles(); }, Qt::QueuedConnection );
+    } );
+}
+
+
+void K3b::DataDoc::handleResolvedFiles()
+{
+    QVector<PendingFile> files;
+    {
+        QMutexLocker locker( &d->resolveMutex );
+        files.swap( d->resolvedFiles );
+    }
+
+    QList<K3b::DataItem*> sizeItems;
+    QList<K3b::DataItem*> missingItems;
+    for( int i = 0; i < files.count(); ++i ) {
+        const PendingFile& file = files.at( i );
+
+        // the item has been removed in the meantime, a new item may even use its memory
+        if( !d->unresolvedFiles.contains( file.item ) || file.item->localPath() != file.path )
+            continue;
+        d->unresolvedFiles.remove( file.item );
+
+        const bool isSymLink = file.statOk && S_ISLNK( file.statBuf.st_mode );
+        const bool isFile = file.followedStatOk && S_ISREG( file.followedStatBuf.st_mode );
+
+        // We cannot check for existence only since this always disqualifies broken symlinks
+        if( !isFile && !isSymLink ) {
+            d->notFoundFiles.append( file.path );
+            missingItems.append( file.item );
+        }
+        else if( isFile && !file.readable ) {
+            d->noPermissionFiles.append( file.path );
+            missingItems.append( file.item );
+        }
+        else {
+            file.item->resolve( file.statOk ? &file.statBuf : 0,
+                                file.followedStatOk ? &file.followedStatBuf : 0 );
+            sizeItems.append( file.item );
+            itemChanged( file.item );
+        }
+    }
+
+    if( sizeItems.isEmpty() && missingItems.isEmpty() )
+        return;
+
+    // the UNRESOLVED items have not been counted yet, see collectSizeItems()
+    d->sizeHandler->addFiles( sizeItems );
+    qDeleteAll( missingItems );
+    emit changed();
+
+    if( d->unresolvedFiles.isEmpty() )
+        informAboutNotFoundFiles();
+}
+
+
+void K3b::DataDoc::waitForFileResolution()
+{
+    startFileResolution();
+    d->resolvePool.waitForDone();
+    handleResolvedFiles();
+}
+
+
 bool K3b::DataDoc::saveDocumentData( QDomElement* docElem )
 {
     QDomDocument doc = docElem->ownerDocument();
@@ -686,6 +1106,36 @@ bool K3b::DataDoc::saveDocumentData( QDomElement* docElem )
 }
 
 
+bool K3b::DataDoc::saveDocumentStream( QXmlStreamWriter& writer )
+{
+    // the small sections are created as DOM to share the code with saveDocumentData()
+    QDomDocument doc;
+    QDomElement docElem = doc.createElement( "k3b_" + typeString() + "_project" );
+    doc.appendChild( docElem );
+
+    saveGeneralDocumentData( &docElem );
+
+    QDomElement optionsElem = doc.createElement( "options" );
+    saveDocumentDataOptions( optionsElem );
+    docElem.appendChild( optionsElem );
+
+    QDomElement headerElem = doc.createElement( "header" );
+    saveDocumentDataHeader( headerElem );
+    docElem.appendChild( headerElem );
+
+    for( QDomElement e = docElem.firstChildElement(); !e.isNull(); e = e.nextSiblingElement() )
+        writeDomElement( writer, e );
+
+    writer.writeStartElement( "files" );
+    Q_FOREACH( K3b::DataItem* item, root()->children() ) {
+        saveDataItem( item, writer );
+    }
+    writer.writeEndElement();
+
+    return !writer.hasError();
+}
+
+
 void K3b::DataDoc::saveDocumentDataOptions( QDomElement& optionsElem )
 {
     QDomDocument doc = optionsElem.ownerDocument();
@@ -934,6 +1384,44 @@ void K3b::DataDoc::saveDataItem( K3b::DataItem* item, QDomDocument* doc, QDomEle
 }
 
 
+void K3b::DataDoc::saveDataItem( K3b::DataItem* item, QXmlStreamWriter& writer )
+{
+    if( item->isBootItem() || item == d->bootCataloge ) {
+        QDomDocument doc;
+        QDomElement parentElem = doc.createElement( "files" );
+        doc.appendChild( parentElem );
+        saveDataItem( item, &doc, &parentElem );
+        if( !parentElem.firstChildElement().isNull() )
+            writeDomElement( writer, parentElem.firstChildElement() );
+    }
+    else if( K3b::FileItem* fileItem = dynamic_cast<K3b::FileItem*>( item ) ) {
+        if( d->oldSession.contains( fileItem ) ) {
+            qDebug() << "(K3b::DataDoc) ignoring fileitem " << fileItem->k3bName() << " from old session while saving...";
+        }
+        else {
+            writer.writeStartElement( "file" );
+            writer.writeAttribute( "name", fileItem->k3bName() );
+            if( item->sortWeight() != 0 )
+                writer.writeAttribute( "sort_weight", QString::number(item->sortWeight()) );
+            writer.writeTextElement( "url", fileItem->localPath() );
+            writer.writeEndElement();
+        }
+    }
+    else if( K3b::DirItem* dirItem = dynamic_cast<K3b::DirItem*>( item ) ) {
+        writer.writeStartElement( "directory" );
+        writer.writeAttribute( "name", dirItem->k3bName() );
+        if( item->sortWeight() != 0 )
+            writer.writeAttribute( "sort_weight", QString::number(item->sortWeight()) );
+
+        Q_FOREACH( K3b::DataItem* item, dirItem->children() ) {
+            saveDataItem( item, writer );
+        }
+
+        writer.writeEndElement();
+    }
+}
+
+
 void K3b::DataDoc::removeItem( K3b::DataItem* item )
 {
     if( !item )
@@ -963,16 +1451,25 @@ void K3b::DataDoc::beginInsertItems( DirItem* parent, int start, int end )
 
 void K3b::DataDoc::endInsertItems( DirItem* parent, int start, int end )
 {
+    QList<DataItem*> sizeItems;
+    QList<FileItem*> unresolvedItems;
     for( int i = start; i <= end; ++i ) {
         DataItem* item = parent->children().at( i );
-        // update the project size
-        if( !item->isFromOldSession() )
-            d->sizeHandler->addFile( item );
+        collectSizeItems( item, sizeItems, unresolvedItems );
 
         // update the boot item list
         if( item->isBootItem() )
             d->bootImages.append( static_cast<K3b::BootItem*>( item ) );
+
+        if( item->isDir() )
+            d->isoSizeCalculator->invalidate( static_cast<K3b::DirItem*>( item ), true );
     }
+    // update the project size
+    d->sizeHandler->addFiles( sizeItems );
+    d->isoSizeCalculator->invalidate( parent );
+
+    if( !unresolvedItems.isEmpty() )
+        resolveFiles( unresolvedItems );
 
     emit itemsInserted( parent, start, end );
     emit changed();
@@ -983,11 +1480,11 @@ void K3b::DataDoc::beginRemoveItems( DirItem* parent, int start, int end )
 {
     emit itemsAboutToBeRemoved( parent, start, end );
 
+    QList<DataItem*> sizeItems;
+    QList<FileItem*> unresolvedItems;
     for( int i = start; i <= end; ++i ) {
         DataItem* item = parent->children().at( i );
-        // update the project size
-        if( !item->isFromOldSession() )
-            d->sizeHandler->removeFile( item );
+        collectSizeItems( item, sizeItems, unresolvedItems );
 
         // update the boot item list
         if( item->isBootItem() ) {
@@ -997,7 +1494,28 @@ void K3b::DataDoc::beginRemoveItems( DirItem* parent, int start, int end )
                 d->bootCataloge = 0;
             }
         }
+
+        d->isoSizeCalculator->forget( item );
     }
+    // update the project size
+    d->sizeHandler->removeFiles( sizeItems );
+    d->isoSizeCalculator->invalidate( parent );
+
+    // moved items are resolved again once inserted, see endInsertItems()
+    Q_FOREACH( FileItem* item, unresolvedItems ) {
+        d->unresolvedFiles.remove( item );
+    }
+}
+
+
+void K3b::DataDoc::itemChanged( DataItem* item )
+{
+    if( item->parent() )
+        d->isoSizeCalculator->invalidate( item->parent() );
+
+    // hiding a directory affects all its children
+    if( item->isDir() )
+        d->isoSizeCalculator->invalidate( static_cast<K3b::DirItem*>( item ), true );
 }
 
 
@@ -1047,6 +1565,7 @@ void K3b::DataDoc::moveItems( const QList<K3b::DataItem*>& itemList, K3b::DirIte
 
 K3b::BurnJob* K3b::DataDoc::newBurnJob( K3b::JobHandler* hdl, QObject* parent )
 {
+    waitForFileResolution();
     return new K3b::DataJob( this, hdl, parent );
 }
 
@@ -1104,76 +1623,93 @@ void K3b::DataDoc::prepareFilenames()
     // too much.
     //
 
-    K3b::DataItem* item = root();
-    int maxlen = ( isoOptions().jolietLong() ? 103 : 64 );
-    while( (item = item->nextSibling()) ) {
-        item->setWrittenName( treatWhitespace( item->k3bName() ) );
+    QList<K3b::DirItem*> dirs;
+    collectDirs( root(), dirs );
 
-        if( isoOptions().createJoliet() && item->writtenName().length() > maxlen ) {
-            d->needToCutFilenames = true;
-            item->setWrittenName( K3b::cutFilename( item->writtenName(), maxlen ) );
-            d->needToCutFilenameItems.append( item );
+    //
+    // Each directory only changes the written names of its own children. Thus, all
+    // directories can be handled independently of each other.
+    //
+    QVector<QList<K3b::DataItem*> > cutItems( dirs.count() );
+    QList<K3b::DataItem*>* cutItemsData = cutItems.data();
+    const int threads = QThread::idealThreadCount();
+    if( threads > 1 && dirs.count() > 1 &&
+        root()->numFiles() + root()->numDirs() >= PARALLEL_PREPARATION_THRESHOLD ) {
+        // use several chunks per thread to even out differently sized directories
+        const int chunkSize = qMax( 1, dirs.count() / ( threads * 4 ) );
+        QThreadPool pool;
+        pool.setMaxThreadCount( threads );
+        for( int start = 0; start < dirs.count(); start += chunkSize ) {
+            const int end = qMin( start + chunkSize, dirs.count() );
+            pool.start( [this, &dirs, cutItemsData, start, end]() {
+                for( int i = start; i < end; ++i )
+                    prepareFilenamesInDir( dirs.at( i ), cutItemsData[i] );
+            } );
         }
-
-        // TODO: check the Joliet charset
+        pool.waitForDone();
+    }
+    else {
+        for( int i = 0; i < dirs.count(); ++i )
+            prepareFilenamesInDir( dirs.at( i ), cutItemsData[i] );
     }
 
-    //
-    // 3. check if a directory contains items with the same name
-    //
-    prepareFilenamesInDir( root() );
+    for( int i = 0; i < cutItems.count(); ++i )
+        d->needToCutFilenameItems += cutItems.at( i );
+    d->needToCutFilenames = !d->needToCutFilenameItems.isEmpty();
 }
 
 
-void K3b::DataDoc::prepareFilenamesInDir( K3b::DirItem* dir )
+void K3b::DataDoc::prepareFilenamesInDir( K3b::DirItem* dir, QList<K3b::DataItem*>& cutItems )
 {
     if( !dir )
         return;
 
-    QList<K3b::DataItem*> sortedChildren;
-    QList<K3b::DataItem*> children( dir->children() );
-    QList<K3b::DataItem*>::const_iterator it = children.constEnd();
-    while ( it != children.constBegin() ) {
-        --it;
-        K3b::DataItem* item = *it;
+    const int maxJolietLen = ( isoOptions().jolietLong() ? 103 : 64 );
 
-        if( item->isDir() )
-            prepareFilenamesInDir( dynamic_cast<K3b::DirItem*>( item ) );
+    QList<K3b::DataItem*> sortedChildren( dir->children() );
+    Q_FOREACH( K3b::DataItem* item, sortedChildren ) {
+        item->setWrittenName( treatWhitespace( item->k3bName() ) );
 
-        // insertion sort
-        int i = 0;
-        while( i < sortedChildren.count() && item->writtenName() > sortedChildren.at(i)->writtenName() )
-            ++i;
+        if( isoOptions().createJoliet() && item->writtenName().length() > maxJolietLen ) {
+            item->setWrittenName( K3b::cutFilename( item->writtenName(), maxJolietLen ) );
+            cutItems.append( item );
+        }
 
-        sortedChildren.insert( i, item );
+        // TODO: check the Joliet charset
     }
 
+    //
+    // check if the directory contains items with the same name
+    //
     if( isoOptions().createJoliet() || isoOptions().createRockRidge() ) {
-        QList<K3b::DataItem*> sameNameList;
-        while( !sortedChildren.isEmpty() ) {
-
-            sameNameList.clear();
-
-            do {
-                sameNameList.append( sortedChildren.takeFirst() );
-            } while( !sortedChildren.isEmpty() &&
-                     sortedChildren.first()->writtenName() == sameNameList.first()->writtenName() );
-
-            if( sameNameList.count() > 1 ) {
-                // now we need to rename the items
-                unsigned int maxlen = 255;
-                if( isoOptions().createJoliet() ) {
-                    if( isoOptions().jolietLong() )
-                        maxlen = 103;
-                    else
-                        maxlen = 64;
-                }
+        // stable sort to keep the items with the same name in the order of the project
+        std::stable_sort( sortedChildren.begin(), sortedChildren.end(),
+                          []( const K3b::DataItem* a, const K3b::DataItem* b ) {
+                              return a->writtenName() < b->writtenName();
+                          } );
+
+        // now we need to rename the items
+        unsigned int maxlen = 255;
+        if( isoOptions().createJoliet() )
+            maxlen = maxJolietLen;
 
+        int i = 0;
+        while( i < sortedChildren.count() ) {
+            const QString name = sortedChildren.at( i )->writtenName();
+            int sameNameEnd = i + 1;
+            while( sameNameEnd < sortedChildren.count() &&
+                   sortedChildren.at( sameNameEnd )->writtenName() == name )
+                ++sameNameEnd;
+
+            if( sameNameEnd - i > 1 ) {
                 int cnt = 1;
-                Q_FOREACH( K3b::DataItem* item, sameNameList ) {
+                for( ; i < sameNameEnd; ++i ) {
+                    K3b::DataItem* item = sortedChildren.at( i );
                     item->setWrittenName( K3b::appendNumberToFilename( item->writtenName(), cnt++, maxlen ) );
                 }
             }
+
+            i = sameNameEnd;
         }
     }
 }
@@ -1418,6 +1954,9 @@ void K3b::DataDoc::clearImportedSession()
 
     d->multisessionMode = AUTO;
 
+    // the folders of the imported session have become normal folders
+    d->isoSizeCalculator->invalidateAll();
+
     emit changed();
     emit importedSessionChanged( importedSession() );
 }
@@ -19,15 +19,20 @@
 class QString;
 class QDomDocument;
 class QDomElement;
+class QXmlStreamReader;
+class QXmlStreamWriter;
 
 namespace K3b {
     class DataItem;
+    class FileItem;
     class RootItem;
     class DirItem;
     class Job;
     class BootItem;
     class Iso9660Directory;
     class IsoOptions;
+    class IsoSizeCalculator;
+    class FileStatCache;
 
     namespace Device {
         class Device;
@@ -124,6 +129,36 @@ namespace K3b {
         const IsoOptions& isoOptions() const;
         void setIsoOptions( const IsoOptions& isoOptions );
 
+        /**
+         * The in-process image size calculator which is kept up to date
+         * with the changes made to the project.
+         */
+        IsoSizeCalculator* isoSizeCalculator() const;
+
+        /**
+         * The cache of the state of the local files used by the checks done
+         * before writing the project.
+         */
+        FileStatCache* fileStatCache() const;
+
+        /**
+         * Loading a project creates UNRESOLVED file items whose local files
+         * are checked in the background. Until then they have a size of 0.
+         *
+         * Blocks until all of them have been checked and updated. Missing
+         * and unreadable files are removed from the project.
+         */
+        void waitForFileResolution();
+
+        /**
+         * Used by FileItem to share the folder part of the local paths between
+         * all items of the project instead of storing it once per item.
+         *
+         * \return a string equal to @p dir which shares its data with the
+         *         strings returned for the same folder before.
+         */
+        QString sharedLocalDir( const QString& dir );
+
         QList<BootItem*> bootImages();
         DataItem* bootCataloge();
 
@@ -230,6 +265,10 @@ namespace K3b {
         bool loadDocumentData( QDomElement* root ) override;
         /** reimplemented from Doc */
         bool saveDocumentData( QDomElement* ) override;
+        /** reimplemented from Doc */
+        bool loadDocumentStream( QXmlStreamReader& reader ) override;
+        /** reimplemented from Doc */
+        bool saveDocumentStream( QXmlStreamWriter& writer ) override;
 
         void saveDocumentDataOptions( QDomElement& optionsElem );
         void saveDocumentDataHeader( QDomElement& headerElem );
@@ -237,7 +276,12 @@ namespace K3b {
         bool loadDocumentDataHeader( QDomElement optionsElem );
 
     private:
-        void prepareFilenamesInDir( DirItem* dir );
+        /**
+         * Prepares the written names of the children of @p dir. Only touches
+         * the children of @p dir, so it can be run for several directories
+         * in parallel. Items whose names have been cut are appended to @p cutItems.
+         */
+        void prepareFilenamesInDir( DirItem* dir, QList<DataItem*>& cutItems );
         void createSessionImportItems( const Iso9660Directory*, DirItem* parent );
 
         /**
@@ -248,6 +292,11 @@ namespace K3b {
         void beginRemoveItems( DirItem* parent, int start, int end );
         void endRemoveItems( DirItem* parent, int start, int end );
 
+        /**
+         * used by DataItem to inform about changed names and hiding settings.
+         */
+        void itemChanged( DataItem* item );
+
         /**
          * load recursively
          */
@@ -257,12 +306,38 @@ namespace K3b {
          */
         void saveDataItem( DataItem* item, QDomDocument* doc, QDomElement* parent );
 
+        /**
+         * Streaming versions of loadDataItem() and saveDataItem() which handle
+         * files and folders directly and use the DOM based versions for the
+         * few special items.
+         */
+        bool loadDataItem( QXmlStreamReader& reader, DirItem* parent );
+        void saveDataItem( DataItem* item, QXmlStreamWriter& writer );
+
+        /**
+         * Create the items of the files collected by the streaming loadDataItem().
+         * The items are UNRESOLVED, their local files are checked in the
+         * background once they have been added, see resolveFiles().
+         */
+        void loadPendingFiles();
+
+        /**
+         * Used by endInsertItems() to check the local files of UNRESOLVED
+         * items. The files are stat'ed in parallel batches in a background
+         * thread. handleResolvedFiles() then updates the items and the project
+         * size in the GUI thread.
+         */
+        void resolveFiles( const QList<FileItem*>& items );
+        void startFileResolution();
+        void handleResolvedFiles();
+
         void informAboutNotFoundFiles();
 
         class Private;
         Private* d;
 
         friend class MixedDoc;
+        friend class DataItem;
         friend class DirItem;
     };
 }
@@ -17,41 +17,50 @@
 class K3b::DataItem::Private
 {
 public:
-    K3b::DataItem::ItemFlags flags;
+    // null if equal to the K3b name
+    QString writtenName;
+    QString rawIsoName;
+
+    QString extraInfo;
 };
 
 
 K3b::DataItem::DataItem( const ItemFlags& flags )
-    : m_parentDir(0),
+    : d( 0 ),
+      m_parentDir(0),
       m_sortWeight(0),
+      m_flags( int( flags ) ),
       m_bHideOnRockRidge(false),
       m_bHideOnJoliet(false),
       m_bRemoveable(true),
       m_bRenameable(true),
       m_bMovable(true),
       m_bHideable(true),
-      m_bWriteToCd(true)
+      m_bWriteToCd(true),
+      m_bWrittenNameSet(false),
+      m_bIso9660NameSet(false)
 {
-    d = new Private;
-    d->flags = flags;
 }
 
 
 K3b::DataItem::DataItem( const K3b::DataItem& item )
     : m_k3bName( item.m_k3bName ),
-      m_extraInfo( item.m_extraInfo ),
+      d( 0 ),
       m_parentDir( 0 ),
       m_sortWeight( item.m_sortWeight ),
+      m_flags( item.m_flags ),
       m_bHideOnRockRidge( item.m_bHideOnRockRidge ),
       m_bHideOnJoliet( item.m_bHideOnJoliet ),
       m_bRemoveable( item.m_bRemoveable ),
       m_bRenameable( item.m_bRenameable ),
       m_bMovable( item.m_bMovable ),
       m_bHideable( item.m_bHideable ),
-      m_bWriteToCd( item.m_bWriteToCd )
+      m_bWriteToCd( item.m_bWriteToCd ),
+      m_bWrittenNameSet( false ),
+      m_bIso9660NameSet( false )
 {
-    d = new Private;
-    d->flags = item.d->flags;
+    if( item.d && !item.d->extraInfo.isEmpty() )
+        data()->extraInfo = item.d->extraInfo;
 }
 
 
@@ -61,51 +70,120 @@ K3b::DataItem::~DataItem()
 }
 
 
-const K3b::DataItem::ItemFlags& K3b::DataItem::flags() const
+K3b::DataItem::Private* K3b::DataItem::data()
+{
+    if( !d )
+        d = new Private;
+    return d;
+}
+
+
+K3b::DataItem::ItemFlags K3b::DataItem::flags() const
 {
-   return d->flags;
+   return ItemFlags( QFlag( m_flags ) );
 }
 
 
 void K3b::DataItem::setFlags( const ItemFlags& flags )
 {
-    d->flags = flags;
+    m_flags = int( flags );
 }
 
 
 bool K3b::DataItem::isDir() const
 {
-   return d->flags & DIR;
+   return m_flags & DIR;
 }
 
 
 bool K3b::DataItem::isFile() const
 {
-   return d->flags & FILE;
+   return m_flags & FILE;
 }
 
 
 bool K3b::DataItem::isSpecialFile() const
 {
-   return d->flags & SPECIALFILE;
+   return m_flags & SPECIALFILE;
 }
 
 
 bool K3b::DataItem::isSymLink() const
 {
-   return d->flags & SYMLINK;
+   return m_flags & SYMLINK;
 }
 
 
 bool K3b::DataItem::isFromOldSession() const
 {
-   return d->flags & OLD_SESSION;
+   return m_flags & OLD_SESSION;
 }
 
 
 bool K3b::DataItem::isBootItem() const
 {
-   return d->flags & BOOT_IMAGE;
+   return m_flags & BOOT_IMAGE;
+}
+
+
+QString K3b::DataItem::writtenName() const
+{
+    if( !m_bWrittenNameSet )
+        return QString();
+    else if( d && !d->writtenName.isNull() )
+        return d->writtenName;
+    else
+        return m_k3bName;
+}
+
+
+void K3b::DataItem::setWrittenName( const QString& s )
+{
+    m_bWrittenNameSet = !s.isNull();
+    if( s.isNull() || s == m_k3bName ) {
+        if( d )
+            d->writtenName.clear();
+    }
+    else {
+        data()->writtenName = s;
+    }
+}
+
+
+QString K3b::DataItem::iso9660Name() const
+{
+    if( !m_bIso9660NameSet )
+        return QString();
+    else if( d && !d->rawIsoName.isNull() )
+        return d->rawIsoName;
+    else
+        return m_k3bName;
+}
+
+
+void K3b::DataItem::setIso9660Name( const QString& s )
+{
+    m_bIso9660NameSet = !s.isNull();
+    if( s.isNull() || s == m_k3bName ) {
+        if( d )
+            d->rawIsoName.clear();
+    }
+    else {
+        data()->rawIsoName = s;
+    }
+}
+
+
+QString K3b::DataItem::extraInfo() const
+{
+    return d ? d->extraInfo : QString();
+}
+
+
+void K3b::DataItem::setExtraInfo( const QString& i )
+{
+    if( d || !i.isEmpty() )
+        data()->extraInfo = i;
 }
 
 
@@ -153,9 +231,20 @@ void K3b::DataItem::setK3bName( const QString& name ) {
             }
         }
 
+        // the written names stay valid until the next DataDoc::prepareFilenames()
+        if( m_bWrittenNameSet && ( !d || d->writtenName.isNull() ) )
+            data()->writtenName = m_k3bName;
+        if( m_bIso9660NameSet && ( !d || d->rawIsoName.isNull() ) )
+            data()->rawIsoName = m_k3bName;
+
+        const QString oldName = m_k3bName;
         m_k3bName = name;
 
+        if( parent() )
+            parent()->updateChildName( this, oldName );
+
         if( DataDoc* doc = getDoc() ) {
+            doc->itemChanged( this );
             doc->setModified();
         }
     }
@@ -262,6 +351,16 @@ bool K3b::DataItem::hideOnJoliet() const
 }
 
 
+void K3b::DataItem::setWriteToCd( bool b )
+{
+    if( b != m_bWriteToCd ) {
+        m_bWriteToCd = b;
+        if( DataDoc* doc = getDoc() )
+            doc->itemChanged( this );
+    }
+}
+
+
 void K3b::DataItem::setHideOnRockRidge( bool b )
 {
     // there is no use in changing the value if
@@ -270,6 +369,7 @@ void K3b::DataItem::setHideOnRockRidge( bool b )
         b != m_bHideOnRockRidge ) {
         m_bHideOnRockRidge = b;
         if( DataDoc* doc = getDoc() ) {
+            doc->itemChanged( this );
             doc->setModified();
         }
     }
@@ -32,7 +32,8 @@ namespace K3b {
             SPECIALFILE = 0x4,
             SYMLINK = 0x8,
             OLD_SESSION = 0x10,
-            BOOT_IMAGE = 0x20
+            BOOT_IMAGE = 0x20,
+            UNRESOLVED = 0x40   // a loaded file whose local state has not been checked yet
         };
         Q_DECLARE_FLAGS( ItemFlags, ItemFlag )
         
@@ -80,14 +81,14 @@ namespace K3b {
          *
          * This is only valid after a call to @p DataDoc::prepareFilenames()
          */
-        QString writtenName() const { return m_writtenName; }
+        QString writtenName() const;
 
         /**
          * \return the pure name used in the Iso9660 tree.
          *
          * This is only valid after a call to @p DataDoc::prepareFilenames()
          */
-        QString iso9660Name() const { return m_rawIsoName; }
+        QString iso9660Name() const;
 
         /**
          * Returns the path of the item as written to the CD or DVD image.
@@ -103,12 +104,12 @@ namespace K3b {
         /**
          * Used to set the written name by @p DataDoc::prepareFilenames()
          */
-        void setWrittenName( const QString& s ) { m_writtenName = s; }
+        void setWrittenName( const QString& s );
 
         /**
          * Used to set the pure Iso9660 name by @p DataDoc::prepareFilenames()
          */
-        void setIso9660Name( const QString& s ) { m_rawIsoName = s; }
+        void setIso9660Name( const QString& s );
 
         virtual DataItem* nextSibling() const;
 
@@ -133,7 +134,7 @@ namespace K3b {
 
         virtual void reparent( DirItem* );
 
-        const ItemFlags& flags() const;
+        ItemFlags flags() const;
         bool isDir() const;
         bool isFile() const;
         bool isSpecialFile() const;
@@ -161,7 +162,7 @@ namespace K3b {
         virtual bool isRenameable() const { return m_bRenameable; }
         virtual bool isHideable() const { return m_bHideable; }
         virtual bool writeToCd() const { return m_bWriteToCd; }
-        virtual QString extraInfo() const { return m_extraInfo; }
+        virtual QString extraInfo() const;
 
         /**
          * Default implementation returns the default mimetype.
@@ -172,8 +173,8 @@ namespace K3b {
         void setMoveable( bool b ) { m_bMovable = b; }
         void setRemoveable( bool b ) { m_bRemoveable = b; }
         void setHideable( bool b ) { m_bHideable = b; }
-        void setWriteToCd( bool b ) { m_bWriteToCd = b; }
-        void setExtraInfo( const QString& i ) { m_extraInfo = i; }
+        void setWriteToCd( bool b );
+        void setExtraInfo( const QString& i );
 
     protected:
         virtual KIO::filesize_t itemSize( bool followSymlinks ) const = 0;
@@ -193,24 +194,29 @@ namespace K3b {
         void setParentDir( DirItem* parentDir ) { m_parentDir = parentDir; }
 
     private:
+        /**
+         * Projects may contain millions of items. Thus, the rarely used
+         * strings are only allocated when set and the written and Iso9660
+         * names are only stored if they differ from the K3b name.
+         */
         class Private;
         Private* d;
-
-        QString m_writtenName;
-        QString m_rawIsoName;
-        QString m_extraInfo;
+        Private* data();
 
         DirItem* m_parentDir;
         long m_sortWeight;
 
-        bool m_bHideOnRockRidge;
-        bool m_bHideOnJoliet;
-        bool m_bRemoveable;
-        bool m_bRenameable;
-        bool m_bMovable;
-        bool m_bHideable;
-        bool m_bWriteToCd;
-        
+        uint m_flags : 7;
+        uint m_bHideOnRockRidge : 1;
+        uint m_bHideOnJoliet : 1;
+        uint m_bRemoveable : 1;
+        uint m_bRenameable : 1;
+        uint m_bMovable : 1;
+        uint m_bHideable : 1;
+        uint m_bWriteToCd : 1;
+        uint m_bWrittenNameSet : 1;
+        uint m_bIso9660NameSet : 1;
+
         friend class DirItem;
     };
 }
@@ -179,6 +179,9 @@ void K3b::DataJob::prepareWriting()
         m_isoImager->setMultiSessionInfo( QString(), 0 );
     }
 
+    // when writing an image file first the size is taken from the written file
+    m_isoImager->setExactSizeRequired( d->doc->onTheFly() && !d->doc->onlyCreateImages() );
+
     d->initializingImager = true;
     m_isoImager->init();
 }
@@ -372,6 +375,7 @@ void K3b::DataJob::slotIsoImagerFinished( bool success )
             if( success ) {
                 emit infoMessage( i18n("Image successfully created in %1", d->doc->tempDir()), K3b::Job::MessageSuccess );
                 d->imageFinished = true;
+                m_isoImager->setSize( d->imageFile.size() / 2048 );
 
                 if( d->doc->onlyCreateImages() ) {
                     jobFinished( true );
@@ -10,13 +10,12 @@
 #include "k3bthread.h"
 #include "k3bdiritem.h"
 #include "k3bfileitem.h"
+#include "k3bfilestatcache.h"
 #include "k3bglobals.h"
 #include "k3b_i18n.h"
 
 #include <KStringHandler>
 
-#include <QFile>
-#include <QFileInfo>
 #include <QList>
 
 namespace {
@@ -41,6 +40,16 @@ namespace {
 
         return s;
     }
+
+    // collects all items below @p dir in the same order DataItem::nextSibling() would
+    void collectItems( K3b::DirItem* dir, QList<K3b::DataItem*>& items )
+    {
+        Q_FOREACH( K3b::DataItem* item, dir->children() ) {
+            items.append( item );
+            if( item->isDir() )
+                collectItems( static_cast<K3b::DirItem*>( item ), items );
+        }
+    }
 }
 
 
@@ -101,21 +110,29 @@ bool K3b::DataPreparationJob::run()
     //
     // Check for missing files and folder symlinks
     //
-    K3b::DataItem* item = d->doc->root();
-    while( (item = item->nextSibling()) ) {
+    // DataItem::nextSibling() needs to search the item in its parent which
+    // makes it slow for big directories. Thus, we collect the items first.
+    QList<K3b::DataItem*> items;
+    collectItems( d->doc->root(), items );
+
+    // stat all files at once, the results are reused by the IsoImager
+    K3b::FileStatCache* statCache = d->doc->fileStatCache();
+    statCache->scan( d->doc->root() );
+
+    Q_FOREACH( K3b::DataItem* item, items ) {
 
         if( item->isSymLink() ) {
             if( d->doc->isoOptions().followSymbolicLinks() ) {
-                QFileInfo f( K3b::resolveLink( item->localPath() ) );
-                if( !f.exists() ) {
+                const K3b::FileStatCache::Info info = statCache->info( item );
+                if( !info.exists ) {
                     d->nonExistingItems.append( item );
                 }
-                else if( f.isDir() ) {
+                else if( info.isDir ) {
                     d->folderSymLinkItems.append( item );
                 }
             }
         }
-        else if( item->isFile() && !QFile::exists( item->localPath() ) ) {
+        else if( item->isFile() && !statCache->info( item ).exists ) {
             d->nonExistingItems.append( item );
         }
 
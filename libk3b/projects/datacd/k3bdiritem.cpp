@@ -52,11 +52,11 @@ K3b::DirItem::~DirItem()
     // auto-delete feature since some of the items' destructors
     // may change the list
     while( !m_children.isEmpty() ) {
-        // it is important to use takeDataItem here to be sure
-        // the size gets updated properly
-        K3b::DataItem* item = m_children.first();
-        takeDataItem( item );
-        delete item;
+        // it is important to use takeDataItems here to be sure
+        // the size gets updated properly. Taking all children at
+        // once keeps removing large folders cheap.
+        Children items = takeDataItems( 0, m_children.count() );
+        qDeleteAll( items );
     }
 
     // this has to be done after deleting the children
@@ -167,6 +167,8 @@ K3b::DirItem::Children K3b::DirItem::takeDataItems( int start, int count )
     Children takenItems;
 
     if( start >= 0 && count > 0 ) {
+        takenItems.reserve( count );
+
         if( DataDoc* doc = getDoc() ) {
             doc->beginRemoveItems( this, start, start+count-1 );
         }
@@ -180,9 +182,7 @@ K3b::DirItem::Children K3b::DirItem::takeDataItems( int start, int count )
                 updateFiles( -1, 0 );
 
             item->setParentDir( 0 );
-
-            // unset OLD_SESSION flag if it was the last child from previous sessions
-            updateOldSessionFlag();
+            m_childrenByName.remove( item->k3bName(), item );
 
             takenItems.append( item );
         }
@@ -196,6 +196,9 @@ K3b::DirItem::Children K3b::DirItem::takeDataItems( int start, int count )
             m_children.pop_back();
         }
 
+        // unset OLD_SESSION flag if it was the last child from previous sessions
+        updateOldSessionFlag();
+
         // inform the doc
         if( DataDoc* doc = getDoc() ) {
             doc->endRemoveItems( this, start, start+count-1 );
@@ -243,11 +246,15 @@ bool K3b::DirItem::alreadyInDirectory( const QString& filename ) const
 
 K3b::DataItem* K3b::DirItem::find( const QString& filename ) const
 {
-    Q_FOREACH( K3b::DataItem* item, m_children ) {
-        if( item->k3bName() == filename )
-            return item;
+    // In case several items share the same name return the one added first.
+    // QMultiHash iterates the values of one key starting with the most recent one.
+    K3b::DataItem* item = 0;
+    QMultiHash<QString, DataItem*>::const_iterator it = m_childrenByName.constFind( filename );
+    while( it != m_childrenByName.constEnd() && it.key() == filename ) {
+        item = it.value();
+        ++it;
     }
-    return 0;
+    return item;
 }
 
 
@@ -438,7 +445,7 @@ bool K3b::DirItem::canAddDataItem( DataItem* item ) const
     if( dirItem && dirItem->isSubItem( this ) ) {
         qDebug() << "(K3b::DirItem) trying to move a dir item down in it's own tree.";
         return false;
-    } else if( !item || m_children.contains( item ) ) {
+    } else if( !item || item->parent() == this ) {
         return false;
     } else {
         return true;
@@ -475,6 +482,7 @@ void K3b::DirItem::addDataItemImpl( DataItem* item )
     }
 
     m_children.append( item );
+    m_childrenByName.insert( item->k3bName(), item );
     updateSize( item, false );
     if( item->isDir() )
         updateFiles( ((DirItem*)item)->numFiles(), ((DirItem*)item)->numDirs()+1 );
@@ -490,6 +498,13 @@ void K3b::DirItem::addDataItemImpl( DataItem* item )
 }
 
 
+void K3b::DirItem::updateChildName( DataItem* item, const QString& oldName )
+{
+    m_childrenByName.remove( oldName, item );
+    m_childrenByName.insert( item->k3bName(), item );
+}
+
+
 K3b::RootItem::RootItem( K3b::DataDoc& doc )
     : K3b::DirItem( "root" ),
       m_doc( doc )
@@ -14,6 +14,7 @@
 #include <KIO/Global>
 
 #include <QList>
+#include <QMultiHash>
 #include <QString>
 
 namespace K3b {
@@ -118,8 +119,16 @@ namespace K3b {
         bool canAddDataItem( DataItem* item ) const;
         void addDataItemImpl( DataItem* item );
 
+        /**
+         * Called by DataItem::setK3bName to keep the name index in sync.
+         */
+        void updateChildName( DataItem* item, const QString& oldName );
+
         mutable Children m_children;
 
+        // index of the children by k3bName for fast lookups in find()
+        QMultiHash<QString, DataItem*> m_childrenByName;
+
         // size of the items simply added
         KIO::filesize_t m_size;
         KIO::filesize_t m_followSymlinksSize;
@@ -134,6 +143,9 @@ namespace K3b {
         // HACK: store the original path to be able to use it's permissions
         //       remove this once we have a backup project
         QString m_localPath;
+
+        friend class DataItem;
+        friend class FileItem;
     };
 
 
@@ -8,8 +8,7 @@
 
 #include <QDebug>
 #include <QFile>
-#include <QMap>
-#include <QList>
+#include <QHash>
 
 
 // TODO: remove the items from the project if the savedSize differs
@@ -59,8 +58,6 @@ public:
      * In an iso9660 filesystem a file occupies complete blocks of 2048 bytes.
      */
     K3b::Msf blocks() const { return K3b::Msf( usedBlocks(savedSize) ); }
-
-    QList<K3b::DataItem*> items;
 };
 
 
@@ -80,8 +77,6 @@ public:
     void addFile( K3b::FileItem* item, bool followSymlinks ) {
         InodeInfo& inodeInfo = inodeMap[item->localId(followSymlinks)];
 
-        inodeInfo.items.append( item );
-
         if( inodeInfo.number == 0 ) {
             inodeInfo.savedSize = item->itemSize( followSymlinks );
 
@@ -97,56 +92,44 @@ public:
         // so we just add their k3bSize
         size += item->size();
         blocks += usedBlocks(item->size());
-        specialItems.append( item );
     }
 
     void removeFile( K3b::FileItem* item, bool followSymlinks ) {
-        InodeInfo& inodeInfo = inodeMap[item->localId(followSymlinks)];
+        QHash<K3b::FileItem::Id, InodeInfo>::iterator it = inodeMap.find( item->localId(followSymlinks) );
+        if( it == inodeMap.end() ) {
+            qCritical() << "(K3b::FileCompilationSizeHandler) no inode info for "
+                     << item->localPath() << Qt::endl;
+            return;
+        }
 
-        if( !inodeInfo.items.contains( item ) ) {
-            qCritical() << "(K3b::FileCompilationSizeHandler) "
-                     << item->localPath()
-                     << " has been removed without being added!" << Qt::endl;
+        InodeInfo& inodeInfo = *it;
+        if( item->itemSize(followSymlinks) != inodeInfo.savedSize ) {
+            qCritical() << "(K3b::FileCompilationSizeHandler) savedSize differs!" << Qt::endl;
         }
-        else {
-            if( item->itemSize(followSymlinks) != inodeInfo.savedSize ) {
-                qCritical() << "(K3b::FileCompilationSizeHandler) savedSize differs!" << Qt::endl;
-            }
-
-            inodeInfo.items.removeOne( item );
-            inodeInfo.number--;
-            if( inodeInfo.number == 0 ) {
-                size -= inodeInfo.savedSize;
-                blocks -= inodeInfo.blocks();
-            }
+
+        inodeInfo.number--;
+        if( inodeInfo.number == 0 ) {
+            size -= inodeInfo.savedSize;
+            blocks -= inodeInfo.blocks();
+            inodeMap.erase( it );
         }
     }
 
     void removeSpecialItem( K3b::DataItem* item ) {
         // special files do not have a corresponding local file
         // so we just subtract their k3bSize
-        if( !specialItems.contains( item ) ) {
-            qCritical() << "(K3b::FileCompilationSizeHandler) Special item "
-                     << item->k3bName()
-                     << " has been removed without being added!" << Qt::endl;
-        }
-        else {
-            specialItems.removeOne( item );
-            size -= item->size();
-            blocks -= usedBlocks(item->size());
-        }
+        size -= item->size();
+        blocks -= usedBlocks(item->size());
     }
 
 
     /**
      * This maps from inodes to the number of occurrences of the inode.
      */
-    QMap<K3b::FileItem::Id, InodeInfo> inodeMap;
+    QHash<K3b::FileItem::Id, InodeInfo> inodeMap;
 
     KIO::filesize_t size;
     K3b::Msf blocks;
-
-    QList<K3b::DataItem*> specialItems;
 };
 
 
@@ -184,11 +167,22 @@ const K3b::Msf& K3b::FileCompilationSizeHandler::blocks( bool followSymlinks ) c
 
 void K3b::FileCompilationSizeHandler::addFile( K3b::DataItem* item )
 {
+    if( !item->isSpecialFile() && !item->isFile() )
+        return;
+
+    if( m_items.contains( item ) ) {
+        qCritical() << "(K3b::FileCompilationSizeHandler) "
+                    << item->k3bName()
+                    << " has been added twice!" << Qt::endl;
+        return;
+    }
+    m_items.insert( item );
+
     if( item->isSpecialFile() ) {
         d_symlinks->addSpecialItem( item );
         d_noSymlinks->addSpecialItem( item );
     }
-    else if( item->isFile() ) {
+    else {
         K3b::FileItem* fileItem = static_cast<K3b::FileItem*>( item );
         d_symlinks->addFile( fileItem, false );
         d_noSymlinks->addFile( fileItem, true );
@@ -198,11 +192,21 @@ void K3b::FileCompilationSizeHandler::addFile( K3b::DataItem* item )
 
 void K3b::FileCompilationSizeHandler::removeFile( K3b::DataItem* item )
 {
+    if( !item->isSpecialFile() && !item->isFile() )
+        return;
+
+    if( !m_items.remove( item ) ) {
+        qCritical() << "(K3b::FileCompilationSizeHandler) "
+                    << item->k3bName()
+                    << " has been removed without being added!" << Qt::endl;
+        return;
+    }
+
     if( item->isSpecialFile() ) {
         d_symlinks->removeSpecialItem( item );
         d_noSymlinks->removeSpecialItem( item );
     }
-    else if( item->isFile() ) {
+    else {
         K3b::FileItem* fileItem = static_cast<K3b::FileItem*>( item );
         d_symlinks->removeFile( fileItem, false );
         d_noSymlinks->removeFile( fileItem, true );
@@ -210,8 +214,29 @@ void K3b::FileCompilationSizeHandler::removeFile( K3b::DataItem* item )
 }
 
 
+void K3b::FileCompilationSizeHandler::addFiles( const QList<K3b::DataItem*>& items )
+{
+    m_items.reserve( m_items.size() + items.size() );
+    d_symlinks->inodeMap.reserve( d_symlinks->inodeMap.size() + items.size() );
+    d_noSymlinks->inodeMap.reserve( d_noSymlinks->inodeMap.size() + items.size() );
+
+    Q_FOREACH( K3b::DataItem* item, items ) {
+        addFile( item );
+    }
+}
+
+
+void K3b::FileCompilationSizeHandler::removeFiles( const QList<K3b::DataItem*>& items )
+{
+    Q_FOREACH( K3b::DataItem* item, items ) {
+        removeFile( item );
+    }
+}
+
+
 void K3b::FileCompilationSizeHandler::clear()
 {
+    m_items.clear();
     d_symlinks->clear();
     d_noSymlinks->clear();
 }
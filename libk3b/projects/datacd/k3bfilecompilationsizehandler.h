@@ -9,6 +9,9 @@
 #include "k3bmsf.h"
 #include <KIO/Global>
 
+#include <QList>
+#include <QSet>
+
 namespace K3b {
     class DataItem;
 
@@ -51,12 +54,29 @@ namespace K3b {
          */
         void removeFile( DataItem* );
 
+        /**
+         * Same as calling addFile() for all @p items but reserves
+         * the needed space in advance.
+         */
+        void addFiles( const QList<DataItem*>& items );
+
+        /**
+         * Same as calling removeFile() for all @p items.
+         */
+        void removeFiles( const QList<DataItem*>& items );
+
         void clear();
 
     private:
         class Private;
         Private* d_symlinks;
         Private* d_noSymlinks;
+
+        /**
+         * All items which have been added, used to detect items removed
+         * without being added before.
+         */
+        QSet<DataItem*> m_items;
     };
 }
 
@@ -15,16 +15,89 @@
 #include <QDebug>
 #include <QFile>
 #include <QFileInfo>
+#include <QHash>
 #include <QMimeDatabase>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QRegularExpression>
 #include <QString>
 #include <QStringList>
 #include <QUrl>
+#include <QVector>
 
 #include <errno.h>
 #include <string.h>
 
 
+namespace {
+    const int s_itemsPerChunk = 1024;
+
+    /**
+     * Hands out memory for FileItems from chunks of s_itemsPerChunk items.
+     * This saves the bookkeeping overhead of the allocator for each single
+     * item and makes deleting huge projects a lot faster. All chunks are
+     * released once the last item is gone.
+     */
+    class FileItemPool
+    {
+    public:
+        FileItemPool()
+            : freeList( 0 ),
+              used( s_itemsPerChunk ),
+              count( 0 ) {
+        }
+
+        ~FileItemPool() {
+            release();
+        }
+
+        void* allocate() {
+            QMutexLocker locker( &mutex );
+            ++count;
+            if( freeList ) {
+                void* p = freeList;
+                freeList = *static_cast<void**>( p );
+                return p;
+            }
+            if( used == s_itemsPerChunk ) {
+                chunks.append( static_cast<char*>( ::operator new( s_itemsPerChunk * sizeof( K3b::FileItem ) ) ) );
+                used = 0;
+            }
+            return chunks.last() + sizeof( K3b::FileItem ) * used++;
+        }
+
+        void deallocate( void* p ) {
+            QMutexLocker locker( &mutex );
+            if( --count == 0 ) {
+                release();
+            }
+            else {
+                *static_cast<void**>( p ) = freeList;
+                freeList = p;
+            }
+        }
+
+    private:
+        void release() {
+            Q_FOREACH( char* chunk, chunks ) {
+                ::operator delete( chunk );
+            }
+            chunks.clear();
+            freeList = 0;
+            used = s_itemsPerChunk;
+        }
+
+        QMutex mutex;
+        QVector<char*> chunks;
+        void* freeList;
+        int used;
+        int count;
+    };
+
+    Q_GLOBAL_STATIC( FileItemPool, s_fileItemPool )
+}
+
+
 bool K3b::operator==( const K3b::FileItem::Id& id1, const K3b::FileItem::Id& id2 )
 {
     return ( id1.device == id2.device && id1.inode == id2.inode );
@@ -46,11 +119,16 @@ bool K3b::operator>( const K3b::FileItem::Id& id1, const K3b::FileItem::Id& id2
 }
 
 
+size_t K3b::qHash( const K3b::FileItem::Id& id, size_t seed )
+{
+    return ::qHash( quint64( id.inode ), seed ) ^ ::qHash( quint64( id.device ) );
+}
+
+
 
 K3b::FileItem::FileItem( const QString& filePath, K3b::DataDoc& doc, const QString& k3bName, const ItemFlags& flags )
     : K3b::DataItem( flags | FILE ),
-      m_replacedItemFromOldSession(0),
-      m_localPath(filePath)
+      m_replacedItemFromOldSession(0)
 {
     k3b_struct_stat statBuf;
     k3b_struct_stat followedStatBuf;
@@ -83,8 +161,7 @@ K3b::FileItem::FileItem( const k3b_struct_stat* stat,
                           const k3b_struct_stat* followedStat,
                           const QString& filePath, K3b::DataDoc& doc, const QString& k3bName, const ItemFlags& flags )
     : K3b::DataItem( flags | FILE ),
-      m_replacedItemFromOldSession(0),
-      m_localPath(filePath)
+      m_replacedItemFromOldSession(0)
 {
     init( filePath, k3bName, doc, stat, followedStat );
 }
@@ -97,7 +174,8 @@ K3b::FileItem::FileItem( const K3b::FileItem& item )
       m_sizeFollowed( item.m_sizeFollowed ),
       m_id( item.m_id ),
       m_idFollowed( item.m_idFollowed ),
-      m_localPath( item.m_localPath ),
+      m_localDir( item.m_localDir ),
+      m_localName( item.m_localName ),
       m_mimeType( item.m_mimeType )
 {
 }
@@ -116,8 +194,39 @@ K3b::DataItem* K3b::FileItem::copy() const
 }
 
 
+void* K3b::FileItem::operator new( size_t size )
+{
+    // derived classes are rare and use the normal allocation
+    if( size != sizeof( K3b::FileItem ) )
+        return ::operator new( size );
+    else
+        return s_fileItemPool->allocate();
+}
+
+
+void K3b::FileItem::operator delete( void* p, size_t size )
+{
+    if( size != sizeof( K3b::FileItem ) )
+        ::operator delete( p );
+    else if( !s_fileItemPool.isDestroyed() )
+        s_fileItemPool->deallocate( p );
+}
+
+
+void K3b::FileItem::setK3bName( const QString& name )
+{
+    // the local name can no longer be derived from the K3b name
+    if( m_localName.isNull() )
+        m_localName = m_k3bName;
+
+    K3b::DataItem::setK3bName( name );
+}
+
+
 QMimeType K3b::FileItem::mimeType() const
 {
+    if( !m_mimeType.isValid() )
+        m_mimeType = QMimeDatabase().mimeTypeForFile( localPath() );
     return m_mimeType;
 }
 
@@ -163,7 +272,7 @@ QString K3b::FileItem::absIsoPath()
 
 QString K3b::FileItem::localPath() const
 {
-    return m_localPath;
+    return m_localDir + ( m_localName.isNull() ? m_k3bName : m_localName );
 }
 
 
@@ -247,11 +356,39 @@ void K3b::FileItem::init( const QString& filePath,
                           const k3b_struct_stat* stat,
                           const k3b_struct_stat* followedStat )
 {
+    const int pos = filePath.lastIndexOf( '/' );
+    const QString fileName = filePath.mid( pos + 1 );
+    m_localDir = doc.sharedLocalDir( filePath.left( pos + 1 ) );
+
     if( k3bName.isEmpty() )
-        m_k3bName = filePath.section( '/', -1 );
+        m_k3bName = fileName;
     else
         m_k3bName = k3bName;
 
+    if( m_k3bName != fileName )
+        m_localName = fileName;
+
+    if( flags().testFlag( UNRESOLVED ) ) {
+        // see resolve()
+        m_size = m_sizeFollowed = 0;
+        m_id.inode = m_idFollowed.inode = 0;
+        m_id.device = m_idFollowed.device = 0;
+    }
+    else {
+        initStat( filePath, &doc, stat, followedStat );
+    }
+
+    // add automagically like a qlistviewitem
+    if( parent() )
+        parent()->addDataItem( this );
+}
+
+
+void K3b::FileItem::initStat( const QString& filePath,
+                              DataDoc* doc,
+                              const k3b_struct_stat* stat,
+                              const k3b_struct_stat* followedStat )
+{
     if( stat != 0 ) {
         m_size = (KIO::filesize_t)stat->st_size;
         if( S_ISLNK(stat->st_mode) )
@@ -270,9 +407,11 @@ void K3b::FileItem::init( const QString& filePath,
         m_id.device = 0;
 
         // since we have no proper inode info, disable the inode caching in the doc
-        K3b::IsoOptions o( doc.isoOptions() );
-        o.setDoNotCacheInodes( true );
-        doc.setIsoOptions( o );
+        if( doc ) {
+            K3b::IsoOptions o( doc->isoOptions() );
+            o.setDoNotCacheInodes( true );
+            doc->setIsoOptions( o );
+        }
     }
 
     if( isSymLink() ) {
@@ -295,10 +434,24 @@ void K3b::FileItem::init( const QString& filePath,
         m_sizeFollowed = m_size;
         m_idFollowed = m_id;
     }
+}
 
-    m_mimeType = QMimeDatabase().mimeTypeForFile( filePath );
 
-    // add automagically like a qlistviewitem
-    if( parent() )
-        parent()->addDataItem( this );
+void K3b::FileItem::resolve( const k3b_struct_stat* stat, const k3b_struct_stat* followedStat )
+{
+    if( !flags().testFlag( UNRESOLVED ) )
+        return;
+
+    DirItem* dir = parent();
+    if( dir )
+        dir->updateSize( this, true );
+
+    ItemFlags newFlags = flags();
+    newFlags.setFlag( UNRESOLVED, false );
+    newFlags.setFlag( SYMLINK, false );
+    setFlags( newFlags );
+    initStat( localPath(), getDoc(), stat, followedStat );
+
+    if( dir )
+        dir->updateSize( this );
 }
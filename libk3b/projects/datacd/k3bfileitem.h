@@ -33,6 +33,9 @@ namespace K3b {
          * Constructor for optimized file item creation which does no additional stat.
          *
          * Used by K3b to speedup file item creation.
+         *
+         * If @p flags contain UNRESOLVED no stat is needed at all. The item
+         * has a size of 0 until resolve() is called.
          */
         FileItem( const k3b_struct_stat* stat,
                   const k3b_struct_stat* followedStat,
@@ -49,6 +52,21 @@ namespace K3b {
 
         DataItem* copy() const override;
 
+        /**
+         * File items are allocated in chunks from a pool since projects
+         * may contain millions of them.
+         */
+        static void* operator new( size_t size );
+        static void operator delete( void* p, size_t size );
+
+        void setK3bName( const QString& ) override;
+
+        /**
+         * Used by DataDoc to fill in the size, the inode ids and the symlink
+         * state of an UNRESOLVED item once the local file has been checked.
+         */
+        void resolve( const k3b_struct_stat* stat, const k3b_struct_stat* followedStat );
+
         bool exists() const;
 
         QString absIsoPath();
@@ -99,6 +117,10 @@ namespace K3b {
                    DataDoc& doc,
                    const k3b_struct_stat* stat,
                    const k3b_struct_stat* followedStat );
+        void initStat( const QString& filePath,
+                       DataDoc* doc,
+                       const k3b_struct_stat* stat,
+                       const k3b_struct_stat* followedStat );
 
     private:
         DataItem* m_replacedItemFromOldSession;
@@ -108,14 +130,22 @@ namespace K3b {
         Id m_id;
         Id m_idFollowed;
 
-        QString m_localPath;
+        /**
+         * The local path is split into the folder which is shared between all
+         * items of the project (see DataDoc::sharedLocalDir()) and the file name
+         * which is null as long as it equals the K3b name.
+         */
+        QString m_localDir;
+        QString m_localName;
 
-        QMimeType m_mimeType;
+        // determined on first use
+        mutable QMimeType m_mimeType;
     };
 
     bool operator==( const FileItem::Id&, const FileItem::Id& );
     bool operator<( const FileItem::Id&, const FileItem::Id& );
     bool operator>( const FileItem::Id&, const FileItem::Id& );
+    LIBK3B_EXPORT size_t qHash( const FileItem::Id& id, size_t seed = 0 );
 }
 
 #endif
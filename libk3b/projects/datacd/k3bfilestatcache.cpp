@@ -0,0 +1,212 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bfilestatcache.h"
+#include "k3bdiritem.h"
+#include "k3bfileitem.h"
+#include "k3bglobals.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+    // stat() mostly waits for the file system (or the network), so we use
+    // more threads than there are cores but do not flood the server
+    const int MAX_SCAN_THREADS = 16;
+
+    struct Entry {
+        Entry()
+            : device( 0 ),
+              inode( 0 ),
+              mtime( 0 ),
+              mode( 0 ) {
+        }
+
+        QString path;
+        dev_t device;
+        ino_t inode;
+        time_t mtime;
+        mode_t mode;
+        K3b::FileStatCache::Info info;
+    };
+
+
+    bool isValid( const K3b::FileItem::Id& id )
+    {
+        // FileItem uses a null id if it was not able to stat the file
+        return id.inode != 0 || id.device != 0;
+    }
+
+
+    /**
+     * Stat the file at entry.path. The access() call is skipped if @p old
+     * describes the same, unchanged file.
+     */
+    void statEntry( Entry& entry, const Entry* old )
+    {
+        const QByteArray encodedPath = QFile::encodeName( entry.path );
+        k3b_struct_stat st;
+        if( k3b_stat( encodedPath.constData(), &st ) == 0 ) {
+            entry.device = st.st_dev;
+            entry.inode = st.st_ino;
+            entry.mtime = st.st_mtime;
+            entry.mode = st.st_mode;
+            entry.info.exists = true;
+            entry.info.isDir = S_ISDIR( st.st_mode );
+            if( old && old->info.exists &&
+                old->device == entry.device &&
+                old->inode == entry.inode &&
+                old->mtime == entry.mtime &&
+                old->mode == entry.mode )
+                entry.info.readable = old->info.readable;
+            else
+                entry.info.readable = ( ::access( encodedPath.constData(), R_OK ) == 0 );
+        }
+        else {
+            entry.info = K3b::FileStatCache::Info();
+        }
+    }
+
+
+    void collectFileItems( K3b::DirItem* dir, QList<K3b::FileItem*>& items )
+    {
+        Q_FOREACH( K3b::DataItem* item, dir->children() ) {
+            if( item->isDir() )
+                collectFileItems( static_cast<K3b::DirItem*>( item ), items );
+            else if( K3b::FileItem* fileItem = dynamic_cast<K3b::FileItem*>( item ) )
+                items.append( fileItem );
+        }
+    }
+}
+
+
+class K3b::FileStatCache::Private
+{
+public:
+    QMutex mutex;
+    QHash<FileItem::Id, Entry> entries;
+};
+
+
+K3b::FileStatCache::FileStatCache()
+    : d( new Private() )
+{
+}
+
+
+K3b::FileStatCache::~FileStatCache()
+{
+    delete d;
+}
+
+
+void K3b::FileStatCache::scan( DirItem* dir )
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QList<FileItem*> items;
+    collectFileItems( dir, items );
+
+    // one stat per local file, even if it has been added several times
+    QHash<FileItem::Id, Entry> oldEntries;
+    {
+        QMutexLocker locker( &d->mutex );
+        oldEntries = d->entries;
+    }
+    QVector<Entry> newEntries;
+    QVector<const Entry*> previous;
+    QHash<FileItem::Id, int> index;
+    newEntries.reserve( items.count() );
+    previous.reserve( items.count() );
+    Q_FOREACH( FileItem* item, items ) {
+        const FileItem::Id id = item->localId( false );
+        if( isValid( id ) && !index.contains( id ) ) {
+            index.insert( id, newEntries.count() );
+            Entry entry;
+            entry.path = item->localPath();
+            newEntries.append( entry );
+            QHash<FileItem::Id, Entry>::const_iterator it = oldEntries.constFind( id );
+            previous.append( it != oldEntries.constEnd() && it->path == entry.path ? &it.value() : 0 );
+        }
+    }
+
+    Entry* entryData = newEntries.data();
+    const Entry* const* previousData = previous.constData();
+    const int count = newEntries.count();
+    statInParallel( count, [entryData, previousData]( int i ) {
+        statEntry( entryData[i], previousData[i] );
+    } );
+
+    QHash<FileItem::Id, Entry> entries;
+    entries.reserve( count );
+    for( QHash<FileItem::Id, int>::const_iterator it = index.constBegin(); it != index.constEnd(); ++it )
+        entries.insert( it.key(), newEntries.at( it.value() ) );
+
+    QMutexLocker locker( &d->mutex );
+    d->entries.swap( entries );
+
+    qDebug() << "(K3b::FileStatCache) checked" << count << "files in" << timer.elapsed() << "ms";
+}
+
+
+K3b::FileStatCache::Info K3b::FileStatCache::info( DataItem* item )
+{
+    FileItem* fileItem = dynamic_cast<FileItem*>( item );
+    const QString path = item->localPath();
+
+    if( fileItem ) {
+        const FileItem::Id id = fileItem->localId( false );
+        QMutexLocker locker( &d->mutex );
+        QHash<FileItem::Id, Entry>::const_iterator it = d->entries.constFind( id );
+        if( it != d->entries.constEnd() && it->path == path )
+            return it->info;
+    }
+
+    Entry entry;
+    entry.path = path;
+    statEntry( entry, 0 );
+    return entry.info;
+}
+
+
+void K3b::FileStatCache::clear()
+{
+    QMutexLocker locker( &d->mutex );
+    d->entries.clear();
+}
+
+
+void K3b::FileStatCache::statInParallel( int count, const std::function<void( int )>& statFile )
+{
+    const int threads = qMin( MAX_SCAN_THREADS, qMax( 4, QThread::idealThreadCount() * 2 ) );
+    if( count > 1 ) {
+        const int chunkSize = qMax( 1, count / ( threads * 4 ) );
+        QThreadPool pool;
+        pool.setMaxThreadCount( threads );
+        for( int start = 0; start < count; start += chunkSize ) {
+            const int end = qMin( start + chunkSize, count );
+            pool.start( [&statFile, start, end]() {
+                for( int i = start; i < end; ++i )
+                    statFile( i );
+            } );
+        }
+        pool.waitForDone();
+    }
+    else if( count == 1 ) {
+        statFile( 0 );
+    }
+}
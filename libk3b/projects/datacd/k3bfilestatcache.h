@@ -0,0 +1,83 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef _K3B_FILE_STAT_CACHE_H_
+#define _K3B_FILE_STAT_CACHE_H_
+
+#include <QtGlobal>
+
+#include <functional>
+
+
+namespace K3b {
+    class DataItem;
+    class DirItem;
+
+    /**
+     * Caches the state of the local files of a data project.
+     *
+     * Before writing a project DataPreparationJob and IsoImager both check
+     * that the local files still exist and are readable. For big projects,
+     * especially on network mounts, doing this serially file by file takes
+     * very long. scan() stats all files of the project at once using a
+     * bounded thread pool and info() answers from the cached results.
+     *
+     * The entries are keyed by FileItem::Id. A new scan only checks the
+     * permissions of files whose inode or modification time changed since
+     * the previous scan.
+     */
+    class FileStatCache
+    {
+    public:
+        struct Info {
+            Info()
+                : exists( false ),
+                  readable( false ),
+                  isDir( false ) {
+            }
+
+            bool exists;
+            bool readable;
+            bool isDir;
+        };
+
+        FileStatCache();
+        ~FileStatCache();
+
+        /**
+         * Stat the local files of all file items below @p dir. Symbolic
+         * links are followed, i.e. the cached info describes the link target.
+         *
+         * Blocks until all files have been checked.
+         */
+        void scan( DirItem* dir );
+
+        /**
+         * \return The state of the local file of @p item (or its target
+         *         in case of a symbolic link). Uses the result of the last
+         *         scan() if available and stats the file otherwise.
+         */
+        Info info( DataItem* item );
+
+        /**
+         * Drop all cached entries.
+         */
+        void clear();
+
+        /**
+         * Call @p statFile for the indices 0 to @p count - 1 from the same
+         * bounded thread pool scan() uses. Blocks until all calls returned.
+         */
+        static void statInParallel( int count, const std::function<void( int )>& statFile );
+
+    private:
+        class Private;
+        Private* const d;
+
+        Q_DISABLE_COPY( FileStatCache )
+    };
+}
+
+#endif
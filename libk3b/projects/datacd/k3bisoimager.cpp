@@ -19,6 +19,8 @@
 #include "k3bversion.h"
 #include "k3bfilesplitter.h"
 #include "k3bisooptions.h"
+#include "k3bisosizecalculator.h"
+#include "k3bfilestatcache.h"
 #include "k3b_i18n.h"
 
 #include <KIO/CopyJob>
@@ -28,6 +30,7 @@
 
 #include <QDebug>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QRegExp>
 #include <QStandardPaths>
@@ -59,6 +62,11 @@ public:
 
     bool knownError;
 
+    bool exactSizeRequired;
+
+    // size calculated by the IsoSizeCalculator or 0
+    int calculatedSize;
+
     K3b::DataPreparationJob* dataPreparationJob;
 };
 
@@ -77,6 +85,8 @@ K3b::IsoImager::IsoImager( K3b::DataDoc* doc, K3b::JobHandler* hdl, QObject* par
       m_mkisofsPrintSizeResult( 0 )
 {
     d = new Private();
+    d->exactSizeRequired = true;
+    d->calculatedSize = 0;
     d->dataPreparationJob = new K3b::DataPreparationJob( doc, this, this );
     connectSubJob( d->dataPreparationJob,
                    SLOT(slotDataPreparationDone(bool)),
@@ -244,6 +254,23 @@ void K3b::IsoImager::startSizeCalculation()
 
     initVariables();
 
+    d->calculatedSize = 0;
+    if( canCalculateSizeInProcess() ) {
+        QElapsedTimer timer;
+        timer.start();
+        d->calculatedSize = m_doc->isoSizeCalculator()->size().lba();
+        emit debuggingOutput( "K3b::IsoImager",
+                              QString("calculated image size: %1 (%2 ms)")
+                              .arg(d->calculatedSize)
+                              .arg(timer.elapsed()) );
+
+        if( d->calculatedSize > 0 && !d->exactSizeRequired ) {
+            m_mkisofsPrintSizeResult = d->calculatedSize;
+            jobFinished( true );
+            return;
+        }
+    }
+
     delete m_process;
     m_process = new K3b::Process( this );
     m_process->setSplitStdout(true);
@@ -351,6 +378,12 @@ void K3b::IsoImager::slotMkisofsPrintSizeFinished()
                           .arg(m_mkisofsPrintSizeResult)
                           .arg(quint64(m_mkisofsPrintSizeResult)*2048ULL) );
 
+    if( success && d->calculatedSize > 0 && d->calculatedSize != m_mkisofsPrintSizeResult ) {
+        emit debuggingOutput( "K3b::IsoImager",
+                              QString("calculated image size differs from mkisofs result by %1 sectors")
+                              .arg(d->calculatedSize - m_mkisofsPrintSizeResult) );
+    }
+
     cleanup();
 
 
@@ -366,6 +399,21 @@ void K3b::IsoImager::slotMkisofsPrintSizeFinished()
 }
 
 
+bool K3b::IsoImager::canCalculateSizeInProcess() const
+{
+    // importing a previous session and additional user parameters are out of our control
+    return( m_multiSessionInfo.isEmpty() &&
+            ( !d->mkisofsBin || d->mkisofsBin->userParameters().isEmpty() ) &&
+            m_doc->isoSizeCalculator()->canCalculate() );
+}
+
+
+void K3b::IsoImager::setExactSizeRequired( bool b )
+{
+    d->exactSizeRequired = b;
+}
+
+
 void K3b::IsoImager::initVariables()
 {
     m_containsFilesWithMultibleBackslashes = false;
@@ -757,24 +805,24 @@ int K3b::IsoImager::writePathSpecForDir( K3b::DirItem* dirItem, QTextStream& str
                 writeItem = false;
 
             else if( d->usedLinkHandling == Private::FOLLOW ) {
-                QFileInfo f( K3b::resolveLink( item->localPath() ) );
-                if( !f.exists() ) {
-                    emit infoMessage( i18n("Could not follow link %1 to non-existing file %2. Skipping...", item->k3bName(), f.filePath()), MessageWarning );
+                const K3b::FileStatCache::Info info = m_doc->fileStatCache()->info( item );
+                if( !info.exists ) {
+                    emit infoMessage( i18n("Could not follow link %1 to non-existing file %2. Skipping...", item->k3bName(), K3b::resolveLink( item->localPath() )), MessageWarning );
                     writeItem = false;
                 }
-                else if( f.isDir() ) {
-                    emit infoMessage( i18n("Ignoring link %1 to folder %2. K3b is unable to follow links to folders.", item->k3bName(), f.filePath()), MessageWarning );
+                else if( info.isDir ) {
+                    emit infoMessage( i18n("Ignoring link %1 to folder %2. K3b is unable to follow links to folders.", item->k3bName(), K3b::resolveLink( item->localPath() )), MessageWarning );
                     writeItem = false;
                 }
             }
         }
         else if( item->isFile() ) {
-            QFileInfo f( item->localPath() );
-            if( !f.exists() ) {
+            const K3b::FileStatCache::Info info = m_doc->fileStatCache()->info( item );
+            if( !info.exists ) {
                 emit infoMessage( i18n("Could not find file %1. Skipping...",item->localPath()), MessageWarning );
                 writeItem = false;
             }
-            else if( !f.isReadable() ) {
+            else if( !info.readable ) {
                 emit infoMessage( i18n("Could not read file %1. Skipping...",item->localPath()), MessageWarning );
                 writeItem = false;
             }
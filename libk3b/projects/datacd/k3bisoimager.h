@@ -10,6 +10,7 @@
 #include "k3bjob.h"
 #include "k3bmkisofshandler.h"
 #include "k3bprocess.h"
+#include "k3b_export.h"
 
 #include <QStringList>
 
@@ -21,7 +22,7 @@ namespace K3b {
     class DirItem;
     class FileItem;
 
-    class IsoImager : public Job, public MkisofsHandler
+    class LIBK3B_EXPORT IsoImager : public Job, public MkisofsHandler
     {
         Q_OBJECT
 
@@ -33,6 +34,23 @@ namespace K3b {
 
         int size() const { return m_mkisofsPrintSizeResult; }
 
+        /**
+         * Replace the calculated size with the size of the actually written
+         * image. Used by jobs which write an image file before burning it.
+         */
+        void setSize( int sectors ) { m_mkisofsPrintSizeResult = sectors; }
+
+        /**
+         * By default the image size is determined by running mkisofs with
+         * -print-size since on-the-fly writing needs the exact size. If
+         * this is set to false init() and calculateSize() use the in-process
+         * IsoSizeCalculator whenever the project settings allow it.
+         *
+         * If an exact size is required and the in-process calculation is possible
+         * both are done and the results are compared in the debugging output.
+         */
+        void setExactSizeRequired( bool b );
+
         bool hasBeenCanceled() const override;
 
         QIODevice* ioDevice() const;
@@ -132,6 +150,7 @@ namespace K3b {
 
     private:
         void startSizeCalculation();
+        bool canCalculateSizeInProcess() const;
 
         class Private;
         Private* d;
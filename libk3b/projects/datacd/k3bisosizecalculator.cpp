@@ -0,0 +1,485 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bisosizecalculator.h"
+#include "k3bdatadoc.h"
+#include "k3bdiritem.h"
+#include "k3bfileitem.h"
+#include "k3bisooptions.h"
+
+#include <QDebug>
+#include <QHash>
+#include <QSet>
+
+
+namespace {
+    const int SECTOR_SIZE = 2048;
+
+    // the system area preceding the volume descriptors
+    const int SYSTEM_AREA_SECTORS = 16;
+
+    // mkisofs pads the image to a multiple of 16 sectors and adds 150 sectors (-pad is the default)
+    const int PAD_SECTORS = 150;
+
+    // Rock Ridge System Use entries as written by mkisofs
+    const int RR_RR = 5;       // RRIP 1.09 "RR" entry
+    const int RR_PX = 36;      // POSIX file attributes
+    const int RR_TF = 26;      // modification, access, and attribute change time
+    const int RR_NM = 5;       // alternate name header
+    const int RR_SL = 5;       // symbolic link header
+    const int RR_SP = 7;       // SUSP indicator in the root "." entry
+    const int RR_CE = 28;      // continuation area pointer
+    const int RR_ER = 237;     // extension reference of the root "." entry (stored in the continuation area)
+
+    const int MAX_RECORD_LENGTH = 255;
+
+    int roundUp( qint64 bytes, int unit )
+    {
+        return ( bytes + unit - 1 ) / unit;
+    }
+
+
+    int recordLength( int nameLength, int suLength = 0 )
+    {
+        int len = 33 + nameLength;
+        if( len % 2 )
+            ++len;
+        len += suLength;
+        if( len % 2 )
+            ++len;
+        return len;
+    }
+
+
+    /**
+     * Directory records may not cross sector boundaries.
+     */
+    class DirectoryExtent
+    {
+    public:
+        DirectoryExtent() : m_bytes( 0 ) {}
+
+        void addRecord( int len ) {
+            if( m_bytes % SECTOR_SIZE + len > SECTOR_SIZE )
+                m_bytes = qint64( roundUp( m_bytes, SECTOR_SIZE ) ) * SECTOR_SIZE;
+            m_bytes += len;
+        }
+
+        int sectors() const { return qMax( 1, roundUp( m_bytes, SECTOR_SIZE ) ); }
+
+    private:
+        qint64 m_bytes;
+    };
+
+
+    int pathTableEntryLength( int nameLength )
+    {
+        return 8 + nameLength + ( nameLength % 2 );
+    }
+}
+
+
+class K3b::IsoSizeCalculator::Private
+{
+public:
+    enum LinkHandling {
+        KEEP_ALL,
+        FOLLOW,
+        DISCARD_ALL,
+        DISCARD_BROKEN
+    };
+
+    /**
+     * The cached values of one directory. The path table values
+     * contain the entries of all subdirectories since a directory's
+     * path table entry depends on its name in the parent.
+     */
+    struct DirInfo {
+        DirInfo()
+            : isoSectors( 0 ),
+              jolietSectors( 0 ),
+              pathTableBytes( 0 ),
+              jolietPathTableBytes( 0 ),
+              continuationBytes( 0 ),
+              hasLargeFiles( false ) {
+        }
+
+        int isoSectors;
+        int jolietSectors;
+        int pathTableBytes;
+        int jolietPathTableBytes;
+        int continuationBytes;
+        bool hasLargeFiles;
+    };
+
+    Private( DataDoc* d )
+        : doc( d ),
+          complete( false ) {
+    }
+
+    void init();
+    bool writeItem( DataItem* item ) const;
+    bool writeDir( DirItem* dir ) const;
+    int isoNameLength( const QString& name, bool isDir ) const;
+    int jolietNameLength( const QString& name, bool isDir ) const;
+    int rockRidgeLength( DataItem* item, int isoLength, int& continuationBytes ) const;
+    void calculateDir( DirItem* dir );
+    void calculateTree( DirItem* dir );
+    void forgetTree( DirItem* dir );
+
+    DataDoc* doc;
+
+    // cached per-directory values
+    QHash<const DirItem*, DirInfo> dirs;
+    QSet<DirItem*> dirty;
+    bool complete;
+
+    // state derived from the IsoOptions in init()
+    bool rockRidge;
+    bool joliet;
+    int jolietMaxLength;
+    int linkHandling;
+};
+
+
+void K3b::IsoSizeCalculator::Private::init()
+{
+    const IsoOptions& o = doc->isoOptions();
+
+    rockRidge = o.createRockRidge();
+    joliet = o.createJoliet();
+    jolietMaxLength = o.jolietLong() ? 103 : 64;
+
+    // this has to match IsoImager::initVariables()
+    if( o.followSymbolicLinks() )
+        linkHandling = FOLLOW;
+    else if( o.discardSymlinks() )
+        linkHandling = DISCARD_ALL;
+    else if( o.createRockRidge() )
+        linkHandling = o.discardBrokenSymlinks() ? DISCARD_BROKEN : KEEP_ALL;
+    else
+        linkHandling = FOLLOW;
+}
+
+
+bool K3b::IsoSizeCalculator::Private::writeItem( DataItem* item ) const
+{
+    // this has to match IsoImager::writePathSpecForDir()
+    if( !item->writeToCd() )
+        return false;
+
+    if( item->isSymLink() ) {
+        if( linkHandling == DISCARD_ALL ||
+            ( linkHandling == DISCARD_BROKEN && !item->isValid() ) )
+            return false;
+    }
+
+    return true;
+}
+
+
+bool K3b::IsoSizeCalculator::Private::writeDir( DirItem* dir ) const
+{
+    for( DataItem* item = dir; item; item = item->parent() ) {
+        if( !writeItem( item ) )
+            return false;
+    }
+    return true;
+}
+
+
+int K3b::IsoSizeCalculator::Private::isoNameLength( const QString& name, bool isDir ) const
+{
+    const IsoOptions& o = doc->isoOptions();
+
+    // ISO9660:1999 does neither use version numbers nor 8.3 names
+    if( o.ISOLevel() >= 4 )
+        return qMin( name.length(), 207 );
+
+    int maxLength = 0;
+    if( o.ISOmaxFilenameLength() )
+        maxLength = 37;
+    else if( o.ISOallow31charFilenames() || o.ISOLevel() > 1 )
+        maxLength = 31;
+
+    if( isDir )
+        return qMin( name.length(), maxLength > 0 ? maxLength : 8 );
+
+    const int extPos = name.lastIndexOf( '.' );
+    const bool hasExtension = ( extPos > 0 && extPos < name.length()-1 );
+
+    int len = 0;
+    if( maxLength > 0 ) {
+        len = qMin( name.length(), maxLength );
+    }
+    else if( hasExtension ) {
+        // 8.3
+        len = qMin( extPos, 8 ) + 1 + qMin( name.length() - extPos - 1, 3 );
+    }
+    else {
+        len = qMin( name.length(), 8 );
+    }
+
+    // mkisofs always adds a period to files without extension
+    if( !hasExtension && !o.ISOomitTrailingPeriod() )
+        ++len;
+
+    // ";1"
+    if( !o.ISOomitVersionNumbers() )
+        len += 2;
+
+    return len;
+}
+
+
+int K3b::IsoSizeCalculator::Private::jolietNameLength( const QString& name, bool isDir ) const
+{
+    // UCS-2
+    int len = qMin( name.length(), jolietMaxLength ) * 2;
+    if( !isDir && !doc->isoOptions().ISOomitVersionNumbers() )
+        len += 4;
+    return len;
+}
+
+
+int K3b::IsoSizeCalculator::Private::rockRidgeLength( DataItem* item, int isoLength, int& continuationBytes ) const
+{
+    int len = RR_RR + RR_PX + RR_TF + RR_NM + item->k3bName().toUtf8().length();
+
+    if( item->isSymLink() && linkHandling != FOLLOW ) {
+        // the size of a symlink is the length of its target. Every path component
+        // needs a two byte header instead of the slash.
+        len += RR_SL + static_cast<FileItem*>( item )->itemSize( false ) + 2;
+    }
+
+    // a directory record may not exceed 255 bytes. mkisofs moves the remaining
+    // System Use entries into a continuation area
+    if( recordLength( isoLength, len ) > MAX_RECORD_LENGTH ) {
+        const int available = MAX_RECORD_LENGTH - recordLength( isoLength ) - RR_CE;
+        continuationBytes += len - available;
+        len = available + RR_CE;
+    }
+
+    return len;
+}
+
+
+void K3b::IsoSizeCalculator::Private::calculateDir( DirItem* dir )
+{
+    DirInfo info;
+    DirectoryExtent isoExtent;
+    DirectoryExtent jolietExtent;
+
+    // "." and ".."
+    if( rockRidge ) {
+        int dotSu = RR_RR + RR_PX + RR_TF;
+        if( !dir->parent() )
+            dotSu += RR_SP + RR_CE;
+        isoExtent.addRecord( recordLength( 1, dotSu ) );
+        isoExtent.addRecord( recordLength( 1, RR_RR + RR_PX + RR_TF ) );
+    }
+    else {
+        isoExtent.addRecord( recordLength( 1 ) );
+        isoExtent.addRecord( recordLength( 1 ) );
+    }
+    jolietExtent.addRecord( recordLength( 1 ) );
+    jolietExtent.addRecord( recordLength( 1 ) );
+
+    const DirItem::Children& children = dir->children();
+    for( DirItem::Children::const_iterator it = children.constBegin(); it != children.constEnd(); ++it ) {
+        DataItem* item = *it;
+
+        if( !writeItem( item ) )
+            continue;
+
+        if( item->isFile() && item->size() > 2LL*1024LL*1024LL*1024LL )
+            info.hasLargeFiles = true;
+
+        // IsoImager writes the items hidden on RockRidge into both hide lists
+        // and does not hide directories at all. The ISO9660 hide list is only
+        // used together with Rock Ridge.
+        const bool hidden = ( !item->isDir() && item->hideOnRockRidge() );
+
+        const QString& name = item->k3bName();
+        const int isoLen = isoNameLength( name, item->isDir() );
+        if( !hidden || !rockRidge ) {
+            const int suLen = ( rockRidge ? rockRidgeLength( item, isoLen, info.continuationBytes ) : 0 );
+            isoExtent.addRecord( recordLength( isoLen, suLen ) );
+        }
+
+        if( joliet && !hidden )
+            jolietExtent.addRecord( recordLength( jolietNameLength( name, item->isDir() ) ) );
+
+        if( item->isDir() ) {
+            info.pathTableBytes += pathTableEntryLength( isoLen );
+            info.jolietPathTableBytes += pathTableEntryLength( jolietNameLength( name, true ) );
+        }
+    }
+
+    info.isoSectors = isoExtent.sectors();
+    if( joliet )
+        info.jolietSectors = jolietExtent.sectors();
+
+    dirs.insert( dir, info );
+}
+
+
+void K3b::IsoSizeCalculator::Private::calculateTree( DirItem* dir )
+{
+    calculateDir( dir );
+    const DirItem::Children& children = dir->children();
+    for( DirItem::Children::const_iterator it = children.constBegin(); it != children.constEnd(); ++it ) {
+        if( ( *it )->isDir() && writeItem( *it ) )
+            calculateTree( static_cast<DirItem*>( *it ) );
+    }
+}
+
+
+void K3b::IsoSizeCalculator::Private::forgetTree( DirItem* dir )
+{
+    dirs.remove( dir );
+    dirty.remove( dir );
+    const DirItem::Children& children = dir->children();
+    for( DirItem::Children::const_iterator it = children.constBegin(); it != children.constEnd(); ++it ) {
+        if( ( *it )->isDir() )
+            forgetTree( static_cast<DirItem*>( *it ) );
+    }
+}
+
+
+K3b::IsoSizeCalculator::IsoSizeCalculator( K3b::DataDoc* doc )
+    : d( new Private( doc ) )
+{
+}
+
+
+K3b::IsoSizeCalculator::~IsoSizeCalculator()
+{
+    delete d;
+}
+
+
+bool K3b::IsoSizeCalculator::canCalculate() const
+{
+    const IsoOptions& o = d->doc->isoOptions();
+    return( !o.createUdf() &&
+            !o.createTRANS_TBL() &&
+            d->doc->importedSession() < 0 );
+}
+
+
+K3b::Msf K3b::IsoSizeCalculator::size()
+{
+    if( !canCalculate() || !d->doc->root() )
+        return 0;
+
+    d->init();
+
+    if( !d->complete ) {
+        d->dirs.clear();
+        d->dirty.clear();
+        d->calculateTree( d->doc->root() );
+        d->complete = true;
+    }
+    else {
+        const QSet<DirItem*> dirty = d->dirty;
+        d->dirty.clear();
+        for( QSet<DirItem*>::const_iterator it = dirty.constBegin(); it != dirty.constEnd(); ++it ) {
+            // folders which are not written anymore, like the ones of an imported session
+            if( d->writeDir( *it ) )
+                d->calculateDir( *it );
+            else
+                d->forgetTree( *it );
+        }
+    }
+
+    qint64 isoSectors = 0;
+    qint64 jolietSectors = 0;
+    qint64 pathTableBytes = pathTableEntryLength( 1 ); // the root entry
+    qint64 jolietPathTableBytes = pathTableEntryLength( 1 );
+    qint64 continuationBytes = ( d->rockRidge ? RR_ER : 0 );
+    for( QHash<const DirItem*, Private::DirInfo>::const_iterator it = d->dirs.constBegin();
+         it != d->dirs.constEnd(); ++it ) {
+        const Private::DirInfo& info = it.value();
+        if( info.hasLargeFiles ) {
+            // mkisofs enables UDF and requires -allow-limited-size in this case
+            return 0;
+        }
+        isoSectors += info.isoSectors;
+        jolietSectors += info.jolietSectors;
+        pathTableBytes += info.pathTableBytes;
+        jolietPathTableBytes += info.jolietPathTableBytes;
+        continuationBytes += info.continuationBytes;
+    }
+
+    qint64 sectors = SYSTEM_AREA_SECTORS;
+
+    // volume descriptors: primary, terminator, and the mkisofs version descriptor
+    sectors += 3;
+    if( d->joliet )
+        sectors += 1;
+
+    // El Torito boot record and boot catalog
+    const bool boot = !d->doc->bootImages().isEmpty();
+    if( boot )
+        sectors += 2;
+
+    // type L and type M path tables
+    sectors += 2 * roundUp( pathTableBytes, SECTOR_SIZE );
+    if( d->joliet )
+        sectors += 2 * roundUp( jolietPathTableBytes, SECTOR_SIZE );
+
+    sectors += isoSectors;
+    sectors += jolietSectors;
+
+    if( d->rockRidge )
+        sectors += roundUp( continuationBytes, SECTOR_SIZE );
+
+    // the file data. FileCompilationSizeHandler already takes care of
+    // files sharing the same inode.
+    sectors += d->doc->burningSize() / SECTOR_SIZE;
+
+    // padding
+    sectors = roundUp( sectors, 16 ) * 16;
+    sectors += PAD_SECTORS;
+
+    qDebug() << "(K3b::IsoSizeCalculator)" << d->dirs.count() << "directories," << sectors << "sectors";
+
+    return Msf( int( sectors ) );
+}
+
+
+void K3b::IsoSizeCalculator::invalidate( K3b::DirItem* dir, bool recursive )
+{
+    if( !d->complete || !dir )
+        return;
+
+    if( recursive ) {
+        d->dirty.insert( dir );
+        const DirItem::Children& children = dir->children();
+        for( DirItem::Children::const_iterator it = children.constBegin(); it != children.constEnd(); ++it ) {
+            if( ( *it )->isDir() )
+                invalidate( static_cast<DirItem*>( *it ), true );
+        }
+    }
+    else {
+        d->dirty.insert( dir );
+    }
+}
+
+
+void K3b::IsoSizeCalculator::forget( K3b::DataItem* item )
+{
+    if( d->complete && item && item->isDir() )
+        d->forgetTree( static_cast<DirItem*>( item ) );
+}
+
+
+void K3b::IsoSizeCalculator::invalidateAll()
+{
+    d->complete = false;
+    d->dirs.clear();
+    d->dirty.clear();
+}
@@ -0,0 +1,84 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef _K3B_ISO_SIZE_CALCULATOR_H_
+#define _K3B_ISO_SIZE_CALCULATOR_H_
+
+#include "k3bmsf.h"
+#include "k3b_export.h"
+
+
+namespace K3b {
+    class DataDoc;
+    class DataItem;
+    class DirItem;
+
+    /**
+     * In-process calculation of the size of the ISO9660 image mkisofs would
+     * create for a data project.
+     *
+     * The calculator walks the project tree and applies the layout rules used by
+     * mkisofs: system area, volume descriptors, path tables, directory records
+     * including Rock Ridge and Joliet entries, file data (honoring shared inodes
+     * like FileCompilationSizeHandler does) and the trailing padding.
+     *
+     * The directory dependent parts are cached per directory. DataDoc invalidates
+     * the affected directories whenever items are added, removed, or renamed so
+     * that a new calculation only needs to look at the changed parts of the tree.
+     *
+     * Not all mkisofs features are modelled. Use canCalculate() to check if the
+     * current project settings are supported. IsoImager falls back to
+     * mkisofs -print-size otherwise.
+     */
+    class LIBK3B_EXPORT IsoSizeCalculator
+    {
+    public:
+        explicit IsoSizeCalculator( DataDoc* doc );
+        ~IsoSizeCalculator();
+
+        /**
+         * \return false if the project uses settings the calculator cannot
+         *         model (UDF, TRANS.TBL files, imported sessions, files
+         *         bigger than 2 GB). In that case mkisofs has to be used.
+         */
+        bool canCalculate() const;
+
+        /**
+         * \return The number of 2048 byte sectors of the image or 0 if
+         *         the size cannot be calculated. This is the case if
+         *         canCalculate() returns false or if the project contains
+         *         files bigger than 2 GB.
+         */
+        Msf size();
+
+        /**
+         * Mark the directory entries of @p dir as changed. Called by DataDoc
+         * whenever items in @p dir have been added, removed, or renamed.
+         *
+         * \param recursive If true all subdirectories are marked, too. This
+         *                  is needed for directories newly added to the project.
+         */
+        void invalidate( DirItem* dir, bool recursive = false );
+
+        /**
+         * Drop the cached data of @p item and all its subdirectories. Called
+         * by DataDoc before items are removed from the project.
+         */
+        void forget( DataItem* item );
+
+        /**
+         * Drop all cached data. Needed when the IsoOptions change.
+         */
+        void invalidateAll();
+
+    private:
+        class Private;
+        Private* const d;
+
+        Q_DISABLE_COPY( IsoSizeCalculator )
+    };
+}
+
+#endif
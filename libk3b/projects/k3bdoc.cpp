@@ -14,7 +14,10 @@
 
 #include <QDebug>
 #include <QString>
+#include <QDomDocument>
 #include <QDomElement>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 #include <QWidget>
 
 
@@ -195,6 +198,75 @@ bool K3b::Doc::readGeneralDocumentData( const QDomElement& elem )
 }
 
 
+bool K3b::Doc::loadDocumentStream( QXmlStreamReader& reader )
+{
+    QDomDocument doc;
+    QDomElement root = readDomElement( reader, doc );
+    doc.appendChild( root );
+    if( reader.hasError() )
+        return false;
+
+    return loadDocumentData( &root );
+}
+
+
+bool K3b::Doc::saveDocumentStream( QXmlStreamWriter& writer )
+{
+    QDomDocument doc;
+    QDomElement docElem = doc.createElement( "k3b_" + typeString() + "_project" );
+    doc.appendChild( docElem );
+    if( !saveDocumentData( &docElem ) )
+        return false;
+
+    for( QDomElement e = docElem.firstChildElement(); !e.isNull(); e = e.nextSiblingElement() )
+        writeDomElement( writer, e );
+
+    return !writer.hasError();
+}
+
+
+QDomElement K3b::Doc::readDomElement( QXmlStreamReader& reader, QDomDocument& doc )
+{
+    QDomElement elem = doc.createElement( reader.qualifiedName().toString() );
+    Q_FOREACH( const QXmlStreamAttribute& attribute, reader.attributes() ) {
+        elem.setAttribute( attribute.qualifiedName().toString(), attribute.value().toString() );
+    }
+
+    while( !reader.atEnd() ) {
+        reader.readNext();
+        if( reader.isEndElement() )
+            break;
+        else if( reader.isStartElement() )
+            elem.appendChild( readDomElement( reader, doc ) );
+        else if( reader.isCharacters() && !reader.isWhitespace() )
+            elem.appendChild( doc.createTextNode( reader.text().toString() ) );
+    }
+
+    return elem;
+}
+
+
+void K3b::Doc::writeDomElement( QXmlStreamWriter& writer, const QDomElement& elem )
+{
+    writer.writeStartElement( elem.tagName() );
+
+    const QDomNamedNodeMap attributes = elem.attributes();
+    for( int i = 0; i < attributes.count(); ++i ) {
+        const QDomAttr attribute = attributes.item( i ).toAttr();
+        writer.writeAttribute( attribute.name(), attribute.value() );
+    }
+
+    for( QDomNode node = elem.firstChild(); !node.isNull(); node = node.nextSibling() ) {
+        if( node.isElement() )
+            writeDomElement( writer, node.toElement() );
+        else if( node.isText() )
+            writer.writeCharacters( node.nodeValue() );
+    }
+
+    writer.writeEndElement();
+}
+
+
 K3b::Device::MediaTypes K3b::Doc::supportedMediaTypes() const
 {
     return K3b::Device::MEDIA_WRITABLE;
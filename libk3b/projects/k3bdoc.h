@@ -16,7 +16,10 @@
 #include <QString>
 #include <QUrl>
 
+class QDomDocument;
 class QDomElement;
+class QXmlStreamReader;
+class QXmlStreamWriter;
 namespace K3b {
     class BurnJob;
     class JobHandler;
@@ -115,6 +118,25 @@ namespace K3b {
          */
         virtual bool saveDocumentData( QDomElement* docElem ) = 0;
 
+        /**
+         * Load a project while parsing the xml stream. @p reader is positioned
+         * on the start element which contains the project data and is left on
+         * the matching end element.
+         *
+         * The default implementation reads the element into a QDomElement and
+         * calls loadDocumentData(). Projects which may contain a huge number
+         * of items read them directly from the stream instead.
+         */
+        virtual bool loadDocumentStream( QXmlStreamReader& reader );
+
+        /**
+         * Save a project by writing the contents of the document element
+         * to @p writer.
+         *
+         * The default implementation writes the result of saveDocumentData().
+         */
+        virtual bool saveDocumentStream( QXmlStreamWriter& writer );
+
         /** returns the QUrl of the document */
         const QUrl& URL() const;
         /** sets the URL of the document */
@@ -190,6 +212,17 @@ namespace K3b {
 
         bool readGeneralDocumentData( const QDomElement& );
 
+        /**
+         * Read the element @p reader is positioned on including all its children.
+         * Whitespace-only text is dropped just like QDomDocument::setContent() does.
+         */
+        static QDomElement readDomElement( QXmlStreamReader& reader, QDomDocument& doc );
+
+        /**
+         * Write @p elem including all its children.
+         */
+        static void writeDomElement( QXmlStreamWriter& writer, const QDomElement& elem );
+
     private Q_SLOTS:
         void slotChanged();
 
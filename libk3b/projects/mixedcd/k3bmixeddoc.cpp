@@ -16,6 +16,8 @@
 
 #include <QFileInfo>
 #include <QDomElement>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 
 
 
@@ -99,6 +101,8 @@ int K3b::MixedDoc::numOfTracks() const
 
 K3b::BurnJob* K3b::MixedDoc::newBurnJob( K3b::JobHandler* hdl, QObject* parent )
 {
+    audioDoc()->waitForAnalysis();
+    dataDoc()->waitForFileResolution();
     return new K3b::MixedJob( this, hdl, parent  );
 }
 
@@ -136,7 +140,43 @@ bool K3b::MixedDoc::loadDocumentData( QDomElement* rootElem )
     if( nodes.item(3).nodeName() != "mixed" )
         return false;
 
-    QDomNodeList optionList = nodes.item(3).childNodes();
+    return loadMixedOptions( nodes.item(3).toElement() );
+}
+
+
+bool K3b::MixedDoc::loadDocumentStream( QXmlStreamReader& reader )
+{
+    // only the data project is worth streaming, everything else is read as DOM
+    QDomDocument doc;
+
+    if( !reader.readNextStartElement() || reader.name() != QLatin1String( "general" ) )
+        return false;
+    if( !readGeneralDocumentData( readDomElement( reader, doc ) ) )
+        return false;
+
+    if( !reader.readNextStartElement() || reader.name() != QLatin1String( "audio" ) )
+        return false;
+    if( !m_audioDoc->loadDocumentStream( reader ) )
+        return false;
+
+    if( !reader.readNextStartElement() || reader.name() != QLatin1String( "data" ) )
+        return false;
+    if( !m_dataDoc->loadDocumentStream( reader ) )
+        return false;
+
+    if( !reader.readNextStartElement() || reader.name() != QLatin1String( "mixed" ) )
+        return false;
+    if( !loadMixedOptions( readDomElement( reader, doc ) ) )
+        return false;
+
+    reader.skipCurrentElement();
+    return !reader.hasError();
+}
+
+
+bool K3b::MixedDoc::loadMixedOptions( const QDomElement& mixedElem )
+{
+    QDomNodeList optionList = mixedElem.childNodes();
     for( int i = 0; i < optionList.count(); i++ ) {
 
         QDomElement e = optionList.item(i).toElement();
@@ -176,8 +216,45 @@ bool K3b::MixedDoc::saveDocumentData( QDomElement* docElem )
     docElem->appendChild( dataElem );
 
     QDomElement mixedElem = doc.createElement( "mixed" );
+    saveMixedOptions( mixedElem );
     docElem->appendChild( mixedElem );
 
+    setModified( false );
+
+    return true;
+}
+
+
+bool K3b::MixedDoc::saveDocumentStream( QXmlStreamWriter& writer )
+{
+    QDomDocument doc;
+    QDomElement docElem = doc.createElement( "k3b_" + typeString() + "_project" );
+    doc.appendChild( docElem );
+    saveGeneralDocumentData( &docElem );
+    writeDomElement( writer, docElem.firstChildElement() );
+
+    writer.writeStartElement( "audio" );
+    m_audioDoc->saveDocumentStream( writer );
+    writer.writeEndElement();
+
+    writer.writeStartElement( "data" );
+    m_dataDoc->saveDocumentStream( writer );
+    writer.writeEndElement();
+
+    QDomElement mixedElem = doc.createElement( "mixed" );
+    saveMixedOptions( mixedElem );
+    writeDomElement( writer, mixedElem );
+
+    setModified( false );
+
+    return !writer.hasError();
+}
+
+
+void K3b::MixedDoc::saveMixedOptions( QDomElement& mixedElem )
+{
+    QDomDocument doc = mixedElem.ownerDocument();
+
     QDomElement bufferFilesElem = doc.createElement( "remove_buffer_files" );
     bufferFilesElem.appendChild( doc.createTextNode( removeImages() ? "yes" : "no" ) );
     mixedElem.appendChild( bufferFilesElem );
@@ -199,10 +276,6 @@ bool K3b::MixedDoc::saveDocumentData( QDomElement* docElem )
         break;
     }
     mixedElem.appendChild( mixedTypeElem );
-
-    setModified( false );
-
-    return true;
 }
 
 
@@ -13,6 +13,8 @@
 #include "k3b_export.h"
 
 class QDomElement;
+class QXmlStreamReader;
+class QXmlStreamWriter;
 namespace K3b {
     class BurnJob;
 
@@ -72,8 +74,13 @@ namespace K3b {
     protected:
         bool loadDocumentData( QDomElement* ) override;
         bool saveDocumentData( QDomElement* ) override;
+        bool loadDocumentStream( QXmlStreamReader& reader ) override;
+        bool saveDocumentStream( QXmlStreamWriter& writer ) override;
 
     private:
+        bool loadMixedOptions( const QDomElement& mixedElem );
+        void saveMixedOptions( QDomElement& mixedElem );
+
         DataDoc* m_dataDoc;
         AudioDoc* m_audioDoc;
 
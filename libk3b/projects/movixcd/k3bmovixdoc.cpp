@@ -36,6 +36,7 @@ K3b::MovixDoc::~MovixDoc()
 
 K3b::BurnJob* K3b::MovixDoc::newBurnJob( K3b::JobHandler* hdl, QObject* parent )
 {
+    waitForFileResolution();
     return new K3b::MovixJob( this, hdl, parent );
 }
 
@@ -361,6 +362,19 @@ bool K3b::MovixDoc::loadDocumentData( QDomElement* rootElem )
 }
 
 
+bool K3b::MovixDoc::loadDocumentStream( QXmlStreamReader& reader )
+{
+    // eMovix projects use their own layout and only contain a few files
+    return K3b::Doc::loadDocumentStream( reader );
+}
+
+
+bool K3b::MovixDoc::saveDocumentStream( QXmlStreamWriter& writer )
+{
+    return K3b::Doc::saveDocumentStream( writer );
+}
+
+
 bool K3b::MovixDoc::saveDocumentData( QDomElement* docElem )
 {
     QDomDocument doc = docElem->ownerDocument();
@@ -108,6 +108,10 @@ namespace K3b {
         bool loadDocumentData( QDomElement* root ) override;
         /** reimplemented from Doc */
         bool saveDocumentData( QDomElement* ) override;
+        /** reimplemented from DataDoc */
+        bool loadDocumentStream( QXmlStreamReader& reader ) override;
+        /** reimplemented from DataDoc */
+        bool saveDocumentStream( QXmlStreamWriter& writer ) override;
 
     private:
         QList<MovixFileItem*> m_movixFiles;
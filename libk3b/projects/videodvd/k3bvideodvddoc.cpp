@@ -76,6 +76,7 @@ void K3b::VideoDvdDoc::addAudioVideoTsDirs()
 
 K3b::BurnJob* K3b::VideoDvdDoc::newBurnJob( K3b::JobHandler* hdl, QObject* parent )
 {
+  waitForFileResolution();
   return new K3b::VideoDvdJob( this, hdl, parent );
 }
 
@@ -91,4 +92,10 @@ bool K3b::VideoDvdDoc::saveDocumentData(QDomElement*)
     return true;
 }
 
+
+bool K3b::VideoDvdDoc::saveDocumentStream( QXmlStreamWriter& writer )
+{
+    return K3b::Doc::saveDocumentStream( writer );
+}
+
 //#include "k3bdvddoc.moc"
@@ -30,6 +30,7 @@ namespace K3b {
 
         // TODO: implement load- and saveDocumentData since we do not need all those options
         bool saveDocumentData(QDomElement*) override;
+        bool saveDocumentStream( QXmlStreamWriter& writer ) override;
 
     private:
         void addAudioVideoTsDirs();
@@ -6,11 +6,156 @@
 */
 
 #include "k3bactivepipe.h"
+#include "k3bcore.h"
+#include "k3bglobalsettings.h"
+#include "k3bqprocess.h"
+#include "k3bringbuffer.h"
 
 #include <QDebug>
+#include <QFileDevice>
 #include <QIODevice>
 #include <QThread>
 
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace {
+    // used if there is no K3b::Core to ask for the global settings
+    const qint64 DEFAULT_BUFFER_SIZE = 4*1024*1024;
+
+    // the maximum size of a single read from the source
+    const qint64 MAX_READ_SIZE = 256*1024;
+
+#ifdef Q_OS_LINUX
+    // the default capacity of a pipe
+    const size_t SPLICE_CHUNK_SIZE = 64*1024;
+
+    /**
+     * One end of a kernel side transfer
+     */
+    struct Endpoint {
+        Endpoint()
+            : fd( -1 ),
+              file( 0 ),
+              offset( 0 ),
+              isPipe( false ),
+              ownsFd( false ) {
+        }
+
+        // splice() needs a null offset for pipes and uses the
+        // given offset for files which does not touch the file position
+        loff_t* offsetPtr() { return file ? &offset : 0; }
+
+        int fd;
+        QFileDevice* file;
+        loff_t offset;
+        bool isPipe;
+
+        // the fd is a duplicate which has to be closed by the pump
+        bool ownsFd;
+    };
+
+
+    void releaseEndpoint( Endpoint& e )
+    {
+        if( e.ownsFd )
+            ::close( e.fd );
+        e.fd = -1;
+        e.ownsFd = false;
+    }
+
+
+    Endpoint endpoint( QIODevice* dev, bool source )
+    {
+        Endpoint e;
+        QFileDevice* file = qobject_cast<QFileDevice*>( dev );
+        if( file ) {
+            if( !source )
+                file->flush();
+            e.fd = file->handle();
+        }
+        else if( K3bQProcess* process = qobject_cast<K3bQProcess*>( dev ) ) {
+            // K3bQProcess closes its pipes in the GUI thread once the process died.
+            // Using our own duplicate makes sure we never touch a closed or reused fd.
+            const int fd = source ? process->stdoutFileDescriptor() : process->stdinFileDescriptor();
+            if( fd >= 0 ) {
+                e.fd = ::fcntl( fd, F_DUPFD_CLOEXEC, 0 );
+                e.ownsFd = ( e.fd >= 0 );
+            }
+        }
+
+        struct stat st;
+        if( e.fd >= 0 && ::fstat( e.fd, &st ) == 0 ) {
+            if( S_ISFIFO( st.st_mode ) ) {
+                e.isPipe = true;
+            }
+            else if( S_ISREG( st.st_mode ) && file ) {
+                e.file = file;
+                e.offset = file->pos();
+            }
+            else {
+                releaseEndpoint( e );
+            }
+        }
+        else {
+            releaseEndpoint( e );
+        }
+
+        return e;
+    }
+
+
+    bool waitFor( int fd, short events )
+    {
+        struct pollfd p;
+        p.fd = fd;
+        p.events = events;
+        p.revents = 0;
+        for( ;; ) {
+            int r = ::poll( &p, 1, -1 );
+            if( r > 0 )
+                return !( p.revents & POLLNVAL );
+            else if( r < 0 && errno != EINTR )
+                return false;
+        }
+    }
+
+
+    /**
+     * Moves up to @p len bytes from @p in to @p out, waiting if the
+     * non-blocking pipes of K3b::Process are not ready.
+     * \return The number of bytes moved, 0 on EOF, -1 on error (errno is set).
+     */
+    ssize_t spliceChunk( Endpoint& in, Endpoint& out, size_t len )
+    {
+        for( ;; ) {
+            ssize_t r = ::splice( in.fd, in.offsetPtr(), out.fd, out.offsetPtr(), len, SPLICE_F_MOVE|SPLICE_F_MORE );
+            if( r >= 0 )
+                return r;
+            else if( errno == EAGAIN ) {
+                if( !waitFor( in.fd, POLLIN ) || !waitFor( out.fd, POLLOUT ) )
+                    return -1;
+            }
+            else if( errno != EINTR )
+                return -1;
+        }
+    }
+
+
+    bool isUnsupported( int error )
+    {
+        return error == EINVAL || error == ENOSYS;
+    }
+#endif
+}
+
 
 class K3b::ActivePipe::Private : public QThread
 {
@@ -20,44 +165,287 @@ public:
         sourceIODevice(0),
         sinkIODevice(0),
         closeSinkIODevice( false ),
-        closeSourceIODevice( false ) {
+        closeSourceIODevice( false ),
+        bufferSize( 0 ),
+        ringBuffer( 0 ),
+        writeFailed( false ),
+        bytesRead( 0 ),
+        bytesWritten( 0 ) {
+    }
+
+    ~Private() override {
+        delete ringBuffer;
     }
 
     void run() override {
         qDebug() << "(K3b::ActivePipe) writing from" << sourceIODevice << "to" << sinkIODevice;
 
         bytesRead = bytesWritten = 0;
-        buffer.resize( 10*2048 );
 
-        bool fail = false;
+#ifdef Q_OS_LINUX
+        if( transferInKernel() )
+            return;
+#endif
+
+        copyData();
+    }
+
+    /**
+     * Copies the data through userspace using readData() and writeData().
+     *
+     * Reading and writing are done in separate threads which are decoupled by
+     * the ring buffer. Thus, a slow read does not stall the writer as long as
+     * there is data in the buffer and vice versa.
+     */
+    void copyData() {
+        writeFailed = false;
+        WriterThread writer( this );
+        writer.start();
+
         qint64 r = 0;
-        while( !fail && ( r = m_pipe->readData( buffer.data(), buffer.size() ) ) > 0 ) {
+        for( ;; ) {
+            qint64 len = 0;
+            char* data = ringBuffer->writePointer( len );
+            if( !data ) {
+                // the writer gave up
+                break;
+            }
+
+            r = m_pipe->readData( data, qMin( len, MAX_READ_SIZE ) );
+            if( r <= 0 )
+                break;
+
             bytesRead += r;
+            ringBuffer->commitWrite( r );
+        }
+
+        ringBuffer->closeWriting();
+        writer.wait();
+
+        if ( r < 0 ) {
+            qDebug() << "Read failed:" << sourceIODevice->errorString();
+        }
 
-            ssize_t w = 0;
-            ssize_t ww = 0;
-            while( w < r ) {
-                if( ( ww = m_pipe->write( buffer.data()+w, r-w ) ) > 0 ) {
+        qDebug() << "Done:"
+                 << ( writeFailed ? QLatin1String( "write failed" ) : QLatin1String( "write success" ) )
+                 << ( r != 0 ? QLatin1String( "read failed" ) : QLatin1String( "read success" ) )
+                 << "(total bytes read/written:" << bytesRead << "/" << bytesWritten << ")"
+                 << "(buffer underruns:" << ringBuffer->underruns() << ")";
+    }
+
+    /**
+     * Run by the WriterThread: writes the data from the ring buffer to the sink.
+     */
+    void writeFromBuffer() {
+        for( ;; ) {
+            qint64 len = 0;
+            const char* data = ringBuffer->readPointer( len );
+            if( !data )
+                return;
+
+            qint64 w = 0;
+            while( w < len ) {
+                qint64 ww = m_pipe->write( data+w, len-w );
+                if( ww > 0 ) {
                     w += ww;
                     bytesWritten += ww;
                 }
                 else {
                     qDebug() << "write failed." << sinkIODevice->errorString();
-                    fail = true;
-                    break;
+                    writeFailed = true;
+                    ringBuffer->abort();
+                    return;
                 }
             }
+
+            ringBuffer->commitRead( len );
         }
+    }
 
-        if ( r < 0 ) {
-            qDebug() << "Read failed:" << sourceIODevice->errorString();
+    class WriterThread : public QThread
+    {
+    public:
+        explicit WriterThread( Private* p ) : m_p( p ) {}
+        void run() override { m_p->writeFromBuffer(); }
+
+    private:
+        Private* m_p;
+    };
+
+#ifdef Q_OS_LINUX
+    /**
+     * Moves the data inside the kernel if both ends are file descriptors and
+     * the data does not need to be touched (or only observed).
+     *
+     * \return false if the kernel side transfer is not possible. In that case
+     *         no data has been transferred yet and copyData() has to be used.
+     */
+    bool transferInKernel() {
+        const ActivePipe::DataAccess access = m_pipe->dataAccess();
+        if( access == ActivePipe::FullDataAccess )
+            return false;
+
+        Endpoint in = endpoint( sourceIODevice, true );
+        Endpoint out = endpoint( sinkIODevice, false );
+        const bool transferred = ( in.fd >= 0 && out.fd >= 0 && transferEndpoints( in, out ) );
+        releaseEndpoint( in );
+        releaseEndpoint( out );
+        return transferred;
+    }
+
+    bool transferEndpoints( Endpoint& in, Endpoint& out ) {
+        const ActivePipe::DataAccess access = m_pipe->dataAccess();
+        bool success = false;
+        if( access == ActivePipe::ObserveData ) {
+            if( !in.isPipe || !out.isPipe || !teeData( in, out, success ) )
+                return false;
+        }
+        else if( in.isPipe || out.isPipe ) {
+            if( !spliceData( in, out, success ) )
+                return false;
+        }
+        else if( !spliceViaPipe( in, out, success ) ) {
+            return false;
         }
 
-        qDebug() << "Done:"
-                 << ( fail ? QLatin1String( "write failed" ) : QLatin1String( "write success" ) )
-                 << ( r != 0 ? QLatin1String( "read failed" ) : QLatin1String( "read success" ) )
-                 << "(total bytes read/written:" << bytesRead << "/" << bytesWritten << ")";
+        // keep the file positions in sync with what has been transferred
+        if( in.file )
+            in.file->seek( in.offset );
+        if( out.file )
+            out.file->seek( out.offset );
+
+        qDebug() << "Done:" << ( success ? QLatin1String( "success" ) : QLatin1String( "failed" ) )
+                 << "(total bytes moved in kernel:" << bytesWritten << ")";
+        return true;
+    }
+
+    /**
+     * Direct splice() which requires at least one of the ends to be a pipe.
+     */
+    bool spliceData( Endpoint& in, Endpoint& out, bool& success ) {
+        for( ;; ) {
+            ssize_t r = spliceChunk( in, out, SPLICE_CHUNK_SIZE );
+            if( r > 0 ) {
+                bytesRead += r;
+                bytesWritten += r;
+            }
+            else if( r == 0 ) {
+                success = true;
+                return true;
+            }
+            else if( bytesRead == 0 && isUnsupported( errno ) ) {
+                qDebug() << "(K3b::ActivePipe) splice() not supported, falling back to copying.";
+                return false;
+            }
+            else {
+                qDebug() << "(K3b::ActivePipe) splice() failed:" << ::strerror( errno );
+                return true;
+            }
+        }
+    }
+
+    /**
+     * splice() between two regular files needs an intermediate pipe.
+     */
+    bool spliceViaPipe( Endpoint& in, Endpoint& out, bool& success ) {
+        int fds[2];
+        if( ::pipe2( fds, O_CLOEXEC ) != 0 )
+            return false;
+
+        Endpoint pipeIn;
+        pipeIn.fd = fds[0];
+        pipeIn.isPipe = true;
+        Endpoint pipeOut;
+        pipeOut.fd = fds[1];
+        pipeOut.isPipe = true;
+
+        bool handled = true;
+        for( ;; ) {
+            ssize_t r = spliceChunk( in, pipeOut, SPLICE_CHUNK_SIZE );
+            if( r == 0 ) {
+                success = true;
+                break;
+            }
+            else if( r < 0 ) {
+                // we read with an explicit offset, so nothing is lost if we fall back
+                handled = ( bytesRead > 0 || !isUnsupported( errno ) );
+                break;
+            }
+
+            ssize_t left = r;
+            while( left > 0 ) {
+                ssize_t w = spliceChunk( pipeIn, out, left );
+                if( w <= 0 )
+                    break;
+                left -= w;
+            }
+            if( left > 0 ) {
+                handled = ( bytesRead > 0 || !isUnsupported( errno ) );
+                break;
+            }
+
+            bytesRead += r;
+            bytesWritten += r;
+        }
+
+        ::close( fds[0] );
+        ::close( fds[1] );
+
+        if( !handled ) {
+            // reset the offsets to not mess with the file positions
+            in.offset = in.file ? in.file->pos() : 0;
+            out.offset = out.file ? out.file->pos() : 0;
+            qDebug() << "(K3b::ActivePipe) splice() not supported, falling back to copying.";
+        }
+        return handled;
+    }
+
+    /**
+     * tee() the data from pipe to pipe and read it once for observeData().
+     */
+    bool teeData( Endpoint& in, Endpoint& out, bool& success ) {
+        buffer.resize( SPLICE_CHUNK_SIZE );
+        for( ;; ) {
+            ssize_t r = ::tee( in.fd, out.fd, buffer.size(), 0 );
+            if( r < 0 ) {
+                if( errno == EINTR )
+                    continue;
+                else if( errno == EAGAIN ) {
+                    if( waitFor( in.fd, POLLIN ) && waitFor( out.fd, POLLOUT ) )
+                        continue;
+                }
+                else if( bytesRead == 0 && isUnsupported( errno ) ) {
+                    qDebug() << "(K3b::ActivePipe) tee() not supported, falling back to copying.";
+                    return false;
+                }
+                qDebug() << "(K3b::ActivePipe) tee() failed:" << ::strerror( errno );
+                return true;
+            }
+            else if( r == 0 ) {
+                success = true;
+                return true;
+            }
+
+            // consume the data we just duplicated to the sink
+            ssize_t got = 0;
+            while( got < r ) {
+                ssize_t rr = ::read( in.fd, buffer.data() + got, r - got );
+                if( rr > 0 )
+                    got += rr;
+                else if( rr < 0 && errno == EINTR )
+                    continue;
+                else {
+                    qDebug() << "(K3b::ActivePipe) read after tee() failed:" << ::strerror( errno );
+                    return true;
+                }
+            }
+
+            m_pipe->observeData( buffer.constData(), r );
+            bytesRead += r;
+            bytesWritten += r;
+        }
     }
+#endif
 
     void _k3b_close() {
         qDebug();
@@ -78,6 +466,11 @@ public:
 
     QByteArray buffer;
 
+    // 0 means the size from the GlobalSettings
+    qint64 bufferSize;
+    RingBuffer* ringBuffer;
+    bool writeFailed;
+
     quint64 bytesRead;
     quint64 bytesWritten;
 };
@@ -128,6 +521,8 @@ bool K3b::ActivePipe::open( bool closeWhenDone )
     // we only do active piping if both devices are set.
     // Otherwise we only work as a conduit
     if ( d->sourceIODevice && d->sinkIODevice ) {
+        delete d->ringBuffer;
+        d->ringBuffer = new K3b::RingBuffer( bufferSize() );
         d->start();
     }
 
@@ -160,6 +555,17 @@ void K3b::ActivePipe::writeTo( QIODevice* dev, bool close )
 }
 
 
+K3b::ActivePipe::DataAccess K3b::ActivePipe::dataAccess() const
+{
+    return NoDataAccess;
+}
+
+
+void K3b::ActivePipe::observeData( const char*, qint64 )
+{
+}
+
+
 qint64 K3b::ActivePipe::readData( char* data, qint64 max )
 {
     if( d->sourceIODevice ) {
@@ -180,6 +586,41 @@ qint64 K3b::ActivePipe::writeData( const char* data, qint64 max )
 }
 
 
+void K3b::ActivePipe::setBufferSize( qint64 size )
+{
+    d->bufferSize = size;
+}
+
+
+qint64 K3b::ActivePipe::bufferSize() const
+{
+    if( d->bufferSize > 0 )
+        return d->bufferSize;
+    else if( k3bcore )
+        return qint64( k3bcore->globalSettings()->pipeBufferSize() ) * 1024 * 1024;
+    else
+        return DEFAULT_BUFFER_SIZE;
+}
+
+
+int K3b::ActivePipe::bufferFillLevel() const
+{
+    if( d->ringBuffer )
+        return int( d->ringBuffer->fillLevel() * 100 / d->ringBuffer->size() );
+    else
+        return 0;
+}
+
+
+quint64 K3b::ActivePipe::bufferUnderruns() const
+{
+    if( d->ringBuffer )
+        return d->ringBuffer->underruns();
+    else
+        return 0;
+}
+
+
 quint64 K3b::ActivePipe::bytesRead() const
 {
     return d->bytesRead;
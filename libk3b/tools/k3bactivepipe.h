@@ -61,6 +61,33 @@ namespace K3b {
          */
         void writeTo( QIODevice* dev, bool close = false );
 
+        /**
+         * Set the size of the buffer between reading from the source and
+         * writing to the sink. Takes effect on the next open().
+         *
+         * Defaults to GlobalSettings::pipeBufferSize().
+         */
+        void setBufferSize( qint64 size );
+
+        /**
+         * The size of the buffer in bytes.
+         */
+        qint64 bufferSize() const;
+
+        /**
+         * The fill level of the buffer in percent.
+         *
+         * The buffer is only used if the data is copied through userspace.
+         * Data moved inside the kernel is buffered by the kernel's pipes.
+         */
+        int bufferFillLevel() const;
+
+        /**
+         * The number of times the writing side had to wait for data
+         * since the pumping started.
+         */
+        quint64 bufferUnderruns() const;
+
         /**
          * The number of bytes that have been read.
          */
@@ -71,7 +98,45 @@ namespace K3b {
          */
         quint64 bytesWritten() const;
 
+        /**
+         * How the pumping thread needs to access the data.
+         */
+        enum DataAccess {
+            /**
+             * The data is only moved. If both source and sink provide a file
+             * descriptor (files and raw K3b::Process channels) the data is moved
+             * inside the kernel with splice().
+             */
+            NoDataAccess,
+
+            /**
+             * The data is not modified but observeData() needs to see it. If
+             * both source and sink are pipes the data is duplicated inside the
+             * kernel with tee() and only read once to pass it to observeData().
+             */
+            ObserveData,
+
+            /**
+             * All data is passed through readData() and writeData().
+             */
+            FullDataAccess
+        };
+
     protected:
+        /**
+         * The default implementation returns NoDataAccess. Subclasses that
+         * reimplement readData() or writeData() to process the data need to
+         * return FullDataAccess or ObserveData.
+         */
+        virtual DataAccess dataAccess() const;
+
+        /**
+         * Called with the data pumped through the pipe if dataAccess() returns
+         * ObserveData and the data is not passed through writeData().
+         * The default implementation does nothing.
+         */
+        virtual void observeData( const char* data, qint64 len );
+
         /**
          * Reads the data from the source.
          * The default implementation reads from the file desc
@@ -0,0 +1,465 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3baudioripcache.h"
+#include "k3bcdparanoialib.h"
+#include "k3bchecksumengine.h"
+#include "k3btoc.h"
+#include "k3btrack.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtEndian>
+
+#include <algorithm>
+#include <string.h>
+
+
+namespace {
+    const quint32 s_magic = 0x4b335243; // "K3RC"
+    const quint32 s_version = 1;
+
+    // one second of audio per checksum
+    const qint64 s_blockFrames = 75;
+    const qint64 s_headerSize = 4*sizeof( quint32 );
+    const qint64 s_blockSize = s_blockFrames*CD_FRAMESIZE_RAW + sizeof( quint32 );
+
+    const int s_maxParanoiaMode = 3;
+
+    void swapBytes( char* data, qint64 len )
+    {
+        for( qint64 i = 0; i < len-1; i+=2 ) {
+            char b = data[i];
+            data[i] = data[i+1];
+            data[i+1] = b;
+        }
+    }
+
+    qint64 trackFrames( const K3b::Device::Toc& toc, int track )
+    {
+        const K3b::Device::Track& t = toc[track-1];
+        return t.lastSector().lba() - t.firstSector().lba() + 1;
+    }
+
+    qint64 entrySize( qint64 frames )
+    {
+        const qint64 blocks = ( frames + s_blockFrames - 1 ) / s_blockFrames;
+        return s_headerSize + frames*CD_FRAMESIZE_RAW + blocks*sizeof( quint32 );
+    }
+
+    bool isAudioTrack( const K3b::Device::Toc& toc, int track )
+    {
+        return track > 0 && track <= toc.count() &&
+            toc[track-1].type() == K3b::Device::Track::TYPE_AUDIO;
+    }
+
+    /**
+     * The disc id alone is too weak to identify a disc, thus we add a hash
+     * of the complete layout.
+     */
+    QString tocKey( const K3b::Device::Toc& toc )
+    {
+        QCryptographicHash hash( QCryptographicHash::Sha1 );
+        Q_FOREACH( const K3b::Device::Track& track, toc ) {
+            const qint32 values[3] = { track.firstSector().lba(), track.lastSector().lba(), qint32( track.type() ) };
+            hash.addData( reinterpret_cast<const char*>( values ), sizeof( values ) );
+        }
+        return QString::fromLatin1( "%1-%2" )
+            .arg( toc.discId(), 8, 16, QLatin1Char( '0' ) )
+            .arg( QString::fromLatin1( hash.result().toHex().left( 16 ) ) );
+    }
+
+    Q_GLOBAL_STATIC( K3b::AudioRipCache, s_instance )
+}
+
+
+class K3b::AudioRipCache::Private
+{
+public:
+    Private()
+        : maxSize( 0 ) {
+    }
+
+    QString entryPath( const Device::Toc& toc, int track, int paranoiaMode ) const {
+        return QString::fromLatin1( "%1/%2/%3-%4.pcm" )
+            .arg( directory )
+            .arg( tocKey( toc ) )
+            .arg( track, 2, 10, QLatin1Char( '0' ) )
+            .arg( paranoiaMode );
+    }
+
+    /**
+     * Remove the oldest entries until the cache fits into maxSize again.
+     */
+    void prune( const QString& keep );
+
+    QString directory;
+    qint64 maxSize;
+
+    mutable QMutex mutex;
+};
+
+
+void K3b::AudioRipCache::Private::prune( const QString& keep )
+{
+    if( maxSize <= 0 )
+        return;
+
+    QList<QFileInfo> entries;
+    qint64 total = 0;
+    QDirIterator it( directory, QStringList() << QLatin1String( "*.pcm" ), QDir::Files, QDirIterator::Subdirectories );
+    while( it.hasNext() ) {
+        it.next();
+        entries.append( it.fileInfo() );
+        total += it.fileInfo().size();
+    }
+
+    if( total <= maxSize )
+        return;
+
+    std::sort( entries.begin(), entries.end(), []( const QFileInfo& a, const QFileInfo& b ) {
+        return a.lastModified() < b.lastModified();
+    } );
+
+    Q_FOREACH( const QFileInfo& entry, entries ) {
+        if( total <= maxSize )
+            break;
+        if( entry.absoluteFilePath() == QFileInfo( keep ).absoluteFilePath() )
+            continue;
+        if( QFile::remove( entry.absoluteFilePath() ) ) {
+            qDebug() << "(K3b::AudioRipCache) removed" << entry.absoluteFilePath();
+            total -= entry.size();
+            // only succeeds once the disc's directory is empty
+            QDir().rmdir( entry.absolutePath() );
+        }
+    }
+}
+
+
+class K3b::AudioRipCache::Reader::Private
+{
+public:
+    Private()
+        : frames( 0 ),
+          pos( 0 ),
+          blockIndex( -1 ) {
+    }
+
+    bool loadBlock( qint64 index );
+
+    QFile file;
+    qint64 frames;
+    qint64 pos;
+    qint64 blockIndex;
+    QByteArray block;
+};
+
+
+bool K3b::AudioRipCache::Reader::Private::loadBlock( qint64 index )
+{
+    const qint64 blockFrames = qMin( s_blockFrames, frames - index*s_blockFrames );
+    const qint64 dataSize = blockFrames*CD_FRAMESIZE_RAW;
+
+    block.resize( dataSize + sizeof( quint32 ) );
+    if( !file.seek( s_headerSize + index*s_blockSize ) ||
+        file.read( block.data(), block.size() ) != block.size() ) {
+        qDebug() << "(K3b::AudioRipCache) failed to read block" << index << "of" << file.fileName();
+        blockIndex = -1;
+        return false;
+    }
+
+    const quint32 crc = qFromBigEndian<quint32>( reinterpret_cast<const uchar*>( block.constData() + dataSize ) );
+    if( crc != K3b::ChecksumEngine::crc32( block.constData(), dataSize ) ) {
+        qDebug() << "(K3b::AudioRipCache) checksum mismatch in block" << index << "of" << file.fileName();
+        blockIndex = -1;
+        file.close();
+        QFile::remove( file.fileName() );
+        return false;
+    }
+
+    blockIndex = index;
+    return true;
+}
+
+
+K3b::AudioRipCache::Reader::Reader()
+    : d( new Private() )
+{
+}
+
+
+K3b::AudioRipCache::Reader::~Reader()
+{
+    delete d;
+}
+
+
+qint64 K3b::AudioRipCache::Reader::frames() const
+{
+    return d->frames;
+}
+
+
+bool K3b::AudioRipCache::Reader::seek( qint64 frame )
+{
+    if( frame < 0 || frame > d->frames )
+        return false;
+    d->pos = frame;
+    return true;
+}
+
+
+bool K3b::AudioRipCache::Reader::readFrame( char* data, bool littleEndian )
+{
+    if( d->pos >= d->frames || !d->file.isOpen() )
+        return false;
+
+    const qint64 index = d->pos / s_blockFrames;
+    if( index != d->blockIndex && !d->loadBlock( index ) )
+        return false;
+
+    ::memcpy( data, d->block.constData() + ( d->pos - index*s_blockFrames )*CD_FRAMESIZE_RAW, CD_FRAMESIZE_RAW );
+    if( !littleEndian )
+        swapBytes( data, CD_FRAMESIZE_RAW );
+
+    ++d->pos;
+    return true;
+}
+
+
+class K3b::AudioRipCache::Writer::Private
+{
+public:
+    Private( const QString& path )
+        : file( path ),
+          cache( 0 ),
+          frames( 0 ),
+          written( 0 ),
+          error( false ) {
+    }
+
+    bool flushBlock();
+
+    QSaveFile file;
+    AudioRipCache* cache;
+    qint64 frames;
+    qint64 written;
+    bool error;
+    QByteArray block;
+};
+
+
+bool K3b::AudioRipCache::Writer::Private::flushBlock()
+{
+    uchar crc[sizeof( quint32 )];
+    qToBigEndian<quint32>( K3b::ChecksumEngine::crc32( block.constData(), block.size() ), crc );
+
+    error = error ||
+        file.write( block ) != block.size() ||
+        file.write( reinterpret_cast<const char*>( crc ), sizeof( crc ) ) != sizeof( crc );
+    block.clear();
+    return !error;
+}
+
+
+K3b::AudioRipCache::Writer::Writer( const QString& path )
+    : d( new Private( path ) )
+{
+}
+
+
+K3b::AudioRipCache::Writer::~Writer()
+{
+    if( d->file.isOpen() )
+        d->file.cancelWriting();
+    delete d;
+}
+
+
+bool K3b::AudioRipCache::Writer::writeFrame( const char* data, bool littleEndian )
+{
+    if( d->error || d->written >= d->frames )
+        return false;
+
+    const int offset = d->block.size();
+    d->block.append( data, CD_FRAMESIZE_RAW );
+    if( !littleEndian )
+        swapBytes( d->block.data() + offset, CD_FRAMESIZE_RAW );
+    ++d->written;
+
+    if( d->block.size() == s_blockFrames*CD_FRAMESIZE_RAW || d->written == d->frames )
+        return d->flushBlock();
+    return true;
+}
+
+
+bool K3b::AudioRipCache::Writer::commit()
+{
+    if( d->error || d->written != d->frames ) {
+        qDebug() << "(K3b::AudioRipCache) discarding incomplete entry" << d->file.fileName();
+        d->file.cancelWriting();
+        return false;
+    }
+
+    if( !d->file.commit() ) {
+        qDebug() << "(K3b::AudioRipCache) failed to write" << d->file.fileName();
+        return false;
+    }
+
+    QMutexLocker locker( &d->cache->d->mutex );
+    d->cache->d->prune( d->file.fileName() );
+    return true;
+}
+
+
+K3b::AudioRipCache::AudioRipCache( const QString& directory )
+    : d( new Private() )
+{
+    if( directory.isEmpty() )
+        d->directory = QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) + QLatin1String( "/audiorip" );
+    else
+        d->directory = directory;
+}
+
+
+K3b::AudioRipCache::~AudioRipCache()
+{
+    delete d;
+}
+
+
+K3b::AudioRipCache* K3b::AudioRipCache::instance()
+{
+    return s_instance();
+}
+
+
+QString K3b::AudioRipCache::directory() const
+{
+    return d->directory;
+}
+
+
+void K3b::AudioRipCache::setMaxSize( qint64 size )
+{
+    QMutexLocker locker( &d->mutex );
+    d->maxSize = size;
+}
+
+
+qint64 K3b::AudioRipCache::maxSize() const
+{
+    QMutexLocker locker( &d->mutex );
+    return d->maxSize;
+}
+
+
+bool K3b::AudioRipCache::contains( const Device::Toc& toc, int track, int paranoiaMode ) const
+{
+    if( !isAudioTrack( toc, track ) )
+        return false;
+
+    const qint64 size = entrySize( trackFrames( toc, track ) );
+    for( int mode = s_maxParanoiaMode; mode >= qMax( 0, paranoiaMode ); --mode ) {
+        if( QFileInfo( d->entryPath( toc, track, mode ) ).size() == size )
+            return true;
+    }
+    return false;
+}
+
+
+K3b::AudioRipCache::Reader* K3b::AudioRipCache::createReader( const Device::Toc& toc, int track, int paranoiaMode )
+{
+    if( !isAudioTrack( toc, track ) )
+        return 0;
+
+    const qint64 frames = trackFrames( toc, track );
+    for( int mode = s_maxParanoiaMode; mode >= qMax( 0, paranoiaMode ); --mode ) {
+        const QString path = d->entryPath( toc, track, mode );
+        if( !QFile::exists( path ) )
+            continue;
+
+        Reader* reader = new Reader();
+        reader->d->frames = frames;
+        reader->d->file.setFileName( path );
+        if( reader->d->file.open( QIODevice::ReadOnly ) ) {
+            QDataStream s( &reader->d->file );
+            quint32 magic, version, entryFrames, blockFrames;
+            s >> magic >> version >> entryFrames >> blockFrames;
+            if( s.status() == QDataStream::Ok &&
+                magic == s_magic &&
+                version == s_version &&
+                entryFrames == frames &&
+                blockFrames == s_blockFrames &&
+                reader->d->file.size() == entrySize( frames ) ) {
+                // the modification time is used to find the least recently used entries
+                reader->d->file.setFileTime( QDateTime::currentDateTime(), QFileDevice::FileModificationTime );
+                return reader;
+            }
+        }
+
+        qDebug() << "(K3b::AudioRipCache) removing invalid entry" << path;
+        delete reader;
+        QFile::remove( path );
+    }
+
+    return 0;
+}
+
+
+K3b::AudioRipCache::Writer* K3b::AudioRipCache::createWriter( const Device::Toc& toc, int track, int paranoiaMode )
+{
+    if( !isAudioTrack( toc, track ) )
+        return 0;
+
+    const QString path = d->entryPath( toc, track, qBound( 0, paranoiaMode, s_maxParanoiaMode ) );
+    if( !QDir().mkpath( QFileInfo( path ).absolutePath() ) )
+        return 0;
+
+    Writer* writer = new Writer( path );
+    writer->d->cache = this;
+    writer->d->frames = trackFrames( toc, track );
+    if( !writer->d->file.open( QIODevice::WriteOnly ) ) {
+        qDebug() << "(K3b::AudioRipCache) unable to open" << path;
+        delete writer;
+        return 0;
+    }
+
+    QDataStream s( &writer->d->file );
+    s << s_magic << s_version << quint32( writer->d->frames ) << quint32( s_blockFrames );
+    writer->d->error = ( s.status() != QDataStream::Ok );
+    return writer;
+}
+
+
+qint64 K3b::AudioRipCache::size() const
+{
+    QMutexLocker locker( &d->mutex );
+
+    qint64 total = 0;
+    QDirIterator it( d->directory, QStringList() << QLatin1String( "*.pcm" ), QDir::Files, QDirIterator::Subdirectories );
+    while( it.hasNext() ) {
+        it.next();
+        total += it.fileInfo().size();
+    }
+    return total;
+}
+
+
+void K3b::AudioRipCache::clear()
+{
+    QMutexLocker locker( &d->mutex );
+    QDir( d->directory ).removeRecursively();
+}
@@ -0,0 +1,163 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef _K3B_AUDIO_RIP_CACHE_H_
+#define _K3B_AUDIO_RIP_CACHE_H_
+
+#include "k3b_export.h"
+
+#include <QString>
+
+
+namespace K3b {
+    namespace Device {
+        class Toc;
+    }
+
+    /**
+     * On-disk cache of the audio data ripped from CDs.
+     *
+     * CdparanoiaLib stores every audio track it reads completely and
+     * serves later reads of the same track from the cache instead of the
+     * drive. This way ripping a disc into several formats or copying it
+     * after ripping only reads the disc once.
+     *
+     * Entries are keyed by the table of contents of the disc, the track
+     * number and the paranoia mode the track was read with. Data read
+     * with a higher paranoia mode is also used for lower modes.
+     *
+     * Each entry stores the raw little endian frames in blocks of one
+     * second, each followed by its CRC-32. A block is verified before its
+     * data is used and entries with damaged blocks are dropped.
+     *
+     * All methods are thread-safe.
+     */
+    class LIBK3B_EXPORT AudioRipCache
+    {
+    public:
+        /**
+         * Reads the frames of one cached track.
+         */
+        class LIBK3B_EXPORT Reader
+        {
+        public:
+            ~Reader();
+
+            qint64 frames() const;
+
+            /**
+             * Position the reader at @p frame relative to the start of the track.
+             */
+            bool seek( qint64 frame );
+
+            /**
+             * Read one frame of CD_FRAMESIZE_RAW bytes at the current position
+             * into @p data in the requested byte order.
+             *
+             * \return false if the data could not be read or did not match its
+             *         checksum. The entry is removed from the cache in the latter case.
+             */
+            bool readFrame( char* data, bool littleEndian = true );
+
+        private:
+            Reader();
+
+            class Private;
+            Private* const d;
+
+            friend class AudioRipCache;
+            Q_DISABLE_COPY( Reader )
+        };
+
+        /**
+         * Writes the frames of one track into the cache. The data only becomes
+         * part of the cache once all frames of the track have been written and
+         * commit() is called. Deleting an uncommitted writer discards the data.
+         */
+        class LIBK3B_EXPORT Writer
+        {
+        public:
+            ~Writer();
+
+            /**
+             * Append one frame of CD_FRAMESIZE_RAW bytes which is stored in the
+             * given byte order.
+             */
+            bool writeFrame( const char* data, bool littleEndian = true );
+
+            bool commit();
+
+        private:
+            explicit Writer( const QString& path );
+
+            class Private;
+            Private* const d;
+
+            friend class AudioRipCache;
+            Q_DISABLE_COPY( Writer )
+        };
+
+        /**
+         * @param directory The directory the cache is stored in. If empty
+         *                  a directory in the user's cache location is used.
+         */
+        explicit AudioRipCache( const QString& directory = QString() );
+        ~AudioRipCache();
+
+        /**
+         * The cache used by CdparanoiaLib.
+         */
+        static AudioRipCache* instance();
+
+        QString directory() const;
+
+        /**
+         * The maximum size of the cache in bytes. The entries which have not
+         * been used for the longest time are removed once a new entry would
+         * exceed the size. 0 means unlimited which is the default.
+         */
+        void setMaxSize( qint64 size );
+        qint64 maxSize() const;
+
+        /**
+         * \return true if track @p track of the disc described by @p toc has been
+         *         cached with paranoia mode @p paranoiaMode or higher.
+         */
+        bool contains( const Device::Toc& toc, int track, int paranoiaMode ) const;
+
+        /**
+         * Open the cached data of track @p track. Entries read with the
+         * highest paranoia mode are preferred.
+         *
+         * \return a new reader owned by the caller or 0 if the track has not
+         *         been cached with paranoia mode @p paranoiaMode or higher.
+         */
+        Reader* createReader( const Device::Toc& toc, int track, int paranoiaMode );
+
+        /**
+         * \return a new writer owned by the caller or 0 if @p track is no audio
+         *         track or the cache cannot be written.
+         */
+        Writer* createWriter( const Device::Toc& toc, int track, int paranoiaMode );
+
+        /**
+         * The size of all cached entries in bytes.
+         */
+        qint64 size() const;
+
+        /**
+         * Remove all entries.
+         */
+        void clear();
+
+    private:
+        class Private;
+        Private* const d;
+
+        Q_DISABLE_COPY( AudioRipCache )
+    };
+}
+
+#endif
@@ -8,6 +8,9 @@
 #include <config-k3b.h>
 
 #include "k3bcdparanoialib.h"
+#include "k3baudioripcache.h"
+#include "k3bcore.h"
+#include "k3bglobalsettings.h"
 
 #include "k3bdevice.h"
 #include "k3btoc.h"
@@ -19,6 +22,7 @@
 #include <QLibrary>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QScopedPointer>
 
 #ifdef Q_OS_WIN32
 typedef short int int16_t;
@@ -336,7 +340,8 @@ public:
           paranoiaLevel(0),
           neverSkip(true),
           maxRetries(5),
-          data(0) {
+          data(0),
+          cacheReaderTrack(0) {
     }
 
     ~Private() {
@@ -380,9 +385,74 @@ public:
     int maxRetries;
 
     K3b::CdparanoiaLibData* data;
+
+    // the track which is currently read from the rip cache,
+    // respectively written to it
+    QScopedPointer<K3b::AudioRipCache::Reader> cacheReader;
+    unsigned int cacheReaderTrack;
+    QScopedPointer<K3b::AudioRipCache::Writer> cacheWriter;
+    char cacheBuffer[CD_FRAMESIZE_RAW];
+
+    /**
+     * \return the rip cache if it has been enabled by the user.
+     */
+    K3b::AudioRipCache* ripCache() const;
+
+    /**
+     * Read the current sector from the rip cache if the track has
+     * been cached before.
+     */
+    bool readCached( bool littleEndian );
+
+    void resetCache() {
+        cacheReader.reset();
+        cacheReaderTrack = 0;
+        cacheWriter.reset();
+    }
 };
 
 
+K3b::AudioRipCache* K3b::CdparanoiaLib::Private::ripCache() const
+{
+    if( !k3bcore || !k3bcore->globalSettings()->useAudioRipCache() )
+        return 0;
+
+    K3b::AudioRipCache* cache = K3b::AudioRipCache::instance();
+    cache->setMaxSize( qint64( k3bcore->globalSettings()->audioRipCacheSize() )*1024LL*1024LL*1024LL );
+    return cache;
+}
+
+
+bool K3b::CdparanoiaLib::Private::readCached( bool littleEndian )
+{
+    K3b::AudioRipCache* cache = ripCache();
+    if( !cache )
+        return false;
+
+    // only look up each track once
+    if( cacheReaderTrack != currentTrack ) {
+        cacheReader.reset( cache->createReader( toc, currentTrack, paranoiaLevel ) );
+        cacheReaderTrack = currentTrack;
+        if( cacheReader )
+            qDebug() << "(K3b::CdparanoiaLib) reading track" << currentTrack << "from the rip cache.";
+    }
+
+    if( !cacheReader )
+        return false;
+
+    if( cacheReader->seek( currentSector - toc[currentTrack-1].firstSector().lba() ) &&
+        cacheReader->readFrame( cacheBuffer, littleEndian ) ) {
+        return true;
+    }
+    else {
+        // fall back to the drive for the rest of the track
+        qDebug() << "(K3b::CdparanoiaLib) failed to read sector" << currentSector << "from the rip cache.";
+        cacheReader.reset();
+        return false;
+    }
+}
+
+
 K3b::CdparanoiaLib::CdparanoiaLib()
 {
     d = new Private();
@@ -611,6 +681,7 @@ void K3b::CdparanoiaLib::close()
 
 void K3b::CdparanoiaLib::cleanup()
 {
+    d->resetCache();
     if( d->data )
         d->data->paranoiaFree();
     d->device = 0;
@@ -679,6 +750,7 @@ bool K3b::CdparanoiaLib::initReading( long start, long end )
             d->toc.lastSector().lba() >= end ) {
             d->startSector = d->currentSector = start;
             d->lastSector = end;
+            d->resetCache();
 
             // determine track number
             d->currentTrack = 1;
@@ -713,6 +785,34 @@ char* K3b::CdparanoiaLib::read( int* statusCode, unsigned int* track, bool littl
         return 0;
     }
 
+    if( d->readCached( littleEndian ) ) {
+        d->cacheWriter.reset();
+        d->status = S_OK;
+        if( statusCode )
+            *statusCode = d->status;
+        if( track )
+            *track = d->currentTrack;
+
+        d->currentSector++;
+        if( d->toc[d->currentTrack-1].lastSector() < d->currentSector )
+            d->currentTrack++;
+
+        return d->cacheBuffer;
+    }
+
+    //
+    // Cache tracks which are read completely. Reads which may skip
+    // unreadable sectors are not cached.
+    //
+    const K3b::Device::Track& k3bTrack = d->toc[d->currentTrack-1];
+    if( !d->cacheWriter &&
+        d->neverSkip &&
+        d->currentSector == k3bTrack.firstSector().lba() &&
+        d->lastSector >= k3bTrack.lastSector().lba() ) {
+        if( K3b::AudioRipCache* cache = d->ripCache() )
+            d->cacheWriter.reset( cache->createWriter( d->toc, d->currentTrack, d->paranoiaLevel ) );
+    }
+
     if( d->currentSector != d->data->sector() ) {
         qDebug() << "(K3b::CdparanoiaLib) need to seek before read. Looks as if we are reusing the paranoia instance.";
         if( d->data->paranoiaSeek( d->currentSector, SEEK_SET ) == -1 )
@@ -753,6 +853,15 @@ char* K3b::CdparanoiaLib::read( int* statusCode, unsigned int* track, bool littl
     if( track )
         *track = d->currentTrack;
 
+    if( d->cacheWriter ) {
+        if( !data || !d->cacheWriter->writeFrame( charData, littleEndian ) )
+            d->cacheWriter.reset();
+        else if( d->currentSector == k3bTrack.lastSector().lba() ) {
+            d->cacheWriter->commit();
+            d->cacheWriter.reset();
+        }
+    }
+
     d->currentSector++;
 
     if( d->toc[d->currentTrack-1].lastSector() < d->currentSector )
@@ -0,0 +1,431 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bchecksumengine.h"
+
+#include <QCryptographicHash>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QQueue>
+#include <QSharedPointer>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <string.h>
+
+
+namespace {
+    // the size of the buffers handed to the workers
+    const qint64 BUFFER_SIZE = 1024*1024;
+
+    // page aligned buffers are friendly to the vectorized hash implementations
+    const size_t BUFFER_ALIGNMENT = 4096;
+
+    // the number of buffers a worker may fall behind before addData() blocks
+    const int MAX_PENDING_BUFFERS = 8;
+
+    const K3b::ChecksumEngine::Algorithm s_allAlgorithms[] = {
+        K3b::ChecksumEngine::Md5,
+        K3b::ChecksumEngine::Sha1,
+        K3b::ChecksumEngine::Sha256,
+        K3b::ChecksumEngine::Sha512,
+        K3b::ChecksumEngine::Blake2b,
+        K3b::ChecksumEngine::Crc32
+    };
+
+
+    class Buffer
+    {
+    public:
+        Buffer()
+            : data( static_cast<char*>( qMallocAligned( BUFFER_SIZE, BUFFER_ALIGNMENT ) ) ),
+              size( 0 ) {
+        }
+
+        ~Buffer() {
+            qFreeAligned( data );
+        }
+
+        char* data;
+        qint64 size;
+
+    private:
+        Q_DISABLE_COPY( Buffer )
+    };
+
+    typedef QSharedPointer<Buffer> BufferPtr;
+
+
+    /**
+     * Lookup tables for the slicing-by-8 CRC-32 implementation
+     */
+    class Crc32Table
+    {
+    public:
+        Crc32Table() {
+            for( quint32 i = 0; i < 256; ++i ) {
+                quint32 c = i;
+                for( int k = 0; k < 8; ++k )
+                    c = ( c & 1 ) ? ( 0xEDB88320U ^ ( c >> 1 ) ) : ( c >> 1 );
+                table[0][i] = c;
+            }
+            for( int i = 0; i < 256; ++i ) {
+                for( int t = 1; t < 8; ++t )
+                    table[t][i] = ( table[t-1][i] >> 8 ) ^ table[0][table[t-1][i] & 0xff];
+            }
+        }
+
+        quint32 table[8][256];
+    };
+
+
+    quint32 updateCrc32( quint32 crc, const uchar* p, qint64 len )
+    {
+        static const Crc32Table s_table;
+        const quint32 (&t)[8][256] = s_table.table;
+
+        crc = ~crc;
+        while( len >= 8 ) {
+            const quint32 one = ( quint32( p[0] ) | quint32( p[1] ) << 8 | quint32( p[2] ) << 16 | quint32( p[3] ) << 24 ) ^ crc;
+            const quint32 two = quint32( p[4] ) | quint32( p[5] ) << 8 | quint32( p[6] ) << 16 | quint32( p[7] ) << 24;
+            crc = t[7][one & 0xff] ^ t[6][( one >> 8 ) & 0xff] ^ t[5][( one >> 16 ) & 0xff] ^ t[4][one >> 24] ^
+                  t[3][two & 0xff] ^ t[2][( two >> 8 ) & 0xff] ^ t[1][( two >> 16 ) & 0xff] ^ t[0][two >> 24];
+            p += 8;
+            len -= 8;
+        }
+        while( len-- > 0 )
+            crc = t[0][( crc ^ *p++ ) & 0xff] ^ ( crc >> 8 );
+        return ~crc;
+    }
+
+
+    class Hasher
+    {
+    public:
+        virtual ~Hasher() {}
+        virtual void addData( const char* data, qint64 len ) = 0;
+        virtual QByteArray result() const = 0;
+        virtual void reset() = 0;
+    };
+
+
+    class CryptographicHasher : public Hasher
+    {
+    public:
+        explicit CryptographicHasher( QCryptographicHash::Algorithm algorithm )
+            : m_hash( algorithm ) {
+        }
+
+        void addData( const char* data, qint64 len ) override {
+            m_hash.addData( data, int( len ) );
+        }
+
+        QByteArray result() const override {
+            return m_hash.result();
+        }
+
+        void reset() override {
+            m_hash.reset();
+        }
+
+    private:
+        QCryptographicHash m_hash;
+    };
+
+
+    class Crc32Hasher : public Hasher
+    {
+    public:
+        Crc32Hasher()
+            : m_crc( 0 ) {
+        }
+
+        void addData( const char* data, qint64 len ) override {
+            m_crc = updateCrc32( m_crc, reinterpret_cast<const uchar*>( data ), len );
+        }
+
+        QByteArray result() const override {
+            QByteArray r( 4, Qt::Uninitialized );
+            r[0] = char( m_crc >> 24 );
+            r[1] = char( m_crc >> 16 );
+            r[2] = char( m_crc >> 8 );
+            r[3] = char( m_crc );
+            return r;
+        }
+
+        void reset() override {
+            m_crc = 0;
+        }
+
+    private:
+        quint32 m_crc;
+    };
+
+
+    Hasher* createHasher( K3b::ChecksumEngine::Algorithm algorithm )
+    {
+        switch( algorithm ) {
+        case K3b::ChecksumEngine::Md5:
+            return new CryptographicHasher( QCryptographicHash::Md5 );
+        case K3b::ChecksumEngine::Sha1:
+            return new CryptographicHasher( QCryptographicHash::Sha1 );
+        case K3b::ChecksumEngine::Sha256:
+            return new CryptographicHasher( QCryptographicHash::Sha256 );
+        case K3b::ChecksumEngine::Sha512:
+            return new CryptographicHasher( QCryptographicHash::Sha512 );
+        case K3b::ChecksumEngine::Blake2b:
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+            return new CryptographicHasher( QCryptographicHash::Blake2b_512 );
+#else
+            return 0;
+#endif
+        case K3b::ChecksumEngine::Crc32:
+            return new Crc32Hasher();
+        }
+        return 0;
+    }
+
+
+    /**
+     * Hashes the buffers queued by the engine with one algorithm.
+     */
+    class Worker : public QThread
+    {
+    public:
+        explicit Worker( Hasher* hasher )
+            : m_hasher( hasher ),
+              m_busy( false ),
+              m_stopping( false ) {
+        }
+
+        ~Worker() override {
+            {
+                QMutexLocker locker( &m_mutex );
+                m_stopping = true;
+                m_condition.wakeAll();
+            }
+            wait();
+            delete m_hasher;
+        }
+
+        void enqueue( const BufferPtr& buffer ) {
+            QMutexLocker locker( &m_mutex );
+            while( m_queue.count() >= MAX_PENDING_BUFFERS )
+                m_condition.wait( &m_mutex );
+            m_queue.enqueue( buffer );
+            m_condition.wakeAll();
+        }
+
+        /**
+         * Waits until all queued buffers have been hashed. Afterwards
+         * the hasher may be used from the calling thread until the
+         * next buffer is queued.
+         */
+        Hasher* waitForIdle() {
+            QMutexLocker locker( &m_mutex );
+            while( !m_queue.isEmpty() || m_busy )
+                m_condition.wait( &m_mutex );
+            return m_hasher;
+        }
+
+    protected:
+        void run() override {
+            QMutexLocker locker( &m_mutex );
+            for( ;; ) {
+                while( m_queue.isEmpty() && !m_stopping )
+                    m_condition.wait( &m_mutex );
+                if( m_queue.isEmpty() )
+                    return;
+
+                BufferPtr buffer = m_queue.dequeue();
+                m_busy = true;
+                m_condition.wakeAll();
+
+                locker.unlock();
+                m_hasher->addData( buffer->data, buffer->size );
+                buffer.clear();
+                locker.relock();
+
+                m_busy = false;
+                m_condition.wakeAll();
+            }
+        }
+
+    private:
+        Hasher* m_hasher;
+        QQueue<BufferPtr> m_queue;
+        bool m_busy;
+        bool m_stopping;
+        QMutex m_mutex;
+        QWaitCondition m_condition;
+    };
+}
+
+
+class K3b::ChecksumEngine::Private
+{
+public:
+    Private()
+        : bytesProcessed( 0 ) {
+    }
+
+    ~Private() {
+        qDeleteAll( workers );
+    }
+
+    Worker* worker( Algorithm algorithm ) {
+        Worker* w = workers.value( algorithm );
+        if( w && !w->isRunning() )
+            w->start();
+        return w;
+    }
+
+    // hand the current buffer to all workers
+    void flush() {
+        if( current && current->size > 0 ) {
+            for( QMap<Algorithm, Worker*>::const_iterator it = workers.constBegin();
+                 it != workers.constEnd(); ++it )
+                worker( it.key() )->enqueue( current );
+            current.clear();
+        }
+    }
+
+    Algorithms algorithms;
+    QMap<Algorithm, Worker*> workers;
+    BufferPtr current;
+    quint64 bytesProcessed;
+};
+
+
+K3b::ChecksumEngine::ChecksumEngine( Algorithms algorithms )
+    : d( new Private() )
+{
+    setAlgorithms( algorithms );
+}
+
+
+K3b::ChecksumEngine::~ChecksumEngine()
+{
+    delete d;
+}
+
+
+void K3b::ChecksumEngine::setAlgorithms( Algorithms algorithms )
+{
+    algorithms &= supportedAlgorithms();
+
+    reset();
+
+    for( Algorithm algorithm : s_allAlgorithms ) {
+        if( ( algorithms & algorithm ) && !d->workers.contains( algorithm ) )
+            d->workers.insert( algorithm, new Worker( createHasher( algorithm ) ) );
+        else if( !( algorithms & algorithm ) )
+            delete d->workers.take( algorithm );
+    }
+
+    d->algorithms = algorithms;
+}
+
+
+K3b::ChecksumEngine::Algorithms K3b::ChecksumEngine::algorithms() const
+{
+    return d->algorithms;
+}
+
+
+void K3b::ChecksumEngine::reset()
+{
+    d->current.clear();
+    for( QMap<Algorithm, Worker*>::const_iterator it = d->workers.constBegin();
+         it != d->workers.constEnd(); ++it )
+        it.value()->waitForIdle()->reset();
+    d->bytesProcessed = 0;
+}
+
+
+void K3b::ChecksumEngine::addData( const char* data, qint64 len )
+{
+    if( d->workers.isEmpty() )
+        return;
+
+    d->bytesProcessed += len;
+    while( len > 0 ) {
+        if( !d->current )
+            d->current = BufferPtr( new Buffer() );
+
+        const qint64 n = qMin( len, BUFFER_SIZE - d->current->size );
+        ::memcpy( d->current->data + d->current->size, data, n );
+        d->current->size += n;
+        data += n;
+        len -= n;
+
+        if( d->current->size == BUFFER_SIZE )
+            d->flush();
+    }
+}
+
+
+QByteArray K3b::ChecksumEngine::result( Algorithm algorithm )
+{
+    if( !d->workers.contains( algorithm ) )
+        return QByteArray();
+
+    d->flush();
+    return d->worker( algorithm )->waitForIdle()->result();
+}
+
+
+quint64 K3b::ChecksumEngine::bytesProcessed() const
+{
+    return d->bytesProcessed;
+}
+
+
+K3b::ChecksumEngine::Algorithms K3b::ChecksumEngine::supportedAlgorithms()
+{
+    Algorithms algorithms = Md5|Sha1|Sha256|Sha512|Crc32;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    algorithms |= Blake2b;
+#endif
+    return algorithms;
+}
+
+
+K3b::ChecksumEngine::Algorithm K3b::ChecksumEngine::firstAlgorithm( Algorithms algorithms )
+{
+    for( Algorithm algorithm : s_allAlgorithms ) {
+        if( algorithms & algorithm )
+            return algorithm;
+    }
+    return Md5;
+}
+
+
+QString K3b::ChecksumEngine::algorithmName( Algorithm algorithm )
+{
+    switch( algorithm ) {
+    case Md5:
+        return QStringLiteral( "MD5" );
+    case Sha1:
+        return QStringLiteral( "SHA-1" );
+    case Sha256:
+        return QStringLiteral( "SHA-256" );
+    case Sha512:
+        return QStringLiteral( "SHA-512" );
+    case Blake2b:
+        return QStringLiteral( "BLAKE2b" );
+    case Crc32:
+        return QStringLiteral( "CRC-32" );
+    }
+    return QString();
+}
+
+
+quint32 K3b::ChecksumEngine::crc32( const char* data, qint64 len )
+{
+    return updateCrc32( 0, reinterpret_cast<const uchar*>( data ), len );
+}
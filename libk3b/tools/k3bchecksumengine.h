@@ -0,0 +1,107 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef _K3B_CHECKSUM_ENGINE_H_
+#define _K3B_CHECKSUM_ENGINE_H_
+
+#include "k3b_export.h"
+
+#include <QByteArray>
+#include <QFlags>
+#include <QString>
+
+
+namespace K3b {
+    /**
+     * Calculates one or more checksums of a data stream in a single pass.
+     *
+     * The data passed to addData() is collected in large aligned buffers
+     * which are hashed by worker threads, one per algorithm. Thus, the
+     * thread feeding the data (be it the event loop or a pumping thread)
+     * only pays for a memcpy, and several algorithms are calculated in
+     * parallel.
+     *
+     * ChecksumPipe and Md5Job use this class.
+     */
+    class LIBK3B_EXPORT ChecksumEngine
+    {
+    public:
+        enum Algorithm {
+            Md5 = 0x1,
+            Sha1 = 0x2,
+            Sha256 = 0x4,
+            Sha512 = 0x8,
+            Blake2b = 0x10, /**< BLAKE2b-512, only supported with Qt 6 */
+            Crc32 = 0x20    /**< CRC-32 as used by zip and gzip */
+        };
+        Q_DECLARE_FLAGS( Algorithms, Algorithm )
+
+        explicit ChecksumEngine( Algorithms algorithms = Md5 );
+        ~ChecksumEngine();
+
+        /**
+         * Set the algorithms to calculate. Unsupported algorithms are
+         * ignored. Implies reset().
+         */
+        void setAlgorithms( Algorithms algorithms );
+        Algorithms algorithms() const;
+
+        /**
+         * Drop all data added so far.
+         */
+        void reset();
+
+        /**
+         * Add data to the checksums. The data is copied, i.e. the caller may
+         * reuse @p data right away. Blocks if the workers fall too far behind.
+         */
+        void addData( const char* data, qint64 len );
+
+        /**
+         * \return The raw checksum of all data added since the last reset()
+         *         or an empty array if @p algorithm is not calculated.
+         *
+         * Waits for the worker threads to process all pending data.
+         */
+        QByteArray result( Algorithm algorithm );
+
+        /**
+         * \return The number of bytes added since the last reset().
+         */
+        quint64 bytesProcessed() const;
+
+        /**
+         * \return All algorithms that are supported in this build.
+         */
+        static Algorithms supportedAlgorithms();
+
+        /**
+         * \return The algorithm with the lowest value in @p algorithms
+         *         or Md5 if @p algorithms is empty.
+         */
+        static Algorithm firstAlgorithm( Algorithms algorithms );
+
+        /**
+         * \return A human readable name like "SHA-256".
+         */
+        static QString algorithmName( Algorithm algorithm );
+
+        /**
+         * \return The CRC-32 of @p data, calculated in the calling thread.
+         *         Meant for small blocks which are not worth handing to a worker.
+         */
+        static quint32 crc32( const char* data, qint64 len );
+
+    private:
+        class Private;
+        Private* const d;
+
+        Q_DISABLE_COPY( ChecksumEngine )
+    };
+}
+
+Q_DECLARE_OPERATORS_FOR_FLAGS( K3b::ChecksumEngine::Algorithms )
+
+#endif
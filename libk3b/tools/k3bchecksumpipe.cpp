@@ -8,7 +8,6 @@
 #include "k3bchecksumpipe.h"
 
 #include <QDebug>
-#include <QCryptographicHash>
 
 #include <unistd.h>
 
@@ -17,28 +16,29 @@ class K3b::ChecksumPipe::Private
 {
 public:
     Private()
-		: checksumType(MD5), md5(QCryptographicHash::Md5) {
+        : primary( ChecksumEngine::Md5 ) {
     }
 
-    void update( const char* in, qint64 len ) {
-        switch( checksumType ) {
+    static ChecksumEngine::Algorithm algorithmForType( Type type ) {
+        switch( type ) {
+        case SHA1:
+            return ChecksumEngine::Sha1;
+        case SHA256:
+            return ChecksumEngine::Sha256;
+        case SHA512:
+            return ChecksumEngine::Sha512;
+        case BLAKE2B:
+            return ChecksumEngine::Blake2b;
+        case CRC32:
+            return ChecksumEngine::Crc32;
         case MD5:
-			md5.addData( in, len );
             break;
         }
+        return ChecksumEngine::Md5;
     }
 
-    void reset() {
-        switch( checksumType ) {
-        case MD5:
-            md5.reset();
-            break;
-        }
-    }
-
-    int checksumType;
-
-	QCryptographicHash md5;
+    ChecksumEngine engine;
+    ChecksumEngine::Algorithm primary;
 };
 
 
@@ -63,30 +63,55 @@ bool K3b::ChecksumPipe::open( bool closeWhenDone )
 
 bool K3b::ChecksumPipe::open( Type type, bool closeWhenDone )
 {
-    d->reset();
-    d->checksumType = type;
+    return open( Private::algorithmForType( type ), closeWhenDone );
+}
+
+
+bool K3b::ChecksumPipe::open( ChecksumEngine::Algorithms algorithms, bool closeWhenDone )
+{
+    if( algorithms & ~ChecksumEngine::supportedAlgorithms() ) {
+        qDebug() << "(K3b::ChecksumPipe) checksum algorithms" << algorithms << "not supported in this build.";
+        return false;
+    }
+
+    d->engine.setAlgorithms( algorithms );
+    d->primary = ChecksumEngine::firstAlgorithm( d->engine.algorithms() );
+
     return K3b::ActivePipe::open( closeWhenDone );
 }
 
 
 QByteArray K3b::ChecksumPipe::checksum() const
 {
-    switch( d->checksumType ) {
-    case MD5:
-		return d->md5.result().toHex();
-    }
+    return checksum( d->primary );
+}
+
 
-    return QByteArray();
+QByteArray K3b::ChecksumPipe::checksum( ChecksumEngine::Algorithm algorithm ) const
+{
+    return d->engine.result( algorithm ).toHex();
 }
 
 
 qint64 K3b::ChecksumPipe::writeData( const char* data, qint64 max )
 {
-    d->update( data, max );
+    d->engine.addData( data, max );
     return K3b::ActivePipe::writeData( data, max );
 }
 
 
+K3b::ActivePipe::DataAccess K3b::ChecksumPipe::dataAccess() const
+{
+    return ObserveData;
+}
+
+
+void K3b::ChecksumPipe::observeData( const char* data, qint64 len )
+{
+    d->engine.addData( data, len );
+}
+
+
 bool K3b::ChecksumPipe::open( OpenMode mode )
 {
     return ActivePipe::open( mode );
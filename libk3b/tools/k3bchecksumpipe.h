@@ -9,6 +9,7 @@
 #define _K3B_CHECKSUM_PIPE_H_
 
 #include "k3bactivepipe.h"
+#include "k3bchecksumengine.h"
 
 #include "k3b_export.h"
 
@@ -27,7 +28,12 @@ namespace K3b {
         ~ChecksumPipe() override;
 
         enum Type {
-            MD5
+            MD5,
+            SHA1,
+            SHA256,
+            SHA512,
+            BLAKE2B, /**< only supported with Qt 6 */
+            CRC32
         };
 
         /**
@@ -42,17 +48,41 @@ namespace K3b {
          *
          * \param closeWhenDone If true the pipes will be closed
          *        once all data has been read.
+         *
+         * Fails if @p type is not supported in this build.
          */
         bool open( Type type, bool closeWhenDone = false );
 
         /**
-         * Get the calculated checksum
+         * Opens the pipe and calculates all checksums in @p algorithms
+         * in one pass. checksum() returns the first of them.
+         *
+         * Fails if one of @p algorithms is not in
+         * ChecksumEngine::supportedAlgorithms().
+         */
+        bool open( ChecksumEngine::Algorithms algorithms, bool closeWhenDone = false );
+
+        /**
+         * Get the calculated checksum as hex string
          */
         QByteArray checksum() const;
 
+        /**
+         * Get the calculated checksum of @p algorithm as hex string. The
+         * algorithm needs to be one of the algorithms the pipe was opened with.
+         */
+        QByteArray checksum( ChecksumEngine::Algorithm algorithm ) const;
+
     protected:
         qint64 writeData( const char* data, qint64 max ) override;
 
+        /**
+         * \reimplemented
+         * Returns ObserveData.
+         */
+        DataAccess dataAccess() const override;
+        void observeData( const char* data, qint64 len ) override;
+
     private:
         /**
          * Hidden open method. Use open(bool).
@@ -535,6 +535,8 @@ int K3b::Iso9660::read( unsigned int sector, char* data, int count )
 {
     if( count == 0 )
         return 0;
+    else if( !d->backend || ( !d->backend->isOpen() && !d->backend->open() ) )
+        return -1;
     else
         return d->backend->read( sector, data, count );
 }
@@ -733,6 +735,13 @@ bool K3b::Iso9660::isOpen() const
 }
 
 
+void K3b::Iso9660::closeBackend()
+{
+    if( d->backend )
+        d->backend->close();
+}
+
+
 void K3b::Iso9660::createSimplePrimaryDesc( struct iso_primary_descriptor* desc )
 {
     d->primaryDesc.volumeId = QString::fromLocal8Bit( desc->volume_id, 32 ).trimmed();
@@ -386,6 +386,12 @@ namespace K3b {
          */
         void close();
 
+        /**
+         * Closes the file or device but keeps the parsed directory tree.
+         * The file or device is opened again by the next read.
+         */
+        void closeBackend();
+
         /**
          * @param sector startsector
          * @param len number of sectors
@@ -62,9 +62,8 @@ int K3b::Iso9660DeviceBackend::read( unsigned int sector, char* data, int len )
     if( isOpen() ) {
         //
         // split the number of sectors to be read
-        // FIXME: use a "real" value, not some arbitrary one
         //
-        static const int maxReadSectors = 20;
+        const int maxReadSectors = qMax( m_device->maxTransferLength() / 2048, 1 );
         int sectorsRead = 0;
         int retries = 10;  // TODO: no fixed value
         while( retries ) {
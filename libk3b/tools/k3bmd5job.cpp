@@ -10,9 +10,9 @@
 #include "k3bfilesplitter.h"
 #include "k3b_i18n.h"
 
-#include <QCryptographicHash>
 #include <QDebug>
 #include <QIODevice>
+#include <QStringList>
 #include <QTimer>
 
 
@@ -20,7 +20,7 @@ class K3b::Md5Job::Private
 {
 public:
     Private()
-		: md5(QCryptographicHash::Md5),
+		: primary(K3b::ChecksumEngine::Md5),
 		  ioDevice(0),
           finished(true),
           data(0),
@@ -29,7 +29,9 @@ public:
           lastProgress(0) {
     }
 
-	QCryptographicHash md5;
+    K3b::ChecksumEngine engine;
+    K3b::ChecksumEngine::Algorithm primary;
+    K3b::ChecksumEngine::Algorithms unsupported;
     K3b::FileSplitter file;
     QTimer timer;
     QString filename;
@@ -47,7 +49,10 @@ public:
 
     KIO::filesize_t imageSize;
 
-    static const int BUFFERSIZE = 2048*10;
+    // data is read in big chunks, the hashing is done by the
+    // engine's worker threads anyway. Devices are read with their
+    // maximum transfer length.
+    static const int BUFFERSIZE = 1024*1024;
 };
 
 
@@ -75,6 +80,18 @@ void K3b::Md5Job::start()
     jobStarted();
     d->readData = 0;
 
+    if( d->unsupported ) {
+        QStringList names;
+        for( int a = ChecksumEngine::Md5; a <= ChecksumEngine::Crc32; a <<= 1 ) {
+            const ChecksumEngine::Algorithm algorithm = static_cast<ChecksumEngine::Algorithm>( a );
+            if( d->unsupported & algorithm )
+                names << ChecksumEngine::algorithmName( algorithm );
+        }
+        emit infoMessage( i18n("Checksum algorithm not supported: %1", names.join( QStringLiteral(", ") )), MessageError );
+        jobFinished(false);
+        return;
+    }
+
     if( d->isoFile ) {
         d->imageSize = d->isoFile->size();
     }
@@ -104,7 +121,7 @@ void K3b::Md5Job::start()
         d->device->setSpeed( 0xffff, 0xffff );
     }
 
-    d->md5.reset();
+    d->engine.reset();
     d->finished = false;
     if( d->ioDevice )
         connect( d->ioDevice, SIGNAL(readyRead()), this, SLOT(slotUpdate()) );
@@ -172,6 +189,8 @@ void K3b::Md5Job::slotUpdate()
 
         // determine bytes to read
         qint64 readSize = Private::BUFFERSIZE;
+        if( d->device )
+            readSize = qMin( readSize, qint64( d->device->maxTransferLength() ) );
         if( d->maxSize > 0 )
             readSize = qMin( readSize, d->maxSize - d->readData );
 
@@ -238,7 +257,7 @@ void K3b::Md5Job::slotUpdate()
             }
             else {
                 d->readData += read;
-				d->md5.addData( d->data, read );
+                d->engine.addData( d->data, read );
                 int progress = 0;
                 if( d->isoFile || !d->filename.isEmpty() )
                     progress = (int)((double)d->readData * 100.0 / (double)d->imageSize);
@@ -256,9 +275,15 @@ void K3b::Md5Job::slotUpdate()
 
 
 QByteArray K3b::Md5Job::hexDigest()
+{
+    return hexDigest( d->primary );
+}
+
+
+QByteArray K3b::Md5Job::hexDigest( ChecksumEngine::Algorithm algorithm )
 {
     if( d->finished )
-		return d->md5.result().toHex();
+		return d->engine.result( algorithm ).toHex();
     else
         return "";
 }
@@ -267,12 +292,26 @@ QByteArray K3b::Md5Job::hexDigest()
 QByteArray K3b::Md5Job::base64Digest()
 {
 	if( d->finished )
-		return d->md5.result().toBase64();
+		return d->engine.result( d->primary ).toBase64();
 	else
 		return "";
 }
 
 
+void K3b::Md5Job::setAlgorithms( ChecksumEngine::Algorithms algorithms )
+{
+    d->engine.setAlgorithms( algorithms );
+    d->unsupported = algorithms & ~ChecksumEngine::supportedAlgorithms();
+    d->primary = ChecksumEngine::firstAlgorithm( d->engine.algorithms() );
+}
+
+
+K3b::ChecksumEngine::Algorithms K3b::Md5Job::algorithms() const
+{
+    return d->engine.algorithms();
+}
+
+
 void K3b::Md5Job::stop()
 {
     emit debuggingOutput( "K3b::Md5Job", QString("Stopped manually after %1 bytes.").arg(d->readData) );
@@ -8,6 +8,7 @@
 
 #include "k3b_export.h"
 #include "k3bjob.h"
+#include "k3bchecksumengine.h"
 #include <QByteArray>
 
 class QIODevice;
@@ -19,6 +20,13 @@ namespace K3b {
 
     class Iso9660File;
 
+    /**
+     * Calculates checksums of a file, a device or a QIODevice.
+     *
+     * Despite its name the job can calculate any of the algorithms
+     * supported by ChecksumEngine, several of them in one pass.
+     * It defaults to MD5.
+     */
     class LIBK3B_EXPORT Md5Job : public Job
     {
         Q_OBJECT
@@ -27,9 +35,27 @@ namespace K3b {
         explicit Md5Job( JobHandler* jh , QObject* parent = 0 );
         ~Md5Job() override;
 
+        /**
+         * The checksum of the first algorithm set via setAlgorithms().
+         */
 		QByteArray hexDigest();
 		QByteArray base64Digest();
 
+        /**
+         * \return The checksum of @p algorithm as hex string or an empty
+         *         array if the job is running or the algorithm has not
+         *         been calculated.
+         */
+        QByteArray hexDigest( ChecksumEngine::Algorithm algorithm );
+
+        /**
+         * Set the algorithms to calculate. Defaults to MD5.
+         * Needs to be called before start(), which fails if one of
+         * @p algorithms is not supported in this build.
+         */
+        void setAlgorithms( ChecksumEngine::Algorithms algorithms );
+        ChecksumEngine::Algorithms algorithms() const;
+
     public Q_SLOTS:
         void start() override;
         void stop();
@@ -18,8 +18,11 @@
 #include <QMutex>
 #include <QEvent>
 #include <QRandomGenerator>
+#include <QMutexLocker>
 
 #include <KCDDB/Client>
+#include <Solid/Device>
+#include <Solid/DeviceNotifier>
 
 
 
@@ -44,10 +47,57 @@ K3b::MediaCache::DeviceEntry::~DeviceEntry()
 }
 
 
+namespace {
+    // the interval in ms in which the drives are polled
+    const unsigned long POLL_INTERVAL = 2000;
+
+    // the poll interval in ms for drives whose media changes are announced by the system
+    const unsigned long NOTIFIED_POLL_INTERVAL = 10000;
+}
+
+
+void K3b::MediaCache::PollThread::wakeUp( bool mediaNotification )
+{
+    QMutexLocker locker( &m_wakeUpMutex );
+    if( mediaNotification )
+        m_mediaNotifications = true;
+    m_wakeUpPending = true;
+    m_wakeUpCondition.wakeAll();
+}
+
+
+void K3b::MediaCache::PollThread::waitForWakeUp()
+{
+    QMutexLocker locker( &m_wakeUpMutex );
+    if( !m_wakeUpPending )
+        m_wakeUpCondition.wait( &m_wakeUpMutex, m_mediaNotifications ? NOTIFIED_POLL_INTERVAL : POLL_INTERVAL );
+    m_wakeUpPending = false;
+}
+
+
 void K3b::MediaCache::PollThread::run()
 {
+    K3b::Device::Device* device = m_deviceEntry->medium.device();
+    bool useMediaEvents = true;
+
     while( m_deviceEntry->blockedId == 0 ) {
-        bool unitReady = m_deviceEntry->medium.device()->testUnitReady();
+        //
+        // Media events are preferred since they also report media which have been
+        // replaced between two polls. Drives which do not support them are checked
+        // with TEST UNIT READY.
+        //
+        bool unitReady = false;
+        bool mediumEvent = false;
+        K3b::Device::Device::MediaEvent event = K3b::Device::Device::MediaEventNone;
+        if( useMediaEvents && device->getMediaEventStatus( event, unitReady ) ) {
+            mediumEvent = ( event == K3b::Device::Device::MediaEventNewMedia ||
+                            event == K3b::Device::Device::MediaEventMediaRemoval ||
+                            event == K3b::Device::Device::MediaEventMediaChanged );
+        }
+        else {
+            useMediaEvents = false;
+            unitReady = device->testUnitReady();
+        }
         bool mediumCached = ( m_deviceEntry->medium.diskInfo().diskState() != K3b::Device::STATE_NO_MEDIA );
 
         //
@@ -56,7 +106,8 @@ void K3b::MediaCache::PollThread::run()
         // disk state)
         //
         if( m_deviceEntry->medium.diskInfo().diskState() == K3b::Device::STATE_UNKNOWN ||
-            unitReady != mediumCached ) {
+            unitReady != mediumCached ||
+            mediumEvent ) {
 
             if( m_deviceEntry->blockedId == 0 )
                 emit checkingMedium( m_deviceEntry->medium.device(), QString() );
@@ -90,7 +141,7 @@ void K3b::MediaCache::PollThread::run()
         }
 
         if( m_deviceEntry->blockedId == 0 )
-            QThread::sleep( 2 );
+            waitForWakeUp();
     }
 }
 
@@ -113,6 +164,8 @@ public:
 
     void _k_mediumChanged( K3b::Device::Device* );
     void _k_cddbJobFinished( KJob* job );
+    void _k_solidDeviceAdded( const QString& udi );
+    void _k_solidDeviceRemoved( const QString& udi );
 };
 
 
@@ -151,11 +204,38 @@ void K3b::MediaCache::Private::_k_cddbJobFinished( KJob* job )
 
 
 
+// a disc appeared. Check its drive right away.
+void K3b::MediaCache::Private::_k_solidDeviceAdded( const QString& udi )
+{
+    Solid::Device solidDev( udi );
+    for( QMap<K3b::Device::Device*, DeviceEntry*>::iterator it = deviceMap.begin();
+         it != deviceMap.end(); ++it ) {
+        const QString driveUdi = it.key()->solidDevice().udi();
+        if( solidDev.parentUdi() == driveUdi || udi == driveUdi )
+            it.value()->thread->wakeUp( true );
+    }
+}
+
+
+// a removed device cannot be queried for its parent anymore. Thus, we check all drives.
+void K3b::MediaCache::Private::_k_solidDeviceRemoved( const QString& )
+{
+    for( QMap<K3b::Device::Device*, DeviceEntry*>::iterator it = deviceMap.begin();
+         it != deviceMap.end(); ++it )
+        it.value()->thread->wakeUp();
+}
+
+
 K3b::MediaCache::MediaCache( QObject* parent )
     : QObject( parent ),
       d( new Private() )
 {
     d->q = this;
+
+    connect( Solid::DeviceNotifier::instance(), SIGNAL(deviceAdded(QString)),
+             this, SLOT(_k_solidDeviceAdded(QString)) );
+    connect( Solid::DeviceNotifier::instance(), SIGNAL(deviceRemoved(QString)),
+             this, SLOT(_k_solidDeviceRemoved(QString)) );
 }
 
 
@@ -184,6 +264,7 @@ int K3b::MediaCache::blockDevice( K3b::Device::Device* dev )
             e->readMutex.unlock();
 
             // wait for the thread to stop
+            e->thread->wakeUp();
             e->thread->wait();
 
             return e->blockedId;
@@ -305,6 +386,7 @@ void K3b::MediaCache::clearDeviceList()
     for( QMap<K3b::Device::Device*, DeviceEntry*>::iterator it = d->deviceMap.begin();
          it != d->deviceMap.end(); ++it ) {
         it.value()->blockedId = 1;
+        it.value()->thread->wakeUp();
     }
 
     // and remove them
@@ -378,7 +460,8 @@ void K3b::MediaCache::resetDevice( K3b::Device::Device* dev )
         e->medium.reset();
         e->readMutex.unlock();
         e->writeMutex.unlock();
-        // no need to emit mediumChanged here. The poll thread will act on it soon
+        // no need to emit mediumChanged here. The poll thread will act on it right away
+        e->thread->wakeUp();
     }
 }
 
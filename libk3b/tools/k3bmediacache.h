@@ -170,6 +170,8 @@ namespace K3b {
 
         Q_PRIVATE_SLOT( d, void _k_mediumChanged( K3b::Device::Device* ) )
         Q_PRIVATE_SLOT( d, void _k_cddbJobFinished( KJob* job ) )
+        Q_PRIVATE_SLOT( d, void _k_solidDeviceAdded( const QString& udi ) )
+        Q_PRIVATE_SLOT( d, void _k_solidDeviceRemoved( const QString& udi ) )
     };
 }
 
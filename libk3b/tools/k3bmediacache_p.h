@@ -11,6 +11,8 @@
 
 #include "k3bmediacache.h"
 
+#include <QWaitCondition>
+
 class K3b::MediaCache::DeviceEntry
 {
 public:
@@ -40,7 +42,18 @@ class K3b::MediaCache::PollThread : public QThread
 
 public:
     PollThread( MediaCache::DeviceEntry* de )
-        : m_deviceEntry( de ) {}
+        : m_deviceEntry( de ),
+          m_wakeUpPending( false ),
+          m_mediaNotifications( false ) {}
+
+    /**
+     * Makes the thread check the medium right away instead of waiting for
+     * the next poll.
+     *
+     * \param mediaNotification true if the system announced a media change
+     *        for this device. From then on the thread polls less often.
+     */
+    void wakeUp( bool mediaNotification = false );
 
 Q_SIGNALS:
     void mediumChanged( K3b::Device::Device* dev );
@@ -50,7 +63,14 @@ protected:
     void run() override;
 
 private:
+    void waitForWakeUp();
+
     MediaCache::DeviceEntry* m_deviceEntry;
+
+    QMutex m_wakeUpMutex;
+    QWaitCondition m_wakeUpCondition;
+    bool m_wakeUpPending;
+    bool m_mediaNotifications;
 };
 
 #endif
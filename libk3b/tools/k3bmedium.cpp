@@ -171,6 +171,9 @@ void K3b::Medium::update()
     if( d->device ) {
         reset();
 
+        // keep the device open for all the queries below
+        K3b::Device::HandleLease lease( d->device );
+
         d->diskInfo = d->device->diskInfo();
 
         if( d->diskInfo.diskState() != K3b::Device::STATE_NO_MEDIA ) {
@@ -0,0 +1,175 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bringbuffer.h"
+
+#include <QByteArray>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+
+#include <atomic>
+
+
+class K3b::RingBuffer::Private
+{
+public:
+    Private( qint64 s )
+        : size( s ),
+          written( 0 ),
+          read( 0 ),
+          writingClosed( false ),
+          aborted( false ),
+          producerWaiting( false ),
+          consumerWaiting( false ),
+          underruns( 0 ) {
+        buffer.resize( int( size ) );
+    }
+
+    // wakes the other side if it is waiting. The flag is checked after
+    // the counter has been updated and the waiting side re-checks the
+    // counter after setting the flag (both sequentially consistent), so
+    // no wake-up can get lost.
+    void wake( std::atomic<bool>& waiting ) {
+        if( waiting.load() ) {
+            QMutexLocker locker( &mutex );
+            condition.wakeAll();
+        }
+    }
+
+    const qint64 size;
+    QByteArray buffer;
+
+    // total number of bytes written and read. Only written by one side each.
+    std::atomic<quint64> written;
+    std::atomic<quint64> read;
+
+    std::atomic<bool> writingClosed;
+    std::atomic<bool> aborted;
+    std::atomic<bool> producerWaiting;
+    std::atomic<bool> consumerWaiting;
+
+    std::atomic<quint64> underruns;
+
+    QMutex mutex;
+    QWaitCondition condition;
+};
+
+
+K3b::RingBuffer::RingBuffer( qint64 size )
+    : d( new Private( qMax<qint64>( size, 1 ) ) )
+{
+}
+
+
+K3b::RingBuffer::~RingBuffer()
+{
+    delete d;
+}
+
+
+qint64 K3b::RingBuffer::size() const
+{
+    return d->size;
+}
+
+
+char* K3b::RingBuffer::writePointer( qint64& len )
+{
+    quint64 w = d->written.load();
+    for( ;; ) {
+        if( d->aborted.load() )
+            return 0;
+
+        const qint64 free = d->size - qint64( w - d->read.load() );
+        if( free > 0 ) {
+            const qint64 pos = qint64( w % quint64( d->size ) );
+            len = qMin( free, d->size - pos );
+            return d->buffer.data() + pos;
+        }
+
+        QMutexLocker locker( &d->mutex );
+        d->producerWaiting.store( true );
+        if( d->size - qint64( w - d->read.load() ) <= 0 && !d->aborted.load() )
+            d->condition.wait( &d->mutex );
+        d->producerWaiting.store( false );
+    }
+}
+
+
+void K3b::RingBuffer::commitWrite( qint64 len )
+{
+    d->written.fetch_add( quint64( len ) );
+    d->wake( d->consumerWaiting );
+}
+
+
+void K3b::RingBuffer::closeWriting()
+{
+    d->writingClosed.store( true );
+    QMutexLocker locker( &d->mutex );
+    d->condition.wakeAll();
+}
+
+
+const char* K3b::RingBuffer::readPointer( qint64& len )
+{
+    const quint64 r = d->read.load();
+    bool waited = false;
+    for( ;; ) {
+        if( d->aborted.load() )
+            return 0;
+
+        const qint64 available = qint64( d->written.load() - r );
+        if( available > 0 ) {
+            const qint64 pos = qint64( r % quint64( d->size ) );
+            len = qMin( available, d->size - pos );
+            return d->buffer.constData() + pos;
+        }
+        else if( d->writingClosed.load() ) {
+            // make sure we did not miss data written right before closing
+            if( d->written.load() == r )
+                return 0;
+            continue;
+        }
+
+        if( r > 0 && !waited )
+            d->underruns.fetch_add( 1 );
+        waited = true;
+
+        QMutexLocker locker( &d->mutex );
+        d->consumerWaiting.store( true );
+        if( d->written.load() == r && !d->writingClosed.load() && !d->aborted.load() )
+            d->condition.wait( &d->mutex );
+        d->consumerWaiting.store( false );
+    }
+}
+
+
+void K3b::RingBuffer::commitRead( qint64 len )
+{
+    d->read.fetch_add( quint64( len ) );
+    d->wake( d->producerWaiting );
+}
+
+
+void K3b::RingBuffer::abort()
+{
+    d->aborted.store( true );
+    QMutexLocker locker( &d->mutex );
+    d->condition.wakeAll();
+}
+
+
+qint64 K3b::RingBuffer::fillLevel() const
+{
+    return qint64( d->written.load() - d->read.load() );
+}
+
+
+quint64 K3b::RingBuffer::underruns() const
+{
+    return d->underruns.load();
+}
@@ -0,0 +1,84 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef _K3B_RING_BUFFER_H_
+#define _K3B_RING_BUFFER_H_
+
+#include <QtGlobal>
+
+
+namespace K3b {
+    /**
+     * A single producer single consumer ring buffer used to decouple
+     * reading and writing in ActivePipe.
+     *
+     * The producer and the consumer run in different threads. Data is
+     * exchanged without locking. Only if one side has to wait for the
+     * other a mutex and a wait condition are used.
+     *
+     * The producer asks for free space with writePointer(), fills it and
+     * hands it over with commitWrite(). The consumer works the same way
+     * with readPointer() and commitRead().
+     */
+    class RingBuffer
+    {
+    public:
+        explicit RingBuffer( qint64 size );
+        ~RingBuffer();
+
+        qint64 size() const;
+
+        /**
+         * Blocks until there is free space in the buffer.
+         *
+         * \param len Set to the number of bytes that can be written
+         *            to the returned pointer.
+         * \return 0 if the buffer has been aborted.
+         */
+        char* writePointer( qint64& len );
+        void commitWrite( qint64 len );
+
+        /**
+         * To be called by the producer once all data has been written.
+         */
+        void closeWriting();
+
+        /**
+         * Blocks until there is data in the buffer.
+         *
+         * \param len Set to the number of bytes that can be read
+         *            from the returned pointer.
+         * \return 0 if all data has been read after closeWriting() or
+         *         if the buffer has been aborted.
+         */
+        const char* readPointer( qint64& len );
+        void commitRead( qint64 len );
+
+        /**
+         * Wakes up both sides and makes all further calls to writePointer()
+         * and readPointer() return 0. Used in case of errors.
+         */
+        void abort();
+
+        /**
+         * \return The number of bytes currently in the buffer.
+         */
+        qint64 fillLevel() const;
+
+        /**
+         * \return The number of times the consumer had to wait for data
+         *         after the first data arrived.
+         */
+        quint64 underruns() const;
+
+    private:
+        class Private;
+        Private* const d;
+
+        Q_DISABLE_COPY( RingBuffer )
+    };
+}
+
+#endif
@@ -1887,6 +1887,28 @@ bool K3bQProcess::isReadyWrite() const
 }
 
 
+int K3bQProcess::stdinFileDescriptor()
+{
+#ifdef Q_OS_UNIX
+    Q_D(K3bQProcess);
+    return d->rawStdinDescriptor();
+#else
+    return -1;
+#endif
+}
+
+
+int K3bQProcess::stdoutFileDescriptor() const
+{
+#ifdef Q_OS_UNIX
+    Q_D(const K3bQProcess);
+    return d->rawStdoutDescriptor();
+#else
+    return -1;
+#endif
+}
+
+
 /*!
     \typedef Q_PID
     \relates QProcess
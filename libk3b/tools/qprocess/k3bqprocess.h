@@ -163,6 +163,19 @@ public:
 
     bool isReadyWrite() const;
 
+    /**
+     * The write end of the stdin pipe of the running process or -1 if
+     * RawStdin is not set or the platform does not support it.
+     * Allows to feed the process without going through write().
+     */
+    int stdinFileDescriptor();
+
+    /**
+     * The read end of the stdout pipe of the process or -1 if
+     * RawStdout is not set or the platform does not support it.
+     */
+    int stdoutFileDescriptor() const;
+
     static bool startDetached(const QString &program, const QStringList &arguments, const QString &workingDirectory,
                               qint64 *pid = 0);
     static bool startDetached(const QString &program, const QStringList &arguments);
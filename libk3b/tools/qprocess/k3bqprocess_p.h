@@ -192,6 +192,8 @@ public:
     void findExitCode();
 #ifdef Q_OS_UNIX
     bool waitForDeadChild();
+    int rawStdinDescriptor();
+    int rawStdoutDescriptor() const;
 #endif
 #ifdef Q_OS_WIN
     void flushPipeWriter();
@@ -945,6 +945,25 @@ qint64 K3bQProcessPrivate::writeToStdin(const char *data, qint64 maxlen)
     return written;
 }
 
+int K3bQProcessPrivate::rawStdinDescriptor()
+{
+    if (!(processFlags & K3bQProcess::RawStdin) || stdinChannel.closed
+        || processState != ::QProcess::Running)
+        return -1;
+
+    // the caller writes to the pipe directly, so make sure a crashed
+    // process does not take us down with it
+    qt_ignore_sigpipe();
+    return stdinChannel.pipe[1];
+}
+
+int K3bQProcessPrivate::rawStdoutDescriptor() const
+{
+    if (!(processFlags & K3bQProcess::RawStdout) || stdoutChannel.closed)
+        return -1;
+    return stdoutChannel.pipe[0];
+}
+
 void K3bQProcessPrivate::terminateProcess()
 {
 #if defined (QPROCESS_DEBUG)
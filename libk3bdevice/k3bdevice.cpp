@@ -23,10 +23,13 @@
 #endif
 
 #include <qglobal.h>
+#include <QDataStream>
 #include <QDebug>
 #include <QFile>
+#include <QFileInfo>
 #include <QMutex>
 #include <QStringList>
+#include <QVector>
 
 #include <sys/types.h>
 #include <sys/ioctl.h>
@@ -107,15 +110,65 @@ namespace {
     }
 }
 
+namespace {
+    // a transfer length every kernel we know of can handle
+#ifdef Q_OS_NETBSD
+    const int DEFAULT_MAX_TRANSFER_LENGTH = 31*2048;
+#else
+    const int DEFAULT_MAX_TRANSFER_LENGTH = 32*2048;
+#endif
+
+    // larger requests do not speed up reading anymore
+    const int MAX_TRANSFER_LENGTH = 512*2048;
+
+    // number of sectors whose Q sub-channel is read with one READ CD command
+    const int SUBCHANNEL_BATCH_SIZE = 75;
+
+    void addIndexTransition( K3b::Device::Track& track, int index, long sector )
+    {
+        qDebug() << "(K3b::Device::Device) found index transition: " << index << " " << sector;
+        if( index <= 0 )
+            return;
+
+        QList<K3b::Msf> indices = track.indices();
+        while ( indices.count() < index )
+            indices.append( K3b::Msf() );
+        // we save the index relative to the first sector
+        indices[index - 1] = K3b::Msf(sector) - track.firstSector();
+        track.setIndices( indices ); // FIXME: better API
+    }
+
+#ifdef Q_OS_LINUX
+    qint64 readSysfsValue( const QString& path )
+    {
+        QFile f( path );
+        if( !f.open( QIODevice::ReadOnly ) )
+            return -1;
+        bool ok = false;
+        qint64 value = f.readAll().trimmed().toLongLong( &ok );
+        return ok ? value : -1;
+    }
+#endif
+}
+
+
 class K3b::Device::Device::Private
 {
 public:
     Private()
-        : deviceHandle(HANDLE_DEFAULT_VALUE),
+        : maxTransferLength(DEFAULT_MAX_TRANSFER_LENGTH),
+          deviceHandle(HANDLE_DEFAULT_VALUE),
           openedReadWrite(false),
-          burnfree(false) {
+          handleLeases(0),
+          leaseOpenedHandle(false),
+          burnfree(false),
+          usageLockOwner(0) {
     }
 
+    // both need openCloseMutex to be locked
+    bool openHandle( bool write );
+    void closeHandle();
+
     Solid::Device solidDevice;
 
     QString vendor;
@@ -128,6 +181,7 @@ public:
     bool dvdMinusTestwrite;
 
     int bufferSize;
+    int maxTransferLength;
 
     WritingModes writeModes;
 
@@ -139,10 +193,15 @@ public:
     MediaTypes supportedProfiles;
     Handle deviceHandle;
     bool openedReadWrite;
+    int handleLeases;
+    bool leaseOpenedHandle;
     bool burnfree;
 
     QMutex mutex;
     QMutex openCloseMutex;
+
+    // the device whose usage lock is used instead of mutex, see shareUsageLock()
+    const Device* usageLockOwner;
 };
 
 #ifdef Q_OS_FREEBSD
@@ -305,6 +364,12 @@ int K3b::Device::Device::bufferSize() const
 }
 
 
+int K3b::Device::Device::maxTransferLength() const
+{
+    return d->maxTransferLength;
+}
+
+
 QString K3b::Device::Device::blockDeviceName() const
 {
     return d->blockDevice;
@@ -365,33 +430,10 @@ bool K3b::Device::Device::init( bool bCheckWritingModes )
     if( !open() )
         return false;
 
-    //
-    // inquiry
-    // use a 36 bytes buffer since not all devices return the full inquiry struct
-    //
-    ScsiCommand cmd( this );
-    unsigned char buf[36];
-    cmd.clear();
-    ::memset( buf, 0, sizeof(buf) );
-    struct inquiry* inq = (struct inquiry*)buf;
-    cmd[0] = MMC_INQUIRY;
-    cmd[4] = sizeof(buf);
-    cmd[5] = 0;
-    if( cmd.transport( TR_DIR_READ, buf, sizeof(buf) ) ) {
-        qCritical() << "(K3b::Device::Device) Unable to do inquiry." << Qt::endl;
+    if( !inquiry() ) {
         close();
         return false;
     }
-    else {
-        d->vendor = QString::fromLatin1( (char*)(inq->vendor), 8 ).trimmed();
-        d->description = QString::fromLatin1( (char*)(inq->product), 16 ).trimmed();
-        d->version = QString::fromLatin1( (char*)(inq->revision), 4 ).trimmed();
-    }
-
-    if( d->vendor.isEmpty() )
-        d->vendor = "UNKNOWN";
-    if( d->description.isEmpty() )
-        d->description = "UNKNOWN";
 
     //
     // We probe all features of the device. Since not all devices support the GET CONFIGURATION command
@@ -415,6 +457,8 @@ bool K3b::Device::Device::init( bool bCheckWritingModes )
 
     d->maxWriteSpeed = determineMaximalWriteSpeed();
 
+    determineMaxTransferLength();
+
     //
     // Check Just-Link via Ricoh mode page 0x30
     //
@@ -437,6 +481,125 @@ bool K3b::Device::Device::init( bool bCheckWritingModes )
 }
 
 
+bool K3b::Device::Device::inquiry()
+{
+    //
+    // use a 36 bytes buffer since not all devices return the full inquiry struct
+    //
+    ScsiCommand cmd( this );
+    unsigned char buf[36];
+    cmd.clear();
+    ::memset( buf, 0, sizeof(buf) );
+    struct inquiry* inq = (struct inquiry*)buf;
+    cmd[0] = MMC_INQUIRY;
+    cmd[4] = sizeof(buf);
+    cmd[5] = 0;
+    if( cmd.transport( TR_DIR_READ, buf, sizeof(buf) ) ) {
+        qCritical() << "(K3b::Device::Device) Unable to do inquiry." << Qt::endl;
+        return false;
+    }
+    else {
+        d->vendor = QString::fromLatin1( (char*)(inq->vendor), 8 ).trimmed();
+        d->description = QString::fromLatin1( (char*)(inq->product), 16 ).trimmed();
+        d->version = QString::fromLatin1( (char*)(inq->revision), 4 ).trimmed();
+    }
+
+    if( d->vendor.isEmpty() )
+        d->vendor = "UNKNOWN";
+    if( d->description.isEmpty() )
+        d->description = "UNKNOWN";
+
+    return true;
+}
+
+
+bool K3b::Device::Device::identify()
+{
+    if( !open() )
+        return false;
+
+    bool success = inquiry();
+    close();
+    return success;
+}
+
+
+QByteArray K3b::Device::Device::capabilities() const
+{
+    QByteArray data;
+    QDataStream s( &data, QIODevice::WriteOnly );
+    s.setVersion( QDataStream::Qt_5_15 );
+    s << d->vendor << d->description << d->version
+      << qint32( d->maxReadSpeed ) << qint32( d->maxWriteSpeed ) << qint32( d->bufferSize )
+      << d->dvdMinusTestwrite << d->burnfree
+      << d->writeModes << d->readCapabilities << d->writeCapabilities << d->supportedProfiles;
+    return data;
+}
+
+
+bool K3b::Device::Device::restoreCapabilities( const QByteArray& data, bool speeds )
+{
+    QDataStream s( data );
+    s.setVersion( QDataStream::Qt_5_15 );
+
+    QString vendor, description, version;
+    qint32 maxReadSpeed, maxWriteSpeed, bufferSize;
+    bool dvdMinusTestwrite, burnfree;
+    WritingModes writeModes;
+    MediaTypes readCapabilities, writeCapabilities, supportedProfiles;
+    s >> vendor >> description >> version
+      >> maxReadSpeed >> maxWriteSpeed >> bufferSize
+      >> dvdMinusTestwrite >> burnfree
+      >> writeModes >> readCapabilities >> writeCapabilities >> supportedProfiles;
+
+    // never apply the capabilities of another drive or firmware
+    if( s.status() != QDataStream::Ok ||
+        vendor != d->vendor ||
+        description != d->description ||
+        version != d->version )
+        return false;
+
+    if( speeds ) {
+        d->maxReadSpeed = maxReadSpeed;
+        d->maxWriteSpeed = maxWriteSpeed;
+    }
+    d->bufferSize = bufferSize;
+    d->dvdMinusTestwrite = dvdMinusTestwrite;
+    d->burnfree = burnfree;
+    d->writeModes = writeModes;
+    d->readCapabilities = readCapabilities;
+    d->writeCapabilities = writeCapabilities;
+    d->supportedProfiles = supportedProfiles;
+    return true;
+}
+
+
+void K3b::Device::Device::determineMaxTransferLength()
+{
+    d->maxTransferLength = DEFAULT_MAX_TRANSFER_LENGTH;
+
+#ifdef Q_OS_LINUX
+    //
+    // The kernel rejects SG_IO requests exceeding the queue's max_hw_sectors_kb.
+    // In addition the user buffer is mapped page by page and every page needs
+    // its own segment.
+    //
+    const QString name = QFileInfo( QFileInfo( blockDeviceName() ).canonicalFilePath() ).fileName();
+    const QString queueDir = QString::fromLatin1( "/sys/block/%1/queue/" ).arg( name );
+    qint64 len = readSysfsValue( queueDir + QLatin1String( "max_hw_sectors_kb" ) ) * 1024;
+    if( len > 0 ) {
+        const qint64 maxSegments = readSysfsValue( queueDir + QLatin1String( "max_segments" ) );
+        if( maxSegments > 0 )
+            len = qMin( len, maxSegments * ::sysconf( _SC_PAGESIZE ) );
+        len = qMin( len, qint64( MAX_TRANSFER_LENGTH ) );
+        d->maxTransferLength = qMax( int( len - len % 2048 ), 2048 );
+    }
+#endif
+
+    qDebug() << "(K3b::Device::Device) " << blockDeviceName() << ": max transfer length: " << d->maxTransferLength;
+}
+
+
 bool K3b::Device::Device::furtherInit()
 {
 #ifdef Q_OS_LINUX
@@ -1762,37 +1925,97 @@ K3b::Device::Device::Handle K3b::Device::Device::handle() const
 }
 
 
+bool K3b::Device::Device::Private::openHandle( bool write )
+{
+    //
+    // While the handle is leased a read-write handle is kept for reading, too.
+    // Otherwise we would reopen it for every single command.
+    //
+    if( openedReadWrite != write && !( !write && handleLeases > 0 ) )
+        closeHandle();
+
+    if( deviceHandle == HANDLE_DEFAULT_VALUE ) {
+        openedReadWrite = write;
+        deviceHandle = openDevice( QFile::encodeName(blockDevice), write );
+    }
+
+    return ( deviceHandle != HANDLE_DEFAULT_VALUE);
+}
+
+
+void K3b::Device::Device::Private::closeHandle()
+{
+    if( deviceHandle == HANDLE_DEFAULT_VALUE)
+        return;
+
+#if defined(Q_OS_FREEBSD)
+    cam_close_device(deviceHandle);
+#elif defined(Q_OS_WIN32)
+    CloseHandle(deviceHandle);
+#else
+    ::close( deviceHandle );
+#endif
+    deviceHandle = HANDLE_DEFAULT_VALUE;
+}
+
+
 bool K3b::Device::Device::open( bool write ) const
 {
-    if( d->openedReadWrite != write )
-        close();
+    QMutexLocker ml( &d->openCloseMutex );
+    return d->openHandle( write );
+}
 
+
+void K3b::Device::Device::close() const
+{
     QMutexLocker ml( &d->openCloseMutex );
 
-    d->openedReadWrite = write;
+    // the last lease will close the handle
+    if( d->handleLeases == 0 )
+        d->closeHandle();
+}
 
-    if( d->deviceHandle == HANDLE_DEFAULT_VALUE)
-        d->deviceHandle = openDevice( QFile::encodeName(blockDeviceName()), write );
 
-    return ( d->deviceHandle != HANDLE_DEFAULT_VALUE);
+bool K3b::Device::Device::acquireHandle( bool write ) const
+{
+    QMutexLocker ml( &d->openCloseMutex );
+
+    const bool wasOpen = ( d->deviceHandle != HANDLE_DEFAULT_VALUE );
+    if( !d->openHandle( write ) )
+        return false;
+
+    if( d->handleLeases++ == 0 )
+        d->leaseOpenedHandle = !wasOpen;
+    return true;
 }
 
 
-void K3b::Device::Device::close() const
+void K3b::Device::Device::releaseHandle() const
 {
     QMutexLocker ml( &d->openCloseMutex );
 
-    if( d->deviceHandle == HANDLE_DEFAULT_VALUE)
-        return;
+    if( d->handleLeases > 0 && --d->handleLeases == 0 && d->leaseOpenedHandle )
+        d->closeHandle();
+}
 
-#if defined(Q_OS_FREEBSD)
-    cam_close_device(d->deviceHandle);
-#elif defined(Q_OS_WIN32)
-    CloseHandle(d->deviceHandle);
-#else
-    ::close( d->deviceHandle );
-#endif
-    d->deviceHandle = HANDLE_DEFAULT_VALUE;
+
+K3b::Device::HandleLease::HandleLease( const Device* dev, bool write )
+    : m_device( dev ),
+      m_acquired( dev && dev->acquireHandle( write ) )
+{
+}
+
+
+K3b::Device::HandleLease::~HandleLease()
+{
+    if( m_acquired )
+        m_device->releaseHandle();
+}
+
+
+bool K3b::Device::HandleLease::isValid() const
+{
+    return m_acquired;
 }
 
 
@@ -3421,6 +3644,57 @@ int K3b::Device::Device::getIndex( unsigned long lba ) const
 }
 
 
+bool K3b::Device::Device::readIndices( unsigned long lba, int count, QVector<int>& indices ) const
+{
+    QVector<unsigned char> data( count*16 );
+    if( !readCd( data.data(),
+                 data.size(),
+                 1, // CD-DA
+                 0, // no DAP
+                 lba,
+                 count,
+                 false,
+                 false,
+                 false,
+                 false,
+                 false,
+                 0,
+                 2 // Q-Subchannel
+            ) )
+        return false;
+
+    //
+    // The index is found in the Mode-1 Q which occupies at least 9 out of 10 successive CD frames
+    // It can be identified by ADR == 1
+    //
+    // Frames without Mode-1 Q get the index of the previous frame.
+    //
+    indices.resize( count );
+    int index = -2;
+    for( int i = 0; i < count; ++i ) {
+        // byte 0: 4 bits CONTROL (MSB) + 4 bits ADR (LSB)
+        const unsigned char* q = &data[i*16];
+        if( (q[0]&0x0f) == 0x1 )
+            index = q[2];
+        indices[i] = index;
+    }
+
+    return true;
+}
+
+
+int K3b::Device::Device::probeIndex( unsigned long lba ) const
+{
+    // a few frames are enough to find one with Mode-1 Q
+    const unsigned long first = ( lba > 3 ? lba - 3 : 0 );
+    QVector<int> indices;
+    if( readIndices( first, lba - first + 1, indices ) )
+        return indices.last();
+    else
+        return getIndex( lba );
+}
+
+
 bool K3b::Device::Device::searchIndex0( unsigned long startSec,
                                       unsigned long endSec,
                                       long& pregapStart ) const
@@ -3434,28 +3708,38 @@ bool K3b::Device::Device::searchIndex0( unsigned long startSec,
 
     bool ret = false;
 
-    int lastIndex = getIndex( endSec );
+    int lastIndex = probeIndex( endSec );
     if( lastIndex == 0 ) {
         // there is a pregap
-        // let's find the position where the index turns to 0
-        // we jump in 1 sec steps backwards until we find an index > 0
-        unsigned long sector = endSec;
-        while( lastIndex == 0 && sector > startSec ) {
-            sector -= 75;
-            if( sector < startSec )
-                sector = startSec;
-            lastIndex = getIndex(sector);
-        }
-
-        if( lastIndex == 0 ) {
+        if( probeIndex( startSec ) == 0 ) {
             qDebug() << "(K3b::Device::Device) warning: no index != 0 found.";
         }
         else {
-            // search forward to the first index = 0
-            while( getIndex( sector ) != 0 && sector < endSec )
-                sector++;
+            //
+            // The pregap spans the end of the track. Bisect until the transition from index != 0
+            // to index 0 lies within one batch of sectors which we then read in one go.
+            //
+            unsigned long low = startSec;
+            unsigned long high = endSec;
+            while( high - low > 1 ) {
+                if( high - low < static_cast<unsigned long>( SUBCHANNEL_BATCH_SIZE ) ) {
+                    QVector<int> indices;
+                    if( readIndices( low, high - low + 1, indices ) ) {
+                        int i = indices.indexOf( 0 );
+                        if( i > 0 )
+                            high = low + i;
+                        break;
+                    }
+                }
+
+                unsigned long sector = low + (high - low)/2;
+                if( probeIndex( sector ) == 0 )
+                    high = sector;
+                else
+                    low = sector;
+            }
 
-            pregapStart = sector;
+            pregapStart = high;
             ret = true;
         }
     }
@@ -3514,32 +3798,41 @@ void K3b::Device::Device::searchIndexTransitions( long start, long end, K3b::Dev
 {
     qDebug() << "(K3b::Device::Device) searching for index transitions between "
              << start << " and " << end << Qt::endl;
-    int startIndex = getIndex( start );
-    int endIndex = getIndex( end );
+    searchIndexTransitions( start, probeIndex( start ), end, probeIndex( end ), track );
+}
+
 
+void K3b::Device::Device::searchIndexTransitions( long start, int startIndex,
+                                                 long end, int endIndex,
+                                                 K3b::Device::Track& track ) const
+{
     if( startIndex < 0 || endIndex < 0 ) {
         qDebug() << "(K3b::Device::Device) could not retrieve index values.";
     }
-    else {
+    else if( startIndex != endIndex ) {
         qDebug() << "(K3b::Device::Device) indices: " << start << " - " << startIndex
                  << " and " << end << " - " << endIndex << Qt::endl;
 
-        if( startIndex != endIndex ) {
-            if( start+1 == end ) {
-                QList<K3b::Msf> indices = track.indices();
-                qDebug() << "(K3b::Device::Device) found index transition: " << endIndex << " " << end;
-                while ( indices.count() < endIndex )
-                    indices.append( K3b::Msf() );
-                // we save the index relative to the first sector
-                if (endIndex > 0 && endIndex < indices.size() + 1)
-                    indices[endIndex - 1] = K3b::Msf(end) - track.firstSector();
-                track.setIndices( indices ); // FIXME: better API
-            }
-            else {
-                searchIndexTransitions( start, start+(end-start)/2, track );
-                searchIndexTransitions( start+(end-start)/2, end, track );
+        if( end - start < SUBCHANNEL_BATCH_SIZE ) {
+            QVector<int> indices;
+            if( readIndices( start, end - start + 1, indices ) ) {
+                for( int i = 1; i < indices.count(); ++i ) {
+                    if( indices[i] != indices[i-1] && indices[i-1] >= 0 )
+                        addIndexTransition( track, indices[i], start + i );
+                }
+                return;
             }
         }
+
+        if( start+1 == end ) {
+            addIndexTransition( track, endIndex, end );
+        }
+        else {
+            long middle = start+(end-start)/2;
+            int middleIndex = probeIndex( middle );
+            searchIndexTransitions( start, startIndex, middle, middleIndex, track );
+            searchIndexTransitions( middle, middleIndex, end, endIndex, track );
+        }
     }
 }
 
@@ -3704,11 +3997,32 @@ QByteArray K3b::Device::Device::mediaId( int mediaType ) const
 
 void K3b::Device::Device::usageLock() const
 {
-    d->mutex.lock();
+    if( d->usageLockOwner )
+        d->usageLockOwner->usageLock();
+    else
+        d->mutex.lock();
+}
+
+
+bool K3b::Device::Device::tryUsageLock() const
+{
+    if( d->usageLockOwner )
+        return d->usageLockOwner->tryUsageLock();
+    else
+        return d->mutex.tryLock();
 }
 
 
 void K3b::Device::Device::usageUnlock() const
 {
-    d->mutex.unlock();
+    if( d->usageLockOwner )
+        d->usageLockOwner->usageUnlock();
+    else
+        d->mutex.unlock();
+}
+
+
+void K3b::Device::Device::shareUsageLock( const Device* device )
+{
+    d->usageLockOwner = device;
 }
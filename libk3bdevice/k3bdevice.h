@@ -14,6 +14,7 @@
 
 #include <qglobal.h>
 #include <QVarLengthArray>
+#include <QVector>
 
 #if defined(__FreeBSD_kernel__)
 #undef Q_OS_LINUX
@@ -208,6 +209,13 @@ namespace K3b {
              */
             int bufferSize() const;
 
+            /**
+             * The maximum number of bytes which can be transferred with a single
+             * command as reported by the operating system. This is determined once
+             * when the device is initialized and should be used to size read requests.
+             */
+            int maxTransferLength() const;
+
             /**
              * for SCSI devices this should be something like /dev/scd0 or /dev/sr0
              * for IDE device this should be something like /dev/hdb1
@@ -239,6 +247,27 @@ namespace K3b {
              */
             bool testUnitReady() const;
 
+            enum MediaEvent {
+                MediaEventNone,
+                MediaEventEjectRequest,
+                MediaEventNewMedia,
+                MediaEventMediaRemoval,
+                MediaEventMediaChanged
+            };
+
+            /**
+             * Polls the media class events of the device. In contrast to testUnitReady()
+             * this also reports a medium which has been replaced between two calls.
+             *
+             * Refers to the MMC command: GET EVENT STATUS NOTIFICATION (polled)
+             *
+             * \param event Set to the last media event which occurred.
+             * \param mediumPresent Set to true if a medium is inserted.
+             *
+             * \return false if the device does not support media class events.
+             */
+            bool getMediaEventStatus( MediaEvent& event, bool& mediumPresent ) const;
+
             /**
              * checks if disk is empty, returns @p K3b::Device::State
              */
@@ -418,6 +447,26 @@ namespace K3b {
              */
             void close() const;
 
+            /**
+             * Open the device and keep it open until the matching releaseHandle(),
+             * even if close() is called in the meantime. This allows to send a batch
+             * of commands without opening and closing the device for each of them.
+             * Leases nest and may be acquired from different threads.
+             *
+             * A read-write handle is kept as such while leased.
+             *
+             * Prefer HandleLease over calling this directly.
+             *
+             * @return true on success. Only then releaseHandle() has to be called.
+             */
+            bool acquireHandle( bool write = false ) const;
+
+            /**
+             * Releases a lease acquired via acquireHandle(). The last lease closes
+             * the device unless it was already open before the first lease.
+             */
+            void releaseHandle() const;
+
             /**
              * @return true if the device was successfully opened via @p open()
              */
@@ -665,6 +714,13 @@ namespace K3b {
              */
             void usageLock() const;
 
+            /**
+             * Like usageLock() but does not wait if the device is already locked.
+             *
+             * \return true if the device has been locked.
+             */
+            bool tryUsageLock() const;
+
             /**
              * Unlock the device after a call to usageLock.
              */
@@ -718,7 +774,53 @@ namespace K3b {
              */
             bool init( bool checkWritingModes = true );
 
+            /**
+             * Opens the device and determines vendor, description and firmware
+             * version via inquiry(). This is all init() does which cannot be cached.
+             */
+            bool identify();
+
+            /**
+             * Sends an INQUIRY command and sets vendor, description and firmware
+             * version from the result. Expects the device to be open.
+             */
+            bool inquiry();
+
+            /**
+             * The capabilities determined by init(), including the identification of
+             * the drive. Used by the DeviceManager to cache them between runs.
+             */
+            QByteArray capabilities() const;
+
+            /**
+             * Apply capabilities returned by capabilities() instead of probing them via
+             * init(). Fails if they do not belong to the same drive model and firmware
+             * as determined by identify().
+             *
+             * @param speeds if false the maximum read and write speeds are left untouched.
+             */
+            bool restoreCapabilities( const QByteArray& data, bool speeds = true );
+
+            /**
+             * Use the usage lock of @p device instead of an own one. This way each
+             * command sent to a second Device object for the same drive waits for
+             * the commands sent via @p device and vice versa.
+             */
+            void shareUsageLock( const Device* device );
+
             void searchIndexTransitions( long start, long end, K3b::Device::Track& track ) const;
+            void searchIndexTransitions( long start, int startIndex, long end, int endIndex, K3b::Device::Track& track ) const;
+
+            /**
+             * Reads the Q sub-channel of @p count sectors with a single READ CD command
+             * and determines the index of each sector.
+             */
+            bool readIndices( unsigned long lba, int count, QVector<int>& indices ) const;
+
+            /**
+             * Like getIndex() but reads the few preceding sectors in the same command.
+             */
+            int probeIndex( unsigned long lba ) const;
             void checkWritingModes();
             void checkFeatures();
             void checkForJustLink();
@@ -736,6 +838,8 @@ namespace K3b {
 
             int getMaxWriteSpeedVia2A() const;
 
+            void determineMaxTransferLength();
+
             QByteArray mediaId( int mediaType ) const;
 
             class Private;
@@ -744,6 +848,38 @@ namespace K3b {
             friend class DeviceManager;
         };
 
+        /**
+         * \brief Keeps a device open for the lifetime of the object.
+         *
+         * Use this around a batch of commands to avoid opening and closing the
+         * device for every single one of them:
+         *
+         * \code
+         *   K3b::Device::HandleLease lease( dev );
+         *   K3b::Device::DiskInfo info = dev->diskInfo();
+         *   K3b::Device::Toc toc = dev->readToc();
+         * \endcode
+         *
+         * \sa Device::acquireHandle()
+         */
+        class LIBK3BDEVICE_EXPORT HandleLease
+        {
+        public:
+            explicit HandleLease( const Device* dev, bool write = false );
+            ~HandleLease();
+
+            /**
+             * \return true if the device could be opened.
+             */
+            bool isValid() const;
+
+        private:
+            const Device* m_device;
+            bool m_acquired;
+
+            Q_DISABLE_COPY( HandleLease )
+        };
+
         /**
          * This should always be used to open a device since it
          * uses the resmgr
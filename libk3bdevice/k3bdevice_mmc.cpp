@@ -26,6 +26,52 @@ bool K3b::Device::Device::testUnitReady() const
 }
 
 
+bool K3b::Device::Device::getMediaEventStatus( MediaEvent& event, bool& mediumPresent ) const
+{
+    unsigned char buf[8];
+    ::memset( buf, 0, sizeof(buf) );
+
+    ScsiCommand cmd( this );
+    cmd.enableErrorMessages( false );
+    cmd[0] = MMC_GET_EVENT_STATUS_NOTIFICATION;
+    cmd[1] = 1;      // polled operation
+    cmd[4] = 0x10;   // media class events
+    cmd[8] = sizeof(buf);
+    cmd[9] = 0;      // Necessary to set the proper command length
+    if( cmd.transport( TR_DIR_READ, buf, sizeof(buf) ) )
+        return false;
+
+    //
+    // No event available (NEA) or another class than the requested media class (4)
+    // means that the device does not support media events.
+    //
+    if( ( buf[2] & 0x80 ) || ( buf[2] & 0x07 ) != 4 || from2Byte( buf ) < 6 )
+        return false;
+
+    switch( buf[4] & 0x0f ) {
+    case 0:
+        event = MediaEventNone;
+        break;
+    case 1:
+        event = MediaEventEjectRequest;
+        break;
+    case 2:
+        event = MediaEventNewMedia;
+        break;
+    case 3:
+        event = MediaEventMediaRemoval;
+        break;
+    default:
+        event = MediaEventMediaChanged;
+        break;
+    }
+
+    mediumPresent = ( buf[5] & 0x02 );
+
+    return true;
+}
+
+
 bool K3b::Device::Device::getFeature( UByteArray& data, unsigned int feature ) const
 {
     unsigned char header[2048];
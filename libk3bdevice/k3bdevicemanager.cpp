@@ -26,13 +26,20 @@
 #include <Solid/GenericInterface>
 #endif
 
+#include <QDataStream>
 #include <QDebug>
+#include <QDir>
+#include <QHash>
 #include <QString>
 #include <QStringList>
 #include <QFile>
 #include <QFileInfo>
 #include <QRegExp>
+#include <QSaveFile>
+#include <QStandardPaths>
 #include <QTemporaryFile>
+#include <QThreadPool>
+#include <QTimer>
 
 #include <iostream>
 #include <limits.h>
@@ -103,9 +110,141 @@ typedef unsigned char u8;
 
 
 
+namespace {
+    // retry interval for drives which were in use when they should have been revalidated
+    const int s_revalidationRetryDelay = 60*1000;
+
+    const quint32 s_capabilityCacheMagic = 0x4b334443; // "K3DC"
+    const quint32 s_capabilityCacheVersion = 1;
+
+    /**
+     * The capabilities of all drive models and firmware versions seen so far.
+     * Probing them requires a lot of commands (some of which are really slow)
+     * so we only do that once per drive and revalidate in the background.
+     */
+    class CapabilityCache
+    {
+    public:
+        CapabilityCache()
+            : m_loaded( false ),
+              m_dirty( false ) {
+        }
+
+        bool find( const K3b::Device::Device* dev, bool writingModesChecked, QByteArray& data ) {
+            load();
+            QHash<QString, Record>::const_iterator it = m_records.constFind( key( dev ) );
+            if( it == m_records.constEnd() || ( writingModesChecked && !it->writingModesChecked ) )
+                return false;
+            data = it->data;
+            return true;
+        }
+
+        void insert( const K3b::Device::Device* dev, bool writingModesChecked, const QByteArray& data ) {
+            load();
+            Record& record = m_records[key( dev )];
+            if( record.data != data || record.writingModesChecked != writingModesChecked ) {
+                record.writingModesChecked = writingModesChecked;
+                record.data = data;
+                m_dirty = true;
+            }
+        }
+
+        void save();
+
+    private:
+        struct Record {
+            Record()
+                : writingModesChecked( false ) {
+            }
+
+            bool writingModesChecked;
+            QByteArray data;
+        };
+
+        friend QDataStream& operator<<( QDataStream& s, const Record& r ) {
+            return s << r.writingModesChecked << r.data;
+        }
+
+        friend QDataStream& operator>>( QDataStream& s, Record& r ) {
+            return s >> r.writingModesChecked >> r.data;
+        }
+
+        static QString key( const K3b::Device::Device* dev ) {
+            return dev->vendor() + QLatin1Char( '\n' ) + dev->description() + QLatin1Char( '\n' ) + dev->version();
+        }
+
+        static QString filename() {
+            return QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) + QLatin1String( "/drivecapabilities" );
+        }
+
+        void load();
+
+        bool m_loaded;
+        bool m_dirty;
+        QHash<QString, Record> m_records;
+    };
+
+
+    void CapabilityCache::load()
+    {
+        if( m_loaded )
+            return;
+        m_loaded = true;
+
+        QFile f( filename() );
+        if( !f.open( QIODevice::ReadOnly ) )
+            return;
+
+        QDataStream s( &f );
+        s.setVersion( QDataStream::Qt_5_15 );
+
+        quint32 magic, version;
+        s >> magic >> version;
+        if( magic != s_capabilityCacheMagic || version != s_capabilityCacheVersion )
+            return;
+
+        s >> m_records;
+        if( s.status() != QDataStream::Ok ) {
+            qDebug() << "(K3b::Device::DeviceManager) corrupt capability cache" << f.fileName();
+            m_records.clear();
+        }
+    }
+
+
+    void CapabilityCache::save()
+    {
+        if( !m_dirty )
+            return;
+
+        const QString fn = filename();
+        QDir().mkpath( QFileInfo( fn ).absolutePath() );
+
+        QSaveFile f( fn );
+        if( !f.open( QIODevice::WriteOnly ) )
+            return;
+
+        QDataStream s( &f );
+        s.setVersion( QDataStream::Qt_5_15 );
+        s << s_capabilityCacheMagic << s_capabilityCacheVersion << m_records;
+        if( s.status() == QDataStream::Ok && f.commit() )
+            m_dirty = false;
+        else
+            qDebug() << "(K3b::Device::DeviceManager) failed to write capability cache" << fn;
+    }
+}
+
+
 class K3b::Device::DeviceManager::Private
 {
 public:
+    Private()
+        : checkWritingModes( true ),
+          revalidationScheduled( false ) {
+    }
+
+    void addToLists( Device* device );
+    void removeFromLists( Device* device );
+
     QList<Device*> allDevices;
     QList<Device*> cdReader;
     QList<Device*> cdWriter;
@@ -115,9 +254,52 @@ public:
     QList<Device*> bdWriter;
 
     bool checkWritingModes;
+
+    CapabilityCache capabilityCache;
+
+    // devices initialized from the cache which have not been revalidated yet
+    QList<Device*> cachedDevices;
+
+    // the devices probing in the background mapped to the devices they revalidate
+    QHash<Device*, Device*> revalidations;
+    QThreadPool revalidationPool;
+
+    // removed devices which are kept until their revalidation finished
+    QList<Device*> detachedDevices;
+    bool revalidationScheduled;
 };
 
 
+void K3b::Device::DeviceManager::Private::addToLists( Device* device )
+{
+    // not every drive is able to read CDs
+    // there are some 1st generation DVD writer that cannot
+    if( device->type() & K3b::Device::DEVICE_CD_ROM )
+        cdReader.append( device );
+    if( device->readsDvd() )
+        dvdReader.append( device );
+    if( device->writesCd() )
+        cdWriter.append( device );
+    if( device->writesDvd() )
+        dvdWriter.append( device );
+    if( device->readCapabilities() & MEDIA_BD_ALL )
+        bdReader.append( device );
+    if( device->writeCapabilities() & MEDIA_BD_ALL )
+        bdWriter.append( device );
+}
+
+
+void K3b::Device::DeviceManager::Private::removeFromLists( Device* device )
+{
+    cdReader.removeAll( device );
+    dvdReader.removeAll( device );
+    bdReader.removeAll( device );
+    cdWriter.removeAll( device );
+    dvdWriter.removeAll( device );
+    bdWriter.removeAll( device );
+}
+
+
 
 K3b::Device::DeviceManager::DeviceManager( QObject* parent )
     : QObject( parent ),
@@ -132,6 +314,9 @@ K3b::Device::DeviceManager::DeviceManager( QObject* parent )
 
 K3b::Device::DeviceManager::~DeviceManager()
 {
+    d->revalidationPool.waitForDone();
+    qDeleteAll( d->revalidations.keys() );
+    qDeleteAll( d->detachedDevices );
     qDeleteAll( d->allDevices );
     delete d;
 }
@@ -282,11 +467,18 @@ void K3b::Device::DeviceManager::clear()
     // signals return
     QList<Device*> devicesToDelete( d->allDevices );
     d->allDevices.clear();
+    d->cachedDevices.clear();
 
     emit changed( this );
     emit changed();
 
-    qDeleteAll( devicesToDelete );
+    Q_FOREACH( Device* device, devicesToDelete ) {
+        // the probe still uses the usage lock of the device
+        if( d->revalidations.key( device ) )
+            d->detachedDevices.append( device );
+        else
+            delete device;
+    }
 }
 
 
@@ -367,7 +559,7 @@ K3b::Device::Device* K3b::Device::DeviceManager::addDevice( K3b::Device::Device*
 {
     const QString devicename = device->blockDeviceName();
 
-    if( !device->init() ) {
+    if( !initDevice( device ) ) {
         qDebug() << "Could not initialize device " << devicename;
         delete device;
         return 0;
@@ -375,21 +567,7 @@ K3b::Device::Device* K3b::Device::DeviceManager::addDevice( K3b::Device::Device*
 
     if( device ) {
         d->allDevices.append( device );
-
-        // not every drive is able to read CDs
-        // there are some 1st generation DVD writer that cannot
-        if( device->type() & K3b::Device::DEVICE_CD_ROM )
-            d->cdReader.append( device );
-        if( device->readsDvd() )
-            d->dvdReader.append( device );
-        if( device->writesCd() )
-            d->cdWriter.append( device );
-        if( device->writesDvd() )
-            d->dvdWriter.append( device );
-        if( device->readCapabilities() & MEDIA_BD_ALL )
-            d->bdReader.append( device );
-        if( device->writeCapabilities() & MEDIA_BD_ALL )
-            d->bdWriter.append( device );
+        d->addToLists( device );
 
         if( device->writesCd() ) {
             // default to max write speed
@@ -407,22 +585,122 @@ K3b::Device::Device* K3b::Device::DeviceManager::addDevice( K3b::Device::Device*
 }
 
 
+bool K3b::Device::DeviceManager::initDevice( Device* device )
+{
+    QByteArray data;
+    if( device->identify() &&
+        d->capabilityCache.find( device, d->checkWritingModes, data ) &&
+        device->restoreCapabilities( data ) ) {
+        qDebug() << "(K3b::Device::DeviceManager) using cached capabilities for" << device->blockDeviceName();
+        // this depends on the host, not the drive
+        device->determineMaxTransferLength();
+        d->cachedDevices.append( device );
+        return true;
+    }
+
+    if( !device->init( d->checkWritingModes ) )
+        return false;
+
+    d->capabilityCache.insert( device, d->checkWritingModes, device->capabilities() );
+    d->capabilityCache.save();
+    return true;
+}
+
+
+void K3b::Device::DeviceManager::revalidateCapabilities()
+{
+    d->revalidationScheduled = false;
+
+    const bool checkWritingModes = d->checkWritingModes;
+    const QList<Device*> devices = d->cachedDevices;
+    d->cachedDevices.clear();
+    Q_FOREACH( Device* device, devices ) {
+        //
+        // The probing sends MODE SELECT commands which must not interfere
+        // with a running job. Thus, we leave drives alone while they are
+        // open or locked. The probe shares the usage lock of the device so
+        // each of its commands waits for the commands sent via the device
+        // (and for an external writer locking it) without blocking them for
+        // longer than a single command.
+        //
+        if( device->isOpen() || !device->tryUsageLock() ) {
+            deferRevalidation( device );
+            continue;
+        }
+        device->usageUnlock();
+
+        Device* probe = new Device( device->solidDevice() );
+        probe->shareUsageLock( device );
+        d->revalidations.insert( probe, device );
+        d->revalidationPool.start( [this, probe, checkWritingModes]() {
+            const bool success = probe->init( checkWritingModes );
+            QMetaObject::invokeMethod( this, [this, probe, success]() {
+                finishRevalidation( probe, success );
+            }, Qt::QueuedConnection );
+        } );
+    }
+}
+
+
+void K3b::Device::DeviceManager::deferRevalidation( Device* device )
+{
+    qDebug() << "(K3b::Device::DeviceManager)" << device->blockDeviceName() << "in use. Deferring revalidation.";
+    d->cachedDevices.append( device );
+    if( !d->revalidationScheduled ) {
+        d->revalidationScheduled = true;
+        QTimer::singleShot( s_revalidationRetryDelay, this, &DeviceManager::revalidateCapabilities );
+    }
+}
+
+
+void K3b::Device::DeviceManager::finishRevalidation( Device* probe, bool success )
+{
+    Device* device = d->revalidations.take( probe );
+
+    // the device has been removed in the meantime
+    if( d->detachedDevices.removeOne( device ) ) {
+        delete probe;
+        delete device;
+        return;
+    }
+
+    if( success ) {
+        const QByteArray data = probe->capabilities();
+        d->capabilityCache.insert( probe, d->checkWritingModes, data );
+        d->capabilityCache.save();
+
+        // keep the speeds which might have been changed by the user in the meantime
+        const QByteArray oldData = device->capabilities();
+        if( device->restoreCapabilities( data, false ) && device->capabilities() != oldData ) {
+            qDebug() << "(K3b::Device::DeviceManager) capabilities of" << device->blockDeviceName() << "changed.";
+            d->removeFromLists( device );
+            d->addToLists( device );
+
+            emit changed( this );
+            emit changed();
+        }
+    }
+
+    delete probe;
+}
+
+
 void K3b::Device::DeviceManager::removeDevice( const Solid::Device& dev )
 {
     if( const Solid::Block* blockDevice = dev.as<Solid::Block>() ) {
         if( Device* device = findDevice( blockDevice->device() ) ) {
-            d->cdReader.removeAll( device );
-            d->dvdReader.removeAll( device );
-            d->bdReader.removeAll( device );
-            d->cdWriter.removeAll( device );
-            d->dvdWriter.removeAll( device );
-            d->bdWriter.removeAll( device );
+            d->removeFromLists( device );
             d->allDevices.removeAll( device );
+            d->cachedDevices.removeAll( device );
 
             emit changed( this );
             emit changed();
 
-            delete device;
+            // the probe still uses the usage lock of the device
+            if( d->revalidations.key( device ) )
+                d->detachedDevices.append( device );
+            else
+                delete device;
         }
     }
 }
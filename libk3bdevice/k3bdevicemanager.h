@@ -173,6 +173,16 @@ namespace K3b {
              */
             virtual void clear();
 
+            /**
+             * The capabilities of known drive models are restored from a cache
+             * instead of being probed. This probes all devices initialized that
+             * way in the background and updates them if anything changed.
+             * Drives which are in use are revalidated later.
+             *
+             * Call this once the application is up and running.
+             */
+            void revalidateCapabilities();
+
         Q_SIGNALS:
             /**
              * Emitted if the device configuration changed, i.e. a device was added or removed.
@@ -208,6 +218,17 @@ namespace K3b {
              * Add a device to the managers device lists and initialize the device.
              */
             Device *addDevice( Device* );
+
+            /**
+             * Initialize the device from the capability cache or by probing it.
+             */
+            bool initDevice( Device* );
+
+            /**
+             * Revalidate @p device later since it is currently in use.
+             */
+            void deferRevalidation( Device* device );
+            void finishRevalidation( Device* probe, bool success );
         };
     }
 }
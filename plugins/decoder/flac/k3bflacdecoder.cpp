@@ -414,6 +414,15 @@ K3b::AudioDecoder* K3bFLACDecoderFactory::createDecoder( QObject* parent) const
 }
 
 
+K3b::AudioDecoderFactory::FileSignature K3bFLACDecoderFactory::checkSignature( const QByteArray& header ) const
+{
+    if( header.startsWith( "fLaC" ) )
+        return SignatureMatch;
+    else
+        return SignatureMismatch;
+}
+
+
 bool K3bFLACDecoderFactory::canDecode( const QUrl& url )
 {
     // buffer large enough to read an ID3 tag header
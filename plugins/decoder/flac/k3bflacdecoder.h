@@ -22,6 +22,7 @@ public:
     K3bFLACDecoderFactory( QObject* parent, const QVariantList& args );
     ~K3bFLACDecoderFactory() override;
 
+    FileSignature checkSignature( const QByteArray& header ) const override;
     bool canDecode( const QUrl& filename ) override;
 
     int pluginSystemVersion() const override { return K3B_PLUGIN_SYSTEM_VERSION; }
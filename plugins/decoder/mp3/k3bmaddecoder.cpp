@@ -21,12 +21,14 @@
 
 #include <config-k3b.h>
 
+#include <QDataStream>
 #include <QDebug>
 #include <QString>
 #include <QFile>
 #include <QVector>
 
 #include <stdlib.h>
+#include <string.h>
 #include <cmath>
 #include <cstdlib>
 
@@ -88,6 +90,9 @@ K3bMadDecoder::~K3bMadDecoder()
 
 QString K3bMadDecoder::metaInfo( MetaDataField f )
 {
+    if( metaInfoCollected() )
+        return K3b::AudioDecoder::metaInfo( f );
+
 #ifdef ENABLE_TAGLIB
     TagLib::MPEG::File file( QFile::encodeName( filename() ).data() );
 
@@ -115,8 +120,21 @@ QString K3bMadDecoder::metaInfo( MetaDataField f )
 
 bool K3bMadDecoder::analyseFileInternal( K3b::Msf& frames, int& samplerate, int& ch )
 {
-    initDecoderInternal();
-    frames = countFrames();
+    //
+    // Most encoders write a Xing/Info or VBRI header into the first frame which
+    // contains the number of frames. Only if it is missing we have to count them.
+    // The seek table is then built when it is needed for the first time.
+    //
+    d->seekPositions.clear();
+    if( !initDecoderInternal() )
+        return false;
+    frames = readVbrHeader();
+    if( frames == 0 ) {
+        if( !initDecoderInternal() )
+            return false;
+        frames = countFrames();
+    }
+
     if( frames > 0 ) {
         // we convert mono to stereo all by ourselves. :)
         ch = 2;
@@ -128,6 +146,94 @@ bool K3bMadDecoder::analyseFileInternal( K3b::Msf& frames, int& samplerate, int&
 }
 
 
+QByteArray K3bMadDecoder::analysisData() const
+{
+    QByteArray data;
+    QDataStream s( &data, QIODevice::WriteOnly );
+    s.setVersion( QDataStream::Qt_5_15 );
+
+    s << quint8( 2 )
+      << qint32( d->firstHeader.layer )
+      << qint32( d->firstHeader.mode )
+      << qint32( d->firstHeader.mode_extension )
+      << qint32( d->firstHeader.emphasis )
+      << quint32( d->firstHeader.bitrate )
+      << quint32( d->firstHeader.samplerate )
+      << qint32( d->firstHeader.flags )
+      << qint64( d->firstHeader.duration.seconds )
+      << quint64( d->firstHeader.duration.fraction )
+      << d->vbr;
+
+    // The seek table is empty unless a seek required it. The frames are stored
+    // back to back so the differences between the positions are small and
+    // mostly equal which compresses very well.
+    QByteArray seekTable;
+    QDataStream seekStream( &seekTable, QIODevice::WriteOnly );
+    seekStream << quint32( d->seekPositions.count() );
+    unsigned long long lastPos = 0;
+    for( int i = 0; i < d->seekPositions.count(); ++i ) {
+        seekStream << quint64( d->seekPositions[i] - lastPos );
+        lastPos = d->seekPositions[i];
+    }
+    s << qCompress( seekTable );
+
+    return data;
+}
+
+
+bool K3bMadDecoder::restoreAnalysisData( const QByteArray& data )
+{
+    QDataStream s( data );
+    s.setVersion( QDataStream::Qt_5_15 );
+
+    quint8 version;
+    qint32 layer, mode, modeExtension, emphasis, flags;
+    quint32 bitrate, samplerate;
+    qint64 seconds;
+    quint64 fraction;
+    bool vbr;
+    QByteArray compressedSeekTable;
+    s >> version;
+    if( version != 2 )
+        return false;
+    s >> layer >> mode >> modeExtension >> emphasis >> bitrate >> samplerate
+      >> flags >> seconds >> fraction >> vbr >> compressedSeekTable;
+    if( s.status() != QDataStream::Ok )
+        return false;
+
+    QByteArray seekTable = qUncompress( compressedSeekTable );
+    QDataStream seekStream( seekTable );
+    quint32 count;
+    seekStream >> count;
+    QVector<unsigned long long> seekPositions;
+    seekPositions.reserve( count );
+    unsigned long long pos = 0;
+    for( quint32 i = 0; i < count && seekStream.status() == QDataStream::Ok; ++i ) {
+        quint64 delta;
+        seekStream >> delta;
+        pos += delta;
+        seekPositions.append( pos );
+    }
+    if( seekStream.status() != QDataStream::Ok || samplerate == 0 )
+        return false;
+
+    mad_header_init( &d->firstHeader );
+    d->firstHeader.layer = static_cast<mad_layer>( layer );
+    d->firstHeader.mode = static_cast<mad_mode>( mode );
+    d->firstHeader.mode_extension = modeExtension;
+    d->firstHeader.emphasis = static_cast<mad_emphasis>( emphasis );
+    d->firstHeader.bitrate = bitrate;
+    d->firstHeader.samplerate = samplerate;
+    d->firstHeader.flags = flags;
+    d->firstHeader.duration.seconds = seconds;
+    d->firstHeader.duration.fraction = fraction;
+    d->vbr = vbr;
+    d->seekPositions = seekPositions;
+
+    return true;
+}
+
+
 bool K3bMadDecoder::initDecoderInternal()
 {
     cleanup();
@@ -147,6 +253,71 @@ bool K3bMadDecoder::initDecoderInternal()
 }
 
 
+namespace {
+    inline unsigned long readBigEndian32( const unsigned char* p )
+    {
+        return ( (unsigned long)p[0] << 24 ) | ( (unsigned long)p[1] << 16 ) | ( (unsigned long)p[2] << 8 ) | p[3];
+    }
+}
+
+
+unsigned long K3bMadDecoder::readVbrHeader()
+{
+    unsigned long frames = 0;
+
+    if( d->handle->findNextHeader() ) {
+        const mad_header& header = d->handle->madFrame->header;
+        const unsigned char* frame = d->handle->madStream->this_frame;
+        const long available = d->handle->madStream->bufend - frame;
+
+        unsigned long vbrFrames = 0;
+        bool vbr = false;
+
+        if( header.layer == MAD_LAYER_III ) {
+            // the Xing header follows the side information
+            bool mono = ( header.mode == MAD_MODE_SINGLE_CHANNEL );
+            long offset = 4;
+            if( header.flags & MAD_FLAG_PROTECTION )
+                offset += 2;
+            if( header.flags & MAD_FLAG_LSF_EXT )
+                offset += ( mono ? 9 : 17 );
+            else
+                offset += ( mono ? 17 : 32 );
+
+            if( offset + 12 <= available &&
+                ( !memcmp( frame + offset, "Xing", 4 ) || !memcmp( frame + offset, "Info", 4 ) ) ) {
+                // the frame count is optional
+                if( readBigEndian32( frame + offset + 4 ) & 0x1 )
+                    vbrFrames = readBigEndian32( frame + offset + 8 );
+                vbr = !memcmp( frame + offset, "Xing", 4 );
+            }
+
+            // the VBRI header of the Fraunhofer encoder is always at the same position
+            else if( 36 + 18 <= available && !memcmp( frame + 36, "VBRI", 4 ) ) {
+                vbrFrames = readBigEndian32( frame + 36 + 14 );
+                vbr = true;
+            }
+        }
+
+        if( vbrFrames > 0 ) {
+            d->firstHeader = header;
+            d->vbr = vbr;
+
+            // the frame containing the header is not counted but countFrames() does so
+            double frameSecs = static_cast<double>(header.duration.seconds)
+                               + static_cast<double>(header.duration.fraction) / static_cast<double>(MAD_TIMER_RESOLUTION);
+            double seconds = frameSecs * static_cast<double>( vbrFrames + 1 );
+            frames = (unsigned long)ceil(seconds * 75.0);
+            qDebug() << "(K3bMadDecoder) length of track from " << ( vbr ? "VBR" : "CBR" ) << " header " << seconds;
+        }
+    }
+
+    cleanup();
+
+    return frames;
+}
+
+
 unsigned long K3bMadDecoder::countFrames()
 {
     qDebug() << "(K3bMadDecoder::countFrames)";
@@ -292,6 +463,20 @@ void K3bMadDecoder::cleanup()
 
 bool K3bMadDecoder::seekInternal( const K3b::Msf& pos )
 {
+    //
+    // The seek table is only built once it is needed. This requires to scan the whole file.
+    // The table is only added to the analysis cache in memory, it is written to disk
+    // together with the rest of the cache.
+    //
+    if( d->seekPositions.isEmpty() ) {
+        if( !initDecoderInternal() )
+            return false;
+        countFrames();
+        if( d->seekPositions.isEmpty() )
+            return false;
+        updateAnalysisCache();
+    }
+
     //
     // we need to reset the complete mad stuff
     //
@@ -316,6 +501,9 @@ bool K3bMadDecoder::seekInternal( const K3b::Msf& pos )
 
     frame -= frameReservoirProtect;
 
+    if( frame >= static_cast<unsigned int>( d->seekPositions.count() ) )
+        return false;
+
     // seek in the input file behind the already decoded data
     d->handle->inputSeek( d->seekPositions[frame] );
 
@@ -457,6 +645,28 @@ K3b::AudioDecoder* K3bMadDecoderFactory::createDecoder( QObject* parent) const
 }
 
 
+K3b::AudioDecoderFactory::FileSignature K3bMadDecoderFactory::checkSignature( const QByteArray& header ) const
+{
+    //
+    // Search for a valid MPEG audio frame header. K3bMad::seekFirstHeader()
+    // accepts more junk in front of the first frame than we get here, so
+    // not finding one does not rule out the file.
+    //
+    const unsigned char* data = reinterpret_cast<const unsigned char*>( header.constData() );
+    for( int i = 0; i + 4 <= header.size(); ++i ) {
+        const unsigned char* p = data + i;
+        if( p[0] == 0xff && ( p[1] & 0xe0 ) == 0xe0 &&  // frame sync
+            ( ( p[1] >> 3 ) & 0x3 ) != 0x1 &&           // reserved version
+            ( ( p[1] >> 1 ) & 0x3 ) != 0x0 &&           // reserved layer
+            ( p[2] >> 4 ) != 0xf &&                     // bad bitrate
+            ( ( p[2] >> 2 ) & 0x3 ) != 0x3 )            // reserved samplerate
+            return SignatureMatch;
+    }
+
+    return SignatureUnknown;
+}
+
+
 bool K3bMadDecoderFactory::canDecode( const QUrl& url )
 {
     //
@@ -23,6 +23,7 @@ public:
     explicit K3bMadDecoderFactory( QObject* parent = 0, const QVariantList& args = QVariantList() );
     ~K3bMadDecoderFactory() override;
 
+    FileSignature checkSignature( const QByteArray& header ) const override;
     bool canDecode( const QUrl& filename ) override;
 
     int pluginSystemVersion() const override { return K3B_PLUGIN_SYSTEM_VERSION; }
@@ -54,8 +55,12 @@ protected:
     bool initDecoderInternal() override;
 
     int decodeInternal( char* _data, int maxLen ) override;
+
+    QByteArray analysisData() const override;
+    bool restoreAnalysisData( const QByteArray& ) override;
  
 private:
+    unsigned long readVbrHeader();
     unsigned long countFrames();
     inline unsigned short linearRound( mad_fixed_t fixed );
     bool createPcmSamples( mad_synth* );
@@ -31,6 +31,16 @@ K3b::AudioDecoder* K3bMpcDecoderFactory::createDecoder( QObject* parent
 }
 
 
+K3b::AudioDecoderFactory::FileSignature K3bMpcDecoderFactory::checkSignature( const QByteArray& header ) const
+{
+    // stream version 7 and 8
+    if( header.startsWith( "MP+" ) || header.startsWith( "MPCK" ) )
+        return SignatureMatch;
+    else
+        return SignatureMismatch;
+}
+
+
 bool K3bMpcDecoderFactory::canDecode( const QUrl& url )
 {
     K3bMpcWrapper w;
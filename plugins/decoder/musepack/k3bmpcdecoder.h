@@ -20,6 +20,7 @@ public:
     K3bMpcDecoderFactory( QObject* parent, const QVariantList& );
     ~K3bMpcDecoderFactory() override;
 
+    FileSignature checkSignature( const QByteArray& header ) const override;
     bool canDecode( const QUrl& filename ) override;
 
     int pluginSystemVersion() const override { return K3B_PLUGIN_SYSTEM_VERSION; }
@@ -210,6 +210,16 @@ K3b::AudioDecoder* K3bOggVorbisDecoderFactory::createDecoder( QObject* parent )
 }
 
 
+K3b::AudioDecoderFactory::FileSignature K3bOggVorbisDecoderFactory::checkSignature( const QByteArray& header ) const
+{
+    // the first page of the stream contains the vorbis identification header
+    if( header.startsWith( "OggS" ) && header.mid( 28, 7 ) == QByteArray( "\x01" "vorbis" ) )
+        return SignatureMatch;
+    else
+        return SignatureMismatch;
+}
+
+
 bool K3bOggVorbisDecoderFactory::canDecode( const QUrl& url )
 {
     FILE* file = fopen( QFile::encodeName(url.toLocalFile()), "r" );
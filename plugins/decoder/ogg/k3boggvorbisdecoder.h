@@ -19,6 +19,7 @@ public:
     K3bOggVorbisDecoderFactory( QObject* parent, const QVariantList& );
     ~K3bOggVorbisDecoderFactory() override;
 
+    FileSignature checkSignature( const QByteArray& header ) const override;
     bool canDecode( const QUrl& filename ) override;
 
     int pluginSystemVersion() const override { return K3B_PLUGIN_SYSTEM_VERSION; }
@@ -356,6 +356,15 @@ K3b::AudioDecoder* K3bWaveDecoderFactory::createDecoder( QObject* parent ) const
 }
 
 
+K3b::AudioDecoderFactory::FileSignature K3bWaveDecoderFactory::checkSignature( const QByteArray& header ) const
+{
+    if( header.size() >= 12 && header.startsWith( "RIFF" ) && header.mid( 8, 4 ) == "WAVE" )
+        return SignatureMatch;
+    else
+        return SignatureMismatch;
+}
+
+
 bool K3bWaveDecoderFactory::canDecode( const QUrl& url )
 {
     QFile f( url.toLocalFile() );
@@ -18,6 +18,7 @@ public:
     K3bWaveDecoderFactory( QObject* parent, const QVariantList& );
     ~K3bWaveDecoderFactory() override;
 
+    FileSignature checkSignature( const QByteArray& header ) const override;
     bool canDecode( const QUrl& filename ) override;
 
     int pluginSystemVersion() const override { return K3B_PLUGIN_SYSTEM_VERSION; }
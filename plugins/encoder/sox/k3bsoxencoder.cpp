@@ -14,6 +14,7 @@
 #include "k3bprocess.h"
 #include "k3bcore.h"
 #include "k3bexternalbinmanager.h"
+#include "k3bexternalbincache.h"
 #include "k3bplugin_i18n.h"
 
 #include <KConfig>
@@ -53,7 +54,15 @@ public:
         if( !QFile::exists( path ) )
             return false;
 
-        K3b::ExternalBin* bin = 0;
+        K3b::ExternalBin* bin = new K3b::ExternalBin( *this, path );
+        if( K3b::ExternalBinCache::instance()->find( *bin ) ) {
+            if( bin->isEmpty() ) {
+                delete bin;
+                return false;
+            }
+            addBin( bin );
+            return true;
+        }
 
         // probe version
         KProcess vp;
@@ -78,15 +87,19 @@ public:
             }
             int endPos = out.indexOf( '\n', pos );
             if( pos > 0 && endPos > 0 ) {
-                bin = new K3b::ExternalBin( *this, path );
                 bin->setVersion( K3b::Version( out.mid( pos, endPos-pos ) ) );
+                K3b::ExternalBinCache::instance()->insert( *bin );
 
                 addBin( bin );
 
                 return true;
             }
+
+            // sox ran but is of no use to us
+            K3b::ExternalBinCache::instance()->insert( K3b::ExternalBin( *this, path ) );
         }
 
+        delete bin;
         return false;
     }
 };
@@ -96,6 +96,8 @@ void K3b::Application::init( QCommandLineParser* commandLineParser )
     QMetaObject::invokeMethod( m_core, "init", Qt::QueuedConnection );
     QMetaObject::invokeMethod( m_core, "readSettings", Qt::QueuedConnection, Q_ARG( KSharedConfig::Ptr, KSharedConfig::openConfig() ) );
     QMetaObject::invokeMethod( m_core->deviceManager(), "printDevices", Qt::QueuedConnection );
+    // devices are initialized from cached capabilities, recheck them now that the UI is up
+    QMetaObject::invokeMethod( m_core->deviceManager(), "revalidateCapabilities", Qt::QueuedConnection );
     QMetaObject::invokeMethod( this, "checkSystemConfig", Qt::QueuedConnection );
 
     connect( this, SIGNAL(aboutToQuit()), SLOT(slotShutDown()) );
@@ -38,10 +38,9 @@
 #include <QHash>
 #include <QList>
 #include <QTemporaryFile>
-#include <QTextStream>
 #include <QUrl>
-#include <QDomDocument>
-#include <QDomElement>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 #include <QCursor>
 #include <QApplication>
 
@@ -452,8 +451,8 @@ K3b::Doc* K3b::ProjectManager::openProject( const QUrl& url )
 
     // ///////////////////////////////////////////////
     // first check if it's a store or an old plain xml file
-    bool success = false;
-    QDomDocument xmlDoc;
+    K3b::Doc* newDoc = 0;
+    bool isStore = false;
 
     // try opening a store
     KoStore* store = KoStore::createStore( tmpfile.fileName(), KoStore::Read );
@@ -461,10 +460,10 @@ K3b::Doc* K3b::ProjectManager::openProject( const QUrl& url )
         if( !store->bad() ) {
             // try opening the document inside the store
             if( store->open( "maindata.xml" ) ) {
+                isStore = true;
                 QIODevice* dev = store->device();
                 dev->open( QIODevice::ReadOnly );
-                if( xmlDoc.setContent( dev ) )
-                    success = true;
+                newDoc = readProject( dev );
                 dev->close();
                 store->close();
             }
@@ -473,18 +472,18 @@ K3b::Doc* K3b::ProjectManager::openProject( const QUrl& url )
         delete store;
     }
 
-    if( !success ) {
+    if( !isStore ) {
         // try reading an old plain document
-        tmpfile.remove();
         if ( tmpfile.open() ) {
             //
             // First check if this is really an xml file because if this is a very big file
-            // the setContent method blocks for a very long time
+            // the parsing would take a very long time
             //
             char test[5];
             if( tmpfile.read( test, 5 ) ) {
                 if( ::strncmp( test, "<?xml", 5 ) ) {
                     qDebug() << "(K3b::Doc) " << url.toLocalFile() << " seems to be no xml file.";
+                    tmpfile.remove();
                     QApplication::restoreOverrideCursor();
                     return 0;
                 }
@@ -492,43 +491,80 @@ K3b::Doc* K3b::ProjectManager::openProject( const QUrl& url )
             }
             else {
                 qDebug() << "(K3b::Doc) could not read from file.";
+                tmpfile.remove();
                 QApplication::restoreOverrideCursor();
                 return 0;
             }
-            if( xmlDoc.setContent( &tmpfile ) )
-                success = true;
-            tmpfile.remove();
+            newDoc = readProject( &tmpfile );
         }
     }
+    tmpfile.remove();
 
     // ///////////////////////////////////////////////
-    if( !success ) {
+    if( newDoc ) {
+        newDoc->setURL( url );
+        newDoc->setSaved( true );
+        newDoc->setModified( false );
+
+        // ok, finish the doc setup, inform the others about the new project
+        //dcopInterface( newDoc );
+        addProject( newDoc );
+
+        // FIXME: find a better way to tell everyone (especially the projecttabwidget)
+        //        that the doc is not changed
+        emit projectSaved( newDoc );
+
+        qDebug() << "(K3b::ProjectManager) loading project done.";
+    }
+    else {
         qDebug() << "(K3b::Doc) could not open file " << url.toLocalFile();
-        QApplication::restoreOverrideCursor();
+    }
+
+    QApplication::restoreOverrideCursor();
+
+    return newDoc;
+}
+
+
+K3b::Doc* K3b::ProjectManager::readProject( QIODevice* dev )
+{
+    // the items are created while parsing, this way huge projects
+    // never exist as a whole in memory as xml
+    QXmlStreamReader reader( dev );
+
+    QString docType;
+    while( !reader.atEnd() ) {
+        reader.readNext();
+        if( reader.isDTD() )
+            docType = reader.dtdName().toString();
+        else if( reader.isStartElement() )
+            break;
+    }
+    if( !reader.isStartElement() ) {
+        qDebug() << "(K3b::Doc) no document element found:" << reader.errorString();
         return 0;
     }
 
     // check the documents DOCTYPE
     K3b::Doc::Type type = K3b::Doc::AudioProject;
-    if( xmlDoc.doctype().name() == "k3b_audio_project" )
+    if( docType == "k3b_audio_project" )
         type = K3b::Doc::AudioProject;
-    else if( xmlDoc.doctype().name() == "k3b_data_project" )
+    else if( docType == "k3b_data_project" )
         type = K3b::Doc::DataProject;
-    else if( xmlDoc.doctype().name() == "k3b_vcd_project" )
+    else if( docType == "k3b_vcd_project" )
         type = K3b::Doc::VcdProject;
-    else if( xmlDoc.doctype().name() == "k3b_mixed_project" )
+    else if( docType == "k3b_mixed_project" )
         type = K3b::Doc::MixedProject;
-    else if( xmlDoc.doctype().name() == "k3b_movix_project" )
+    else if( docType == "k3b_movix_project" )
         type = K3b::Doc::MovixProject;
-    else if( xmlDoc.doctype().name() == "k3b_movixdvd_project" )
+    else if( docType == "k3b_movixdvd_project" )
         type = K3b::Doc::MovixProject; // backward compatibility
-    else if( xmlDoc.doctype().name() == "k3b_dvd_project" )
+    else if( docType == "k3b_dvd_project" )
         type = K3b::Doc::DataProject; // backward compatibility
-    else if( xmlDoc.doctype().name() == "k3b_video_dvd_project" ) {
+    else if( docType == "k3b_video_dvd_project" ) {
         type = K3b::Doc::VideoDvdProject;
     } else {
-        qDebug() << "(K3b::Doc) unknown doc type: " << xmlDoc.doctype().name();
-        QApplication::restoreOverrideCursor();
+        qDebug() << "(K3b::Doc) unknown doc type: " << docType;
         return 0;
     }
 
@@ -537,29 +573,22 @@ K3b::Doc* K3b::ProjectManager::openProject( const QUrl& url )
 
     // ---------
     // load the data into the document
-    QDomElement root = xmlDoc.documentElement();
-    if( newDoc->loadDocumentData( &root ) ) {
-        newDoc->setURL( url );
-        newDoc->setSaved( true );
-        newDoc->setModified( false );
-
-        // ok, finish the doc setup, inform the others about the new project
-        //dcopInterface( newDoc );
-        addProject( newDoc );
-
-        // FIXME: find a better way to tell everyone (especially the projecttabwidget)
-        //        that the doc is not changed
-        emit projectSaved( newDoc );
-
-        qDebug() << "(K3b::ProjectManager) loading project done.";
+    bool success = newDoc->loadDocumentStream( reader );
+
+    // like QDomDocument reject documents which are not well-formed after the project data
+    while( success && !reader.atEnd() )
+        reader.readNext();
+    if( reader.hasError() ) {
+        qDebug() << "(K3b::Doc) parsing failed:" << reader.errorString()
+                 << "at line" << reader.lineNumber();
+        success = false;
     }
-    else {
+
+    if( !success ) {
         delete newDoc;
         newDoc = 0;
     }
 
-    QApplication::restoreOverrideCursor();
-
     return newDoc;
 }
 
@@ -582,19 +611,25 @@ bool K3b::ProjectManager::saveProject( K3b::Doc* doc, const QUrl& url )
             // open the document inside the store
             store->open( "maindata.xml" );
 
-            // save the data in the document
-            QDomDocument xmlDoc( "k3b_" + doc->typeString() + "_project" );
-
-            xmlDoc.appendChild( xmlDoc.createProcessingInstruction( "xml", "version=\"1.0\" encoding=\"UTF-8\"" ) );
-            QDomElement docElem = xmlDoc.createElement( "k3b_" + doc->typeString() + "_project" );
-            xmlDoc.appendChild( docElem );
-            success = doc->saveDocumentData( &docElem );
-            if( success ) {
+            // save the data in the document while writing it
+            {
                 KoStoreDevice dev(store);
                 dev.open( QIODevice::WriteOnly );
-                QTextStream xmlStream( &dev );
-                xmlDoc.save( xmlStream, 0 );
+                QXmlStreamWriter writer( &dev );
+                writer.setAutoFormatting( true );
+                writer.setAutoFormattingIndent( 0 );
+
+                const QString docElemName = "k3b_" + doc->typeString() + "_project";
+                writer.writeStartDocument();
+                writer.writeDTD( "<!DOCTYPE " + docElemName + '>' );
+                writer.writeStartElement( docElemName );
+                success = doc->saveDocumentStream( writer );
+                writer.writeEndElement();
+                writer.writeEndDocument();
+                success = success && !writer.hasError();
+            }
 
+            if( success ) {
                 doc->setURL( url );
                 doc->setModified( false );
             }
@@ -12,6 +12,7 @@
 #include <QObject>
 
 
+class QIODevice;
 class QUrl;
 
 namespace K3b {
@@ -73,6 +74,12 @@ namespace K3b {
         // used internal
         Doc* createEmptyProject( Doc::Type );
 
+        /**
+         * Create a project from the xml data read from @p dev.
+         * \return the new project or 0 if the data could not be loaded.
+         */
+        Doc* readProject( QIODevice* dev );
+
         class Private;
         Private* d;
     };
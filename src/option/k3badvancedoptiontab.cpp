@@ -56,13 +56,21 @@ void K3b::AdvancedOptionTab::setupGui()
     m_editWritingBufferSize->setRange( 1, 100 );
     m_editWritingBufferSize->setValue( 4 );
     m_editWritingBufferSize->setSuffix( ' ' + i18n("MB") );
+    QLabel* pipeBufferSizeLabel = new QLabel( i18n("&Pipe buffer size:"), groupWritingApp );
+    m_editPipeBufferSize = new QSpinBox( groupWritingApp );
+    m_editPipeBufferSize->setRange( 1, 256 );
+    m_editPipeBufferSize->setValue( 4 );
+    m_editPipeBufferSize->setSuffix( ' ' + i18n("MB") );
+    pipeBufferSizeLabel->setBuddy( m_editPipeBufferSize );
     m_checkShowForceGuiElements = new QCheckBox( i18n("Show &advanced GUI elements"), groupWritingApp );
     bufferLayout->addWidget( m_checkBurnfree, 0, 0, 1, 3 );
     bufferLayout->addWidget( m_checkOverburn, 1, 0, 1, 2 );
     bufferLayout->addWidget( m_checkForceUnsafeOperations, 2, 0, 1, 3 );
     bufferLayout->addWidget( m_checkManualWritingBufferSize, 3, 0 );
     bufferLayout->addWidget( m_editWritingBufferSize, 3, 1 );
-    bufferLayout->addWidget( m_checkShowForceGuiElements, 4, 0, 1, 3 );
+    bufferLayout->addWidget( pipeBufferSizeLabel, 4, 0 );
+    bufferLayout->addWidget( m_editPipeBufferSize, 4, 1 );
+    bufferLayout->addWidget( m_checkShowForceGuiElements, 5, 0, 1, 3 );
     bufferLayout->setColumnStretch( 2, 1 );
 
     QGroupBox* groupMisc = new QGroupBox( i18n("Miscellaneous"), this );
@@ -71,6 +79,16 @@ void K3b::AdvancedOptionTab::setupGui()
     groupMiscLayout->addWidget( m_checkEject );
     m_checkAutoErasingRewritable = new QCheckBox( i18n("Automatically erase CD-RWs and DVD-RWs"), groupMisc );
     groupMiscLayout->addWidget( m_checkAutoErasingRewritable );
+    m_checkAudioRipCache = new QCheckBox( i18n("&Cache audio tracks read from CDs") + ':', groupMisc );
+    m_editAudioRipCacheSize = new QSpinBox( groupMisc );
+    m_editAudioRipCacheSize->setRange( 1, 1000 );
+    m_editAudioRipCacheSize->setValue( 4 );
+    m_editAudioRipCacheSize->setSuffix( ' ' + i18n("GB") );
+    QHBoxLayout* audioRipCacheLayout = new QHBoxLayout();
+    audioRipCacheLayout->addWidget( m_checkAudioRipCache );
+    audioRipCacheLayout->addWidget( m_editAudioRipCacheSize );
+    audioRipCacheLayout->addStretch( 1 );
+    groupMiscLayout->addLayout( audioRipCacheLayout );
 
     groupAdvancedLayout->addWidget( groupWritingApp, 0, 0 );
     groupAdvancedLayout->addWidget( groupMisc, 1, 0 );
@@ -83,7 +101,12 @@ void K3b::AdvancedOptionTab::setupGui()
              this, SLOT(slotSetDefaultBufferSizes(bool)) );
 
 
+    connect( m_checkAudioRipCache, SIGNAL(toggled(bool)),
+             m_editAudioRipCacheSize, SLOT(setEnabled(bool)) );
+
+
     m_editWritingBufferSize->setDisabled( true );
+    m_editAudioRipCacheSize->setDisabled( true );
     // -----------------------------------------------------------------------
 
 
@@ -92,6 +115,8 @@ void K3b::AdvancedOptionTab::setupGui()
     m_checkAutoErasingRewritable->setToolTip( i18n("Automatically erase CD-RWs and DVD-RWs without asking") );
     m_checkEject->setToolTip( i18n("Do not eject the burn medium after a completed burn process") );
     m_checkForceUnsafeOperations->setToolTip( i18n("Force K3b to continue some operations otherwise deemed as unsafe") );
+    m_editPipeBufferSize->setToolTip( i18n("Size of the buffer used when K3b passes data to the burning application itself") );
+    m_checkAudioRipCache->setToolTip( i18n("Keep audio tracks read from CDs on disk to avoid reading them again") );
 
     m_checkShowForceGuiElements->setWhatsThis( i18n("<p>If this option is checked additional GUI "
                                                     "elements which allow one to influence the behavior of K3b are shown. "
@@ -122,6 +147,19 @@ void K3b::AdvancedOptionTab::setupGui()
                                                        "<p>If this option is checked the value specified will be used for both "
                                                        "CD and DVD burning.", 4, 32) );
 
+    m_editPipeBufferSize->setWhatsThis( i18n("<p>When writing on the fly K3b passes the data from the source, "
+                                             "for example mkisofs, to the burning application itself. Reading and "
+                                             "writing are decoupled by a buffer of this size, so a temporarily slow "
+                                             "source does not immediately starve the burning application.") );
+
+    m_checkAudioRipCache->setWhatsThis( i18n("<p>If this option is checked K3b keeps every audio track it reads "
+                                             "completely from a CD in a cache on the hard disk. Ripping the same CD "
+                                             "again, for example into another format, converting an audio project "
+                                             "using tracks of the CD or copying the CD then reads the data from the "
+                                             "cache instead of the slow drive."
+                                             "<p>The tracks used least recently are removed once the cache exceeds "
+                                             "the given size.") );
+
     m_checkEject->setWhatsThis( i18n("<p>If this option is checked K3b will not eject the medium once the burn process "
                                      "finishes. This can be helpful in case one leaves the computer after starting the "
                                      "burning and does not want the tray to be open all the time."
@@ -151,6 +189,9 @@ void K3b::AdvancedOptionTab::readSettings()
     m_checkManualWritingBufferSize->setChecked( k3bcore->globalSettings()->useManualBufferSize() );
     if( k3bcore->globalSettings()->useManualBufferSize() )
         m_editWritingBufferSize->setValue( k3bcore->globalSettings()->bufferSize() );
+    m_editPipeBufferSize->setValue( k3bcore->globalSettings()->pipeBufferSize() );
+    m_checkAudioRipCache->setChecked( k3bcore->globalSettings()->useAudioRipCache() );
+    m_editAudioRipCacheSize->setValue( k3bcore->globalSettings()->audioRipCacheSize() );
 }
 
 
@@ -166,7 +207,10 @@ void K3b::AdvancedOptionTab::saveSettings()
     k3bcore->globalSettings()->setBurnfree( m_checkBurnfree->isChecked() );
     k3bcore->globalSettings()->setUseManualBufferSize( m_checkManualWritingBufferSize->isChecked() );
     k3bcore->globalSettings()->setBufferSize( m_editWritingBufferSize->value() );
+    k3bcore->globalSettings()->setPipeBufferSize( m_editPipeBufferSize->value() );
     k3bcore->globalSettings()->setForce( m_checkForceUnsafeOperations->isChecked() );
+    k3bcore->globalSettings()->setUseAudioRipCache( m_checkAudioRipCache->isChecked() );
+    k3bcore->globalSettings()->setAudioRipCacheSize( m_editAudioRipCacheSize->value() );
 }
 
 
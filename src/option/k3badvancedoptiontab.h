@@ -38,8 +38,11 @@ namespace K3b {
         QCheckBox*    m_checkOverburn;
         QCheckBox*    m_checkManualWritingBufferSize;
         QSpinBox*     m_editWritingBufferSize;
+        QSpinBox*     m_editPipeBufferSize;
         QCheckBox*    m_checkShowForceGuiElements;
         QCheckBox*    m_checkForceUnsafeOperations;
+        QCheckBox*    m_checkAudioRipCache;
+        QSpinBox*     m_editAudioRipCacheSize;
     };
 }
 
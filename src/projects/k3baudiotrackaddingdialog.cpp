@@ -166,10 +166,19 @@ void K3b::AudioTrackAddingDialog::slotAddUrls()
         K3b::AudioDecoder* dec = m_doc->getDecoderForUrl( url, &reused );
         if( dec ) {
             m_analyserJob->setDecoder( dec );
-            if( reused )
+            if( reused ) {
                 slotAnalysingFinished( true );
-            else
+            }
+            else if( m_cueUrl.isValid() ) {
+                // importing the cue file requires the length of the image
                 m_analyserJob->start();
+            }
+            else {
+                // the doc analyses the file in the background and updates the source
+                m_doc->analyseDecoder( dec );
+                addFile( dec );
+                QMetaObject::invokeMethod( this, "slotAddUrls", Qt::QueuedConnection );
+            }
         }
         else {
             valid = false;
@@ -194,50 +203,51 @@ void K3b::AudioTrackAddingDialog::slotAnalysingFinished( bool /*success*/ )
         return;
     }
 
-    QUrl url = m_urls.first();
-    m_urls.erase( m_urls.begin() );
-
     if( m_cueUrl.isValid() ) {
         // import the cue file
+        m_urls.erase( m_urls.begin() );
         m_doc->importCueFile( m_cueUrl.toLocalFile(), m_trackAfter, m_analyserJob->decoder() );
         m_cueUrl = QUrl();
     }
     else {
-        // create the track and source items
-        K3b::AudioDecoder* dec = m_analyserJob->decoder();
-        K3b::AudioFile* file = new K3b::AudioFile( dec, m_doc );
-        if( m_parentTrack ) {
-            if( m_sourceAfter )
-                file->moveAfter( m_sourceAfter );
-            else
-                file->moveAhead( m_parentTrack->firstSource() );
-            m_sourceAfter = file;
-        }
-        else {
-            K3b::AudioTrack* track = new K3b::AudioTrack( m_doc );
-            track->setFirstSource( file );
-
-            track->setTitle( dec->metaInfo( K3b::AudioDecoder::META_TITLE ) );
-            track->setArtist( dec->metaInfo( K3b::AudioDecoder::META_ARTIST ) );
-            track->setSongwriter( dec->metaInfo( K3b::AudioDecoder::META_SONGWRITER ) );
-            track->setComposer( dec->metaInfo( K3b::AudioDecoder::META_COMPOSER ) );
-            track->setCdTextMessage( dec->metaInfo( K3b::AudioDecoder::META_COMMENT ) );
-
-            if( m_trackAfter )
-                track->moveAfter( m_trackAfter );
-            else if ( m_doc->lastTrack() )
-                track->moveAfter( m_doc->lastTrack() );
-            else
-                m_doc->addTrack( track, 0 );
-
-            m_trackAfter = track;
-        }
+        addFile( m_analyserJob->decoder() );
     }
 
     QMetaObject::invokeMethod( this, "slotAddUrls", Qt::QueuedConnection );
 }
 
 
+void K3b::AudioTrackAddingDialog::addFile( K3b::AudioDecoder* dec )
+{
+    m_urls.erase( m_urls.begin() );
+
+    // create the track and source items
+    K3b::AudioFile* file = new K3b::AudioFile( dec, m_doc );
+    if( m_parentTrack ) {
+        if( m_sourceAfter )
+            file->moveAfter( m_sourceAfter );
+        else
+            file->moveAhead( m_parentTrack->firstSource() );
+        m_sourceAfter = file;
+    }
+    else {
+        K3b::AudioTrack* track = new K3b::AudioTrack( m_doc );
+        track->setFirstSource( file );
+
+        if( m_trackAfter )
+            track->moveAfter( m_trackAfter );
+        else if ( m_doc->lastTrack() )
+            track->moveAfter( m_doc->lastTrack() );
+        else
+            m_doc->addTrack( track, 0 );
+
+        m_doc->setTrackMetaInfo( track );
+
+        m_trackAfter = track;
+    }
+}
+
+
 void K3b::AudioTrackAddingDialog::slotCancelClicked()
 {
     m_bCanceled = true;
@@ -19,6 +19,7 @@ namespace K3b {
     class AudioTrack;
     class AudioDataSource;
     class AudioDoc;
+    class AudioDecoder;
     class AudioFileAnalyzerJob;
 
     class AudioTrackAddingDialog : public QDialog, public JobHandler
@@ -51,6 +52,11 @@ namespace K3b {
         void slotCancelClicked();
 
     private:
+        /**
+         * Create the source and, if needed, the track for the first url.
+         */
+        void addFile( AudioDecoder* decoder );
+
         /**
          * @reimplemented from JobHandler
          */
@@ -96,6 +96,8 @@ void K3b::AudioView::addUrls( const QList<QUrl>& urls )
 
 K3b::ProjectBurnDialog* K3b::AudioView::newBurnDialog( QWidget* parent )
 {
+    // the dialog shows the length and the CD-Text of the project
+    m_audioViewImpl->waitForAnalysis();
     return new AudioBurnDialog( m_doc, parent );
 }
 
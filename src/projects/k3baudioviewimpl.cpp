@@ -39,6 +39,8 @@
 #include <KActionCollection>
 
 #include <QAction>
+#include <QApplication>
+#include <QCursor>
 #include <QDialog>
 #include <QDialogButtonBox>
 #include <QHeaderView>
@@ -145,6 +147,14 @@ void K3b::AudioViewImpl::addUrls( const QList<QUrl>& urls )
 }
 
 
+void K3b::AudioViewImpl::waitForAnalysis()
+{
+    QApplication::setOverrideCursor( QCursor(Qt::WaitCursor) );
+    m_doc->waitForAnalysis();
+    QApplication::restoreOverrideCursor();
+}
+
+
 void K3b::AudioViewImpl::slotRemove()
 {
     const QModelIndexList indexes = m_trackView->selectionModel()->selectedRows();
@@ -252,13 +262,7 @@ void K3b::AudioViewImpl::slotSplitSource()
 
         // let's see if it's a file because in that case we can reuse the metainfo :)
         // TODO: maybe add meta data to sources
-        if( AudioFile* file = dynamic_cast<AudioFile*>( track->firstSource() ) ) {
-            track->setArtist( file->decoder()->metaInfo( AudioDecoder::META_ARTIST ) );
-            track->setTitle( file->decoder()->metaInfo( AudioDecoder::META_TITLE ) );
-            track->setSongwriter( file->decoder()->metaInfo( AudioDecoder::META_SONGWRITER ) );
-            track->setComposer( file->decoder()->metaInfo( AudioDecoder::META_COMPOSER ) );
-            track->setCdTextMessage( file->decoder()->metaInfo( AudioDecoder::META_COMMENT ) );
-        }
+        m_doc->setTrackMetaInfo( track );
     }
 }
 
@@ -270,6 +274,7 @@ void K3b::AudioViewImpl::slotSplitTrack()
     tracksForIndexes( tracks, indexes );
 
     if( !tracks.isEmpty() ) {
+        waitForAnalysis();
         AudioTrackSplitDialog::splitTrack( tracks.first(), m_view );
     }
 }
@@ -290,6 +295,8 @@ void K3b::AudioViewImpl::slotEditSource()
         source = tracks.first()->firstSource();
 
     if( source ) {
+        waitForAnalysis();
+
         QDialog dlg( m_view );
         dlg.setWindowTitle( i18n("Edit Audio Track Source") );
 
@@ -320,6 +327,8 @@ void K3b::AudioViewImpl::slotTrackProperties()
     // TODO: add tracks from sources to tracks
 
     if( !tracks.isEmpty() ) {
+        // the dialog shows the meta data and sets index 0 from the length
+        waitForAnalysis();
         AudioTrackDialog d( tracks, m_view );
         d.exec();
     }
@@ -361,6 +370,7 @@ void K3b::AudioViewImpl::slotQueryMusicBrainz()
 //         m_player->stop();
 
     // now do the lookup on the files.
+    waitForAnalysis();
     AudioTrackTRMLookupDialog dlg( m_view );
     dlg.lookup( tracks );
 #endif
@@ -385,6 +395,7 @@ void K3b::AudioViewImpl::slotQueryMusicBrainzTrack()
 //         m_player->stop();
 
     // now do the lookup on the files.
+    waitForAnalysis();
     AudioTrackTRMLookupDialog dlg( m_view );
     dlg.lookup( tracks );
 #endif
@@ -435,6 +446,7 @@ void K3b::AudioViewImpl::slotSelectionChanged()
 void K3b::AudioViewImpl::slotAudioConversion()
 {
     if( m_doc->numOfTracks() > 0 ) {
+        waitForAnalysis();
         AudioProjectConvertingDialog dlg( m_doc, m_view );
         dlg.exec();
     }
@@ -39,6 +39,12 @@ namespace K3b {
 
         void addUrls( const QList<QUrl>& urls );
 
+        /**
+         * Wait for the files added to the project to be analysed. Call this
+         * before anything which needs the lengths or the meta data of the tracks.
+         */
+        void waitForAnalysis();
+
         AudioProjectModel* model() const { return m_model; }
         QTreeView* view() const { return m_trackView; }
 
@@ -216,6 +216,8 @@ void K3b::MixedView::slotSetCurrentRoot( const QModelIndex& index )
 
 K3b::ProjectBurnDialog* K3b::MixedView::newBurnDialog( QWidget* parent )
 {
+    // the dialog shows the length and the CD-Text of the project
+    m_audioViewImpl->waitForAnalysis();
     return new K3b::MixedBurnDialog( m_doc, parent );
 }
 
@@ -91,6 +91,9 @@ K3b::AudioProjectConvertingDialog::AudioProjectConvertingDialog( K3b::AudioDoc*
 {
     d = new Private();
 
+    // the file names are created from the meta data and the lengths
+    m_doc->waitForAnalysis();
+
     setupGui();
 
     setTitle( i18n("Audio Project Conversion"),
@@ -190,6 +193,9 @@ void K3b::AudioProjectConvertingDialog::slotStartClicked()
             return;
 
 
+    // nothing to wait for unless files have been added while the dialog was open
+    m_doc->waitForAnalysis();
+
     // just generate a fake m_tracks list for now so we can keep most of the methods
     // like they are in K3b::AudioRipJob. This way future combination is easier
     AudioProjectConvertingJob::Tracks tracksToRip;
@@ -7,7 +7,9 @@
 
 #include "k3bmassaudioencodingjob.h"
 #include "k3baudioencoder.h"
+#include "k3bcore.h"
 #include "k3bcuefilewriter.h"
+#include "k3bpluginmanager.h"
 #include "k3bwavefilewriter.h"
 
 #include <KLocalizedString>
@@ -17,7 +19,14 @@
 #include <QDir>
 #include <QFileInfo>
 #include <QIODevice>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QQueue>
+#include <QSet>
 #include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
 
 #include <vector>
 #include <algorithm>
@@ -26,6 +35,13 @@ namespace K3b {
 
 namespace
 {
+    // The source is read in chunks of whole CD frames since AudioCdReader
+    // always returns a complete frame.
+    const int s_chunkSize = 32*2352;
+
+    // The reader may be ahead of each encoder by roughly one CD track
+    // before it has to wait for the encoders to catch up.
+    const qint64 s_spoolSizePerEncoder = 64LL*1024LL*1024LL;
 
     struct SortByTrackNumber
     {
@@ -63,9 +79,56 @@ namespace
         MassAudioEncodingJob::Tracks::const_iterator track;
     };
 
+    struct SortByFirstTrack
+    {
+        SortByFirstTrack( QHash<QString,int> const& firstTracks ) : m_firstTracks( firstTracks ) {}
+
+        bool operator()( Task const& lhs, Task const& rhs )
+        {
+            return m_firstTracks.value( lhs.filename ) < m_firstTracks.value( rhs.filename );
+        }
+
+        QHash<QString,int> const& m_firstTracks;
+    };
+
 } // namespace
 
 
+/**
+ * One target file and the spooled PCM data of its tracks which
+ * has not been encoded yet.
+ */
+class MassAudioEncodingJob::OutputFile
+{
+public:
+    struct Chunk {
+        Chunk( int t, const QByteArray& d ) : trackIndex( t ), data( d ) {}
+
+        int trackIndex;
+
+        /**
+         * An empty chunk marks the end of the track
+         */
+        QByteArray data;
+    };
+
+    OutputFile( const QString& f, const QList<int>& t )
+        : filename( f ),
+          tracks( t ),
+          encoder( 0 ),
+          opened( false ),
+          success( false ) {
+    }
+
+    const QString filename;
+    const QList<int> tracks;
+    AudioEncoder* encoder;
+    QQueue<Chunk> chunks;
+    bool opened;
+    bool success;
+};
+
+
 class MassAudioEncodingJob::Private
 {
 public:
@@ -74,10 +137,16 @@ public:
         bigEndian( be ),
         overallBytesRead( 0 ),
         overallBytesToRead( 0 ),
+        overallBytesEncoded( 0 ),
         encoder( 0 ),
-        waveFileWriter( 0 ),
         relativePathInPlaylist( false ),
-        writeCueFile( false )
+        writeCueFile( false ),
+        spooledBytes( 0 ),
+        maxSpooledBytes( 0 ),
+        activeFiles( 0 ),
+        maxActiveFiles( 1 ),
+        failed( false ),
+        nextFinishedTask( 0 )
     {
     }
 
@@ -86,14 +155,37 @@ public:
     QHash<QString,Msf> lengths;
     qint64 overallBytesRead;
     qint64 overallBytesToRead;
+    qint64 overallBytesEncoded;
     AudioEncoder* encoder;
-    WaveFileWriter* waveFileWriter;
     QString fileType;
     KCDDB::CDInfo cddbEntry;
 
     QString playlistFilename;
     bool relativePathInPlaylist;
     bool writeCueFile;
+
+    // The job's thread reads the tracks and spools the data while
+    // the files are encoded in the thread pool. Everything below
+    // is protected by the mutex.
+    QMutex mutex;
+    QWaitCondition spoolChanged;
+    qint64 spooledBytes;
+    qint64 maxSpooledBytes;
+    int activeFiles;
+    int maxActiveFiles;
+    bool failed;
+
+    // encoders not used by any file right now and the additional
+    // encoder instances created for this run
+    QList<AudioEncoder*> idleEncoders;
+    QList<AudioEncoder*> encoderInstances;
+
+    // trackFinished() is called in the order the tracks are read
+    std::vector<Task> tasks;
+    size_t nextFinishedTask;
+    QSet<int> encodedTracks;
+
+    QThreadPool pool;
 };
 
 
@@ -210,44 +302,124 @@ bool MassAudioEncodingJob::run()
     if ( !init() )
         return false;
 
-    if( !d->encoder )
-        if( !d->waveFileWriter )
-            d->waveFileWriter = new K3b::WaveFileWriter();
-
     d->overallBytesRead = 0;
     d->overallBytesToRead = 0;
+    d->overallBytesEncoded = 0;
     d->lengths.clear();
 
     const QStringList tracksKeys = d->tracks.keys();
     const QSet<QString> fileNames = QSet<QString>(tracksKeys.begin(), tracksKeys.end());
+    QHash<QString,int> firstTracks;
     Q_FOREACH( const QString& filename, fileNames ) {
         d->lengths.insert( filename, 0 );
         Q_FOREACH( int trackNumber, d->tracks.values( filename ) ) {
             const Msf length = trackLength( trackNumber );
             d->lengths[ filename ] += length;
             d->overallBytesToRead += length.audioBytes();
+            if( !firstTracks.contains( filename ) || trackNumber < firstTracks[ filename ] )
+                firstTracks[ filename ] = trackNumber;
         }
     }
 
-    // rip tracks in *numerical* order
+    // rip tracks in *numerical* order while keeping the tracks
+    // of merged files together so only one file is read at a time
     std::vector<Task> tasks;
     tasks.reserve( d->tracks.size() );
     for( Tracks::const_iterator i = d->tracks.constBegin(); i != d->tracks.constEnd(); ++i )
         tasks.push_back( Task(i) );
     std::sort( tasks.begin(), tasks.end(), Task::sort_by_tracknumber );
+    std::stable_sort( tasks.begin(), tasks.end(), SortByFirstTrack( firstTracks ) );
+
+    // Encoding is CPU bound. Use one encoder instance per core so the
+    // reading of the source becomes the limiting factor. Wave files
+    // are only written by one thread next to the reader.
+    d->idleEncoders.clear();
+    if( d->encoder ) {
+        d->idleEncoders.append( d->encoder );
+        const int threads = qMax( 1, QThread::idealThreadCount() );
+        while( d->idleEncoders.count() < threads ) {
+            Plugin* plugin = k3bcore->pluginManager()->createInstance( d->encoder );
+            AudioEncoder* encoder = qobject_cast<AudioEncoder*>( plugin );
+            if( !encoder ) {
+                delete plugin;
+                break;
+            }
+            d->encoderInstances.append( encoder );
+            d->idleEncoders.append( encoder );
+        }
+        d->maxActiveFiles = d->idleEncoders.count();
+    }
+    else {
+        d->maxActiveFiles = 1;
+    }
+    qDebug() << "(K3b::MassAudioEncodingJob) encoding with" << d->maxActiveFiles << "threads";
+
+    d->pool.setMaxThreadCount( d->maxActiveFiles );
+    d->maxSpooledBytes = d->maxActiveFiles * s_spoolSizePerEncoder;
+    d->spooledBytes = 0;
+    d->activeFiles = 0;
+    d->failed = false;
+    d->tasks = tasks;
+    d->nextFinishedTask = 0;
+    d->encodedTracks.clear();
 
     bool success = true;
-    QString lastFilename;
-    std::vector<Task>::const_iterator currentTask;
-    for( currentTask = tasks.begin(); success && currentTask != tasks.end(); ++currentTask ) {
-        success = encodeTrack( currentTask->track.value(), currentTask->track.key(), lastFilename );
-        lastFilename = currentTask->track.key();
+    QList<OutputFile*> files;
+    for( size_t i = 0; success && !canceled() && i < tasks.size(); ) {
+        const QString filename = tasks[i].filename;
+        QList<int> fileTracks;
+        for( size_t j = i; j < tasks.size() && tasks[j].filename == filename; ++j )
+            fileTracks.append( tasks[j].tracknumber );
+        i += fileTracks.count();
+
+        QDir dir = QFileInfo( filename ).dir();
+        if( !QDir().mkpath( dir.path() ) ) {
+            emit infoMessage( i18n("Unable to create folder %1",dir.path()), K3b::Job::MessageError );
+            success = false;
+            break;
+        }
+
+        // wait for an encoder to become available
+        QMutexLocker locker( &d->mutex );
+        while( !d->failed && !canceled() && d->activeFiles >= d->maxActiveFiles )
+            d->spoolChanged.wait( &d->mutex, 100 );
+        if( d->failed || canceled() )
+            break;
+
+        OutputFile* file = new OutputFile( filename, fileTracks );
+        if( d->encoder )
+            file->encoder = d->idleEncoders.takeFirst();
+        ++d->activeFiles;
+        locker.unlock();
+
+        files.append( file );
+        d->pool.start( [this, file]() { encodeFile( file ); } );
+
+        Q_FOREACH( int trackIndex, fileTracks ) {
+            if( !readTrack( trackIndex, file ) ) {
+                success = false;
+                break;
+            }
+        }
     }
 
-    if( d->encoder )
-        d->encoder->closeFile();
-    if( d->waveFileWriter )
-        d->waveFileWriter->close();
+    {
+        QMutexLocker locker( &d->mutex );
+        if( !success )
+            d->failed = true;
+        d->spoolChanged.wakeAll();
+        if( d->activeFiles > 0 && !d->failed && !canceled() && d->encoder )
+            emit newSubTask( i18n("Waiting for the encoding to finish") );
+    }
+    d->pool.waitForDone();
+
+    Q_FOREACH( OutputFile* file, files ) {
+        success = success && file->success;
+    }
+
+    qDeleteAll( d->encoderInstances );
+    d->encoderInstances.clear();
+    d->idleEncoders.clear();
 
     if( !canceled() && success && !d->playlistFilename.isNull() ) {
         success = success && writePlaylist();
@@ -258,136 +430,209 @@ bool MassAudioEncodingJob::run()
     }
 
     if( canceled() ) {
-        if( currentTask != tasks.end() ) {
-            if( QFile::exists( currentTask->track.key() ) ) {
-                QFile::remove( currentTask->track.key() );
-                emit infoMessage( i18n("Removed partial file '%1'.", currentTask->track.key()), K3b::Job::MessageInfo );
+        Q_FOREACH( OutputFile* file, files ) {
+            if( file->opened && !file->success && QFile::exists( file->filename ) ) {
+                QFile::remove( file->filename );
+                emit infoMessage( i18n("Removed partial file '%1'.", file->filename), K3b::Job::MessageInfo );
             }
         }
 
         success = false;
     }
-    
+
+    qDeleteAll( files );
     cleanup();
     return success;
 }
 
 
-bool K3b::MassAudioEncodingJob::encodeTrack( int trackIndex, const QString& filename, const QString& prevFilename )
+bool MassAudioEncodingJob::readTrack( int trackIndex, OutputFile* file )
 {
     QScopedPointer<QIODevice> source( createReader( trackIndex ) );
     if( source.isNull() ) {
         return false;
     }
-    
-    QDir dir = QFileInfo( filename ).dir();
-    if( !QDir().mkpath( dir.path() ) ) {
-        emit infoMessage( i18n("Unable to create folder %1",dir.path()), K3b::Job::MessageError );
+
+    trackStarted( trackIndex );
+
+    if( !source->open( QIODevice::ReadOnly ) ) {
+        emit infoMessage( source->errorString(), Job::MessageError );
         return false;
     }
 
-    // Close the previous file if the new filename is different
-    if( prevFilename != filename ) {
-        if( d->encoder )
-            d->encoder->closeFile();
-        if( d->waveFileWriter )
-            d->waveFileWriter->close();
+    qint64 readFile = 0;
+    while( !canceled() && !source->atEnd() ) {
+        QByteArray chunk( s_chunkSize, Qt::Uninitialized );
+        qint64 readLength = 0;
+        while( readLength < s_chunkSize && !source->atEnd() ) {
+            const qint64 r = source->read( chunk.data() + readLength, s_chunkSize - readLength );
+            if( r <= 0 )
+                break;
+            readLength += r;
+        }
+        if( readLength <= 0 )
+            break;
+        chunk.resize( readLength );
+
+        QMutexLocker locker( &d->mutex );
+        // the spool is bounded, wait for the encoders to catch up
+        while( !d->failed && !canceled() &&
+               d->spooledBytes > 0 && d->spooledBytes + readLength > d->maxSpooledBytes )
+            d->spoolChanged.wait( &d->mutex, 100 );
+        if( d->failed || canceled() )
+            return false;
+        d->spooledBytes += readLength;
+        file->chunks.enqueue( OutputFile::Chunk( trackIndex, chunk ) );
+        d->spoolChanged.wakeAll();
+        locker.unlock();
+
+        d->overallBytesRead += readLength;
+        readFile += readLength;
+        emit subPercent( 100LL*readFile/source->size() );
     }
 
-    // Open the file to write if it is not already opened
-    if( (d->encoder && !d->encoder->isOpen()) ||
-        (d->waveFileWriter && !d->waveFileWriter->isOpen()) ) {
-        bool isOpen = true;
-        if( d->encoder ) {
-            AudioEncoder::MetaData metaData;
-            metaData.insert( AudioEncoder::META_ALBUM_ARTIST, d->cddbEntry.get( KCDDB::Artist ) );
-            metaData.insert( AudioEncoder::META_ALBUM_TITLE, d->cddbEntry.get( KCDDB::Title ) );
-            metaData.insert( AudioEncoder::META_ALBUM_COMMENT, d->cddbEntry.get( KCDDB::Comment ) );
-            metaData.insert( AudioEncoder::META_YEAR, d->cddbEntry.get( KCDDB::Year ) );
-            metaData.insert( AudioEncoder::META_GENRE, d->cddbEntry.get( KCDDB::Genre ) );
-            if( d->tracks.count( filename ) == 1 ) {
-                metaData.insert( AudioEncoder::META_TRACK_NUMBER, QString::number(trackIndex).rightJustified( 2, '0' ) );
-                metaData.insert( AudioEncoder::META_TRACK_ARTIST, d->cddbEntry.track( trackIndex-1 ).get( KCDDB::Artist ) );
-                metaData.insert( AudioEncoder::META_TRACK_TITLE, d->cddbEntry.track( trackIndex-1 ).get( KCDDB::Title ) );
-                metaData.insert( AudioEncoder::META_TRACK_COMMENT, d->cddbEntry.track( trackIndex-1 ).get( KCDDB::Comment ) );
-            }
-            else {
-                metaData.insert( AudioEncoder::META_TRACK_ARTIST, d->cddbEntry.get( KCDDB::Artist ) );
-                metaData.insert( AudioEncoder::META_TRACK_TITLE, d->cddbEntry.get( KCDDB::Title ) );
-                metaData.insert( AudioEncoder::META_TRACK_COMMENT, d->cddbEntry.get( KCDDB::Comment ) );
-            }
+    if( canceled() )
+        return false;
 
-            isOpen = d->encoder->openFile( d->fileType, filename, d->lengths[ filename ], metaData );
-            if( !isOpen )
-                emit infoMessage( d->encoder->lastErrorString(), K3b::Job::MessageError );
+    if( !source->atEnd() ) {
+        emit infoMessage( source->errorString(), Job::MessageError );
+        return false;
+    }
+
+    QMutexLocker locker( &d->mutex );
+    file->chunks.enqueue( OutputFile::Chunk( trackIndex, QByteArray() ) );
+    d->spoolChanged.wakeAll();
+    return true;
+}
+
+
+void MassAudioEncodingJob::encodeFile( OutputFile* file )
+{
+    QScopedPointer<WaveFileWriter> waveFileWriter;
+    bool success = true;
+
+    if( file->encoder ) {
+        // several files are opened in parallel, only use the const accessors
+        const KCDDB::CDInfo& cddbEntry = d->cddbEntry;
+        const int trackIndex = file->tracks.first();
+        AudioEncoder::MetaData metaData;
+        metaData.insert( AudioEncoder::META_ALBUM_ARTIST, cddbEntry.get( KCDDB::Artist ) );
+        metaData.insert( AudioEncoder::META_ALBUM_TITLE, cddbEntry.get( KCDDB::Title ) );
+        metaData.insert( AudioEncoder::META_ALBUM_COMMENT, cddbEntry.get( KCDDB::Comment ) );
+        metaData.insert( AudioEncoder::META_YEAR, cddbEntry.get( KCDDB::Year ) );
+        metaData.insert( AudioEncoder::META_GENRE, cddbEntry.get( KCDDB::Genre ) );
+        if( file->tracks.count() == 1 ) {
+            metaData.insert( AudioEncoder::META_TRACK_NUMBER, QString::number(trackIndex).rightJustified( 2, '0' ) );
+            metaData.insert( AudioEncoder::META_TRACK_ARTIST, cddbEntry.track( trackIndex-1 ).get( KCDDB::Artist ) );
+            metaData.insert( AudioEncoder::META_TRACK_TITLE, cddbEntry.track( trackIndex-1 ).get( KCDDB::Title ) );
+            metaData.insert( AudioEncoder::META_TRACK_COMMENT, cddbEntry.track( trackIndex-1 ).get( KCDDB::Comment ) );
         }
         else {
-            isOpen = d->waveFileWriter->open( filename );
+            metaData.insert( AudioEncoder::META_TRACK_ARTIST, cddbEntry.get( KCDDB::Artist ) );
+            metaData.insert( AudioEncoder::META_TRACK_TITLE, cddbEntry.get( KCDDB::Title ) );
+            metaData.insert( AudioEncoder::META_TRACK_COMMENT, cddbEntry.get( KCDDB::Comment ) );
         }
 
-        if( !isOpen ) {
-            emit infoMessage( i18n("Unable to open '%1' for writing.",filename), K3b::Job::MessageError );
-            return false;
-        }
+        file->opened = file->encoder->openFile( d->fileType, file->filename, d->lengths.value( file->filename ), metaData );
+        if( !file->opened )
+            emit infoMessage( file->encoder->lastErrorString(), K3b::Job::MessageError );
+    }
+    else {
+        waveFileWriter.reset( new WaveFileWriter() );
+        file->opened = waveFileWriter->open( file->filename );
     }
 
-    trackStarted( trackIndex );
-
-    // do the conversion
-    // ----------------------
-
-    char buffer[10*1024];
-    const qint64 bufferLength = 10LL*1024LL;
-    qint64 readLength = 0;
-    qint64 readFile = 0;
-
-    if( !source->open( QIODevice::ReadOnly ) ) {
-        emit infoMessage( source->errorString(), Job::MessageError );
-        return false;
+    if( !file->opened ) {
+        emit infoMessage( i18n("Unable to open '%1' for writing.",file->filename), K3b::Job::MessageError );
+        success = false;
     }
 
-    while( !canceled() && !source->atEnd() && ( readLength = source->read( buffer, bufferLength ) ) > 0 ) {
+    int tracksLeft = file->tracks.count();
+    while( success && tracksLeft > 0 ) {
+        QMutexLocker locker( &d->mutex );
+        while( !d->failed && !canceled() && file->chunks.isEmpty() )
+            d->spoolChanged.wait( &d->mutex, 100 );
+        if( d->failed || canceled() ) {
+            success = false;
+            break;
+        }
 
-        if( d->encoder ) {
+        OutputFile::Chunk chunk = file->chunks.dequeue();
+        if( chunk.data.isEmpty() ) {
+            reportFinishedTracks( chunk.trackIndex );
+            --tracksLeft;
+            continue;
+        }
+        locker.unlock();
 
+        if( file->encoder ) {
             if( d->bigEndian ) {
                 // the tracks produce big endian samples
                 // and encoder encoder consumes little endian
                 // so we need to swap the bytes here
+                char* buffer = chunk.data.data();
                 char b;
-                for( qint64 i = 0; i < bufferLength-1; i+=2 ) {
+                for( int i = 0; i < chunk.data.size()-1; i+=2 ) {
                     b = buffer[i];
                     buffer[i] = buffer[i+1];
                     buffer[i+1] = b;
                 }
             }
 
-            if( d->encoder->encode( buffer, readLength ) < 0 ) {
+            if( file->encoder->encode( chunk.data.constData(), chunk.data.size() ) < 0 ) {
                 qDebug() << "error while encoding.";
-                emit infoMessage( d->encoder->lastErrorString(), K3b::Job::MessageError );
-                emit infoMessage( i18n("Error while encoding track %1.",trackIndex), K3b::Job::MessageError );
-                return false;
+                emit infoMessage( file->encoder->lastErrorString(), K3b::Job::MessageError );
+                emit infoMessage( i18n("Error while encoding track %1.",chunk.trackIndex), K3b::Job::MessageError );
+                success = false;
             }
         }
         else {
-            d->waveFileWriter->write( buffer,
-                                      readLength,
-                                      d->bigEndian ? WaveFileWriter::BigEndian : WaveFileWriter::LittleEndian );
+            waveFileWriter->write( chunk.data.constData(),
+                                   chunk.data.size(),
+                                   d->bigEndian ? WaveFileWriter::BigEndian : WaveFileWriter::LittleEndian );
         }
 
-        d->overallBytesRead += readLength;
-        readFile += readLength;
-        emit subPercent( 100LL*readFile/source->size() );
-        emit percent( 100LL*d->overallBytesRead/d->overallBytesToRead );
+        locker.relock();
+        d->spooledBytes -= chunk.data.size();
+        d->overallBytesEncoded += chunk.data.size();
+        const int overallPercent = 100LL*d->overallBytesEncoded/d->overallBytesToRead;
+        d->spoolChanged.wakeAll();
+        locker.unlock();
+
+        emit percent( overallPercent );
     }
 
-    if( !canceled() && !source->atEnd() ) {
-        emit infoMessage( source->errorString(), Job::MessageError );
-        return false;
+    if( file->encoder )
+        file->encoder->closeFile();
+    if( waveFileWriter )
+        waveFileWriter->close();
+
+    QMutexLocker locker( &d->mutex );
+    // drop the data which will never be encoded
+    Q_FOREACH( const OutputFile::Chunk& chunk, file->chunks ) {
+        d->spooledBytes -= chunk.data.size();
     }
+    file->chunks.clear();
 
-    trackFinished( trackIndex, filename );
-    return source->atEnd();
+    if( !success )
+        d->failed = true;
+    file->success = success;
+
+    if( file->encoder )
+        d->idleEncoders.append( file->encoder );
+    --d->activeFiles;
+    d->spoolChanged.wakeAll();
+}
+
+
+void MassAudioEncodingJob::reportFinishedTracks( int trackIndex )
+{
+    d->encodedTracks.insert( trackIndex );
+    while( d->nextFinishedTask < d->tasks.size() &&
+           d->encodedTracks.contains( d->tasks[d->nextFinishedTask].tracknumber ) ) {
+        const Task& task = d->tasks[d->nextFinishedTask++];
+        trackFinished( task.tracknumber, task.filename );
+    }
 }
 
 
@@ -50,6 +50,10 @@ namespace K3b {
         /**
          * Sets audio encoder the tracks will be encoded with.
          * If encoder=0 (default) wave files are created
+         *
+         * Additional instances of the encoder are created through the
+         * plugin manager to encode several files in parallel while the
+         * source is read.
          */
         void setEncoder( AudioEncoder* encoder );
         AudioEncoder* encoder() const;
@@ -100,7 +104,8 @@ namespace K3b {
         virtual Msf trackLength( int trackIndex ) const = 0;
         
         /**
-         * Creates reader for a given track
+         * Creates reader for a given track. Readers are created and
+         * used one at a time from the job's thread.
          */
         virtual QIODevice* createReader( int trackIndex ) const = 0;
         
@@ -110,20 +115,34 @@ namespace K3b {
         virtual void trackStarted( int trackIndex ) = 0;
         
         /**
-         * Prints information about previously processed track
+         * Prints information about previously processed track.
+         * Called in the order the tracks are read once they are encoded, possibly
+         * from one of the encoding threads.
          */
         virtual void trackFinished( int trackIndex, const QString& filename ) = 0;
         
     private:
         bool run() override;
         
+        class OutputFile;
+
         /**
-         * Reads data from source and encode it to provided filename
+         * Reads data from source and spools it for the encoding of \p file
          * \param trackIndex 1-based track index
-         * \param filename path to the target file
-         * \param filename path to previously encoded file
          */
-        bool encodeTrack( int trackIndex, const QString& filename, const QString& prevFilename );
+        bool readTrack( int trackIndex, OutputFile* file );
+
+        /**
+         * Encodes the spooled tracks of \p file. Runs in the encoding thread pool.
+         */
+        void encodeFile( OutputFile* file );
+
+        /**
+         * Marks \p trackIndex as encoded and reports all tracks up to the
+         * first one which has not been encoded yet. Expects the pipeline
+         * mutex to be locked.
+         */
+        void reportFinishedTracks( int trackIndex );
 
         /**
          * Writes a playlist file for previously specified tracks
@@ -0,0 +1,130 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3baudioanalysiscachetest.h"
+#include "k3baudioanalysiscache.h"
+#include "k3baudiodecoder.h"
+
+#include <QFile>
+#include <QTest>
+
+QTEST_GUILESS_MAIN( AudioAnalysisCacheTest )
+
+namespace {
+
+    K3b::AudioAnalysisCache::Entry createEntry()
+    {
+        K3b::AudioAnalysisCache::Entry entry;
+        entry.length = K3b::Msf( 3, 20, 5 );
+        entry.samplerate = 48000;
+        entry.channels = 1;
+        entry.metaInfo.insert( K3b::AudioDecoder::META_TITLE, QLatin1String( "Title" ) );
+        entry.metaInfo.insert( K3b::AudioDecoder::META_ARTIST, QLatin1String( "Artist" ) );
+        entry.decoderData = QByteArray( "decoder specific data" );
+        return entry;
+    }
+
+    void compareEntries( const K3b::AudioAnalysisCache::Entry& a, const K3b::AudioAnalysisCache::Entry& b )
+    {
+        QCOMPARE( a.length, b.length );
+        QCOMPARE( a.samplerate, b.samplerate );
+        QCOMPARE( a.channels, b.channels );
+        QCOMPARE( a.metaInfo, b.metaInfo );
+        QCOMPARE( a.decoderData, b.decoderData );
+    }
+
+} // namespace
+
+
+void AudioAnalysisCacheTest::init()
+{
+    m_dir.reset( new QTemporaryDir() );
+    QVERIFY( m_dir->isValid() );
+}
+
+
+QString AudioAnalysisCacheTest::createFile( const QString& name, const QByteArray& data )
+{
+    QFile f( m_dir->filePath( name ) );
+    if( !f.open( QIODevice::WriteOnly ) )
+        return QString();
+    f.write( data );
+    return f.fileName();
+}
+
+
+void AudioAnalysisCacheTest::testInsertAndFind()
+{
+    K3b::AudioAnalysisCache cache( m_dir->filePath( "cache" ) );
+    const QString path = createFile( "a.mp3", QByteArray( 1000, 'a' ) );
+
+    K3b::AudioAnalysisCache::Entry entry;
+    QVERIFY( !cache.find( "Decoder", path, entry ) );
+
+    cache.insert( "Decoder", path, createEntry() );
+    QCOMPARE( cache.count(), 1 );
+    QVERIFY( cache.find( "Decoder", path, entry ) );
+    compareEntries( entry, createEntry() );
+}
+
+
+void AudioAnalysisCacheTest::testDecoderTypeMismatch()
+{
+    K3b::AudioAnalysisCache cache( m_dir->filePath( "cache" ) );
+    const QString path = createFile( "a.mp3", QByteArray( 1000, 'a' ) );
+
+    cache.insert( "Decoder", path, createEntry() );
+
+    K3b::AudioAnalysisCache::Entry entry;
+    QVERIFY( !cache.find( "OtherDecoder", path, entry ) );
+}
+
+
+void AudioAnalysisCacheTest::testChangedFile()
+{
+    K3b::AudioAnalysisCache cache( m_dir->filePath( "cache" ) );
+    const QString path = createFile( "a.mp3", QByteArray( 1000, 'a' ) );
+
+    cache.insert( "Decoder", path, createEntry() );
+
+    // a different size invalidates the entry
+    createFile( "a.mp3", QByteArray( 2000, 'a' ) );
+    K3b::AudioAnalysisCache::Entry entry;
+    QVERIFY( !cache.find( "Decoder", path, entry ) );
+
+    // as does a removed file
+    cache.insert( "Decoder", path, createEntry() );
+    QVERIFY( QFile::remove( path ) );
+    QVERIFY( !cache.find( "Decoder", path, entry ) );
+}
+
+
+void AudioAnalysisCacheTest::testSaveAndLoad()
+{
+    const QString cacheFile = m_dir->filePath( "sub/cache" );
+    const QString path = createFile( "a.mp3", QByteArray( 1000, 'a' ) );
+
+    {
+        K3b::AudioAnalysisCache cache( cacheFile );
+        cache.insert( "Decoder", path, createEntry() );
+        QVERIFY( cache.save() );
+    }
+
+    K3b::AudioAnalysisCache cache( cacheFile );
+    QCOMPARE( cache.count(), 1 );
+    K3b::AudioAnalysisCache::Entry entry;
+    QVERIFY( cache.find( "Decoder", path, entry ) );
+    compareEntries( entry, createEntry() );
+
+    // a broken cache file is ignored
+    QFile f( cacheFile );
+    QVERIFY( f.open( QIODevice::WriteOnly ) );
+    f.write( "garbage" );
+    f.close();
+
+    K3b::AudioAnalysisCache brokenCache( cacheFile );
+    QCOMPARE( brokenCache.count(), 0 );
+}
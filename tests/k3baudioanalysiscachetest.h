@@ -0,0 +1,31 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef K3B_AUDIO_ANALYSIS_CACHE_TEST_H
+#define K3B_AUDIO_ANALYSIS_CACHE_TEST_H
+
+#include <QObject>
+#include <QScopedPointer>
+#include <QTemporaryDir>
+
+class AudioAnalysisCacheTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void testInsertAndFind();
+    void testDecoderTypeMismatch();
+    void testChangedFile();
+    void testSaveAndLoad();
+
+private:
+    QString createFile( const QString& name, const QByteArray& data );
+
+    QScopedPointer<QTemporaryDir> m_dir;
+};
+
+#endif // K3B_AUDIO_ANALYSIS_CACHE_TEST_H
@@ -0,0 +1,168 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3baudiodecoderconversiontest.h"
+#include "k3baudiodecoder.h"
+
+#include <QRandomGenerator>
+#include <QTest>
+#include <QVector>
+
+#include <math.h>
+#include <string.h>
+#include <limits>
+
+QTEST_GUILESS_MAIN( AudioDecoderConversionTest )
+
+namespace {
+
+    // one minute of 44.1 kHz stereo audio
+    const int BENCHMARK_SAMPLES = 60*44100*2;
+
+    // an odd number to also cover the scalar tails of the vectorized code
+    const int TEST_SAMPLES = 100003;
+
+    //
+    // The plain implementations the conversions are checked against
+    //
+    void referenceFrom16bitBeSignedToFloat( const char* src, float* dest, int samples )
+    {
+        for( int i = 0; i < samples; ++i )
+            dest[i] = static_cast<float>( qint16(((src[2*i]<<8)&0xff00)|(src[2*i+1]&0x00ff)) / 32768.0 );
+    }
+
+    qint16 referenceClip( float scaled )
+    {
+        if( scaled >= ( 1.0 * 0x7FFF ) )
+            return 32767;
+        else if( scaled <= ( -8.0 * 0x1000 ) )
+            return -32768;
+        else
+            return lrintf( scaled );
+    }
+
+    void referenceFromFloatTo16BitBeSigned( const float* src, char* dest, int samples )
+    {
+        for( int i = 0; i < samples; ++i ) {
+            qint16 val = referenceClip( src[i] * 32768.0 );
+            dest[2*i]   = val>>8;
+            dest[2*i+1] = val;
+        }
+    }
+
+    void referenceFrom8BitTo16BitBeSigned( const char* src, char* dest, int samples )
+    {
+        for( int i = 0; i < samples; ++i ) {
+            qint16 val = referenceClip( static_cast<float>(quint8(src[i])-128) / 128.0 * 32768.0 );
+            dest[2*i]   = val>>8;
+            dest[2*i+1] = val;
+        }
+    }
+
+    QByteArray randomBytes( int size )
+    {
+        QByteArray data( size, Qt::Uninitialized );
+        QRandomGenerator generator( 42 );
+        for( int i = 0; i < size; ++i )
+            data[i] = char( generator.bounded( 256 ) );
+        return data;
+    }
+
+    QVector<float> randomFloats( int size )
+    {
+        QVector<float> data( size );
+        QRandomGenerator generator( 42 );
+        for( int i = 0; i < size; ++i )
+            data[i] = float( generator.bounded( 2.4 ) - 1.2 );
+        return data;
+    }
+
+} // namespace
+
+
+void AudioDecoderConversionTest::testFrom16bitBeSignedToFloat()
+{
+    QByteArray src = randomBytes( 2*TEST_SAMPLES );
+    QVector<float> expected( TEST_SAMPLES );
+    QVector<float> result( TEST_SAMPLES );
+
+    referenceFrom16bitBeSignedToFloat( src.constData(), expected.data(), TEST_SAMPLES );
+    K3b::AudioDecoder::from16bitBeSignedToFloat( src.data(), result.data(), TEST_SAMPLES );
+
+    QVERIFY( ::memcmp( expected.constData(), result.constData(), TEST_SAMPLES*sizeof(float) ) == 0 );
+}
+
+
+void AudioDecoderConversionTest::testFromFloatTo16BitBeSigned()
+{
+    QVector<float> src = randomFloats( TEST_SAMPLES );
+
+    // the corner cases of rounding and clipping
+    const float specials[] = {
+        32766.5f/32768.0f, 32767.0f/32768.0f, 32767.5f/32768.0f,
+        -32767.5f/32768.0f, -1.0f, -32768.5f/32768.0f,
+        0.5f/32768.0f, 1.5f/32768.0f, -0.5f/32768.0f, -1.5f/32768.0f,
+        std::numeric_limits<float>::denorm_min(),
+        std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+        std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()
+    };
+    for( size_t i = 0; i < sizeof(specials)/sizeof(float); ++i )
+        src[i] = specials[i];
+
+    QByteArray expected( 2*TEST_SAMPLES, Qt::Uninitialized );
+    QByteArray result( 2*TEST_SAMPLES, Qt::Uninitialized );
+
+    referenceFromFloatTo16BitBeSigned( src.constData(), expected.data(), TEST_SAMPLES );
+    K3b::AudioDecoder::fromFloatTo16BitBeSigned( src.data(), result.data(), TEST_SAMPLES );
+
+    QCOMPARE( result, expected );
+}
+
+
+void AudioDecoderConversionTest::testFrom8BitTo16BitBeSigned()
+{
+    QByteArray src = randomBytes( TEST_SAMPLES );
+    QByteArray expected( 2*TEST_SAMPLES, Qt::Uninitialized );
+    QByteArray result( 2*TEST_SAMPLES, Qt::Uninitialized );
+
+    referenceFrom8BitTo16BitBeSigned( src.constData(), expected.data(), TEST_SAMPLES );
+    K3b::AudioDecoder::from8BitTo16BitBeSigned( src.data(), result.data(), TEST_SAMPLES );
+
+    QCOMPARE( result, expected );
+}
+
+
+void AudioDecoderConversionTest::benchmarkFrom16bitBeSignedToFloat()
+{
+    QByteArray src = randomBytes( 2*BENCHMARK_SAMPLES );
+    QVector<float> dest( BENCHMARK_SAMPLES );
+
+    QBENCHMARK {
+        K3b::AudioDecoder::from16bitBeSignedToFloat( src.data(), dest.data(), BENCHMARK_SAMPLES );
+    }
+}
+
+
+void AudioDecoderConversionTest::benchmarkFromFloatTo16BitBeSigned()
+{
+    QVector<float> src = randomFloats( BENCHMARK_SAMPLES );
+    QByteArray dest( 2*BENCHMARK_SAMPLES, Qt::Uninitialized );
+
+    QBENCHMARK {
+        K3b::AudioDecoder::fromFloatTo16BitBeSigned( src.data(), dest.data(), BENCHMARK_SAMPLES );
+    }
+}
+
+
+void AudioDecoderConversionTest::benchmarkFrom8BitTo16BitBeSigned()
+{
+    QByteArray src = randomBytes( BENCHMARK_SAMPLES );
+    QByteArray dest( 2*BENCHMARK_SAMPLES, Qt::Uninitialized );
+
+    QBENCHMARK {
+        K3b::AudioDecoder::from8BitTo16BitBeSigned( src.data(), dest.data(), BENCHMARK_SAMPLES );
+    }
+}
@@ -0,0 +1,25 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef K3B_AUDIO_DECODER_CONVERSION_TEST_H
+#define K3B_AUDIO_DECODER_CONVERSION_TEST_H
+
+#include <QObject>
+
+class AudioDecoderConversionTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testFrom16bitBeSignedToFloat();
+    void testFromFloatTo16BitBeSigned();
+    void testFrom8BitTo16BitBeSigned();
+    void benchmarkFrom16bitBeSignedToFloat();
+    void benchmarkFromFloatTo16BitBeSigned();
+    void benchmarkFrom8BitTo16BitBeSigned();
+};
+
+#endif // K3B_AUDIO_DECODER_CONVERSION_TEST_H
@@ -0,0 +1,219 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3baudioripcachetest.h"
+#include "k3baudioripcache.h"
+#include "k3bcdparanoialib.h"
+#include "k3btrack.h"
+
+#include <QDirIterator>
+#include <QFile>
+#include <QScopedPointer>
+#include <QTemporaryDir>
+#include <QTest>
+
+QTEST_GUILESS_MAIN( AudioRipCacheTest )
+
+namespace {
+
+    // the audio data "ripped" for a frame, different for every frame
+    QByteArray frameData( int frame )
+    {
+        QByteArray data( CD_FRAMESIZE_RAW, 0 );
+        for( int i = 0; i < CD_FRAMESIZE_RAW; ++i )
+            data[i] = char( frame + i );
+        return data;
+    }
+
+} // namespace
+
+
+AudioRipCacheTest::AudioRipCacheTest()
+{
+    m_toc.append( K3b::Device::Track( 0, 99, K3b::Device::Track::TYPE_AUDIO ) );
+    m_toc.append( K3b::Device::Track( 100, 279, K3b::Device::Track::TYPE_AUDIO ) );
+    m_toc.append( K3b::Device::Track( 280, 999, K3b::Device::Track::TYPE_DATA ) );
+}
+
+
+bool AudioRipCacheTest::ripTrack( K3b::AudioRipCache& cache, int track, int paranoiaMode )
+{
+    QScopedPointer<K3b::AudioRipCache::Writer> writer( cache.createWriter( m_toc, track, paranoiaMode ) );
+    if( !writer )
+        return false;
+    const int frames = m_toc[track-1].length().lba();
+    for( int i = 0; i < frames; ++i ) {
+        if( !writer->writeFrame( frameData( i ).constData() ) )
+            return false;
+    }
+    return writer->commit();
+}
+
+
+void AudioRipCacheTest::testReadBackRippedTrack()
+{
+    QTemporaryDir dir;
+    K3b::AudioRipCache cache( dir.path() );
+
+    QVERIFY( !cache.contains( m_toc, 2, 1 ) );
+    QVERIFY( !cache.createReader( m_toc, 2, 1 ) );
+
+    QVERIFY( ripTrack( cache, 2, 1 ) );
+    QVERIFY( cache.contains( m_toc, 2, 1 ) );
+    QVERIFY( !cache.contains( m_toc, 1, 1 ) );
+
+    QScopedPointer<K3b::AudioRipCache::Reader> reader( cache.createReader( m_toc, 2, 1 ) );
+    QVERIFY( reader );
+    QCOMPARE( reader->frames(), qint64( 180 ) );
+
+    char frame[CD_FRAMESIZE_RAW];
+    for( int i = 0; i < 180; ++i ) {
+        QVERIFY( reader->readFrame( frame ) );
+        QCOMPARE( QByteArray( frame, CD_FRAMESIZE_RAW ), frameData( i ) );
+    }
+    QVERIFY( !reader->readFrame( frame ) );
+
+    cache.clear();
+    QVERIFY( !cache.contains( m_toc, 2, 1 ) );
+}
+
+
+void AudioRipCacheTest::testSeekAndByteOrder()
+{
+    QTemporaryDir dir;
+    K3b::AudioRipCache cache( dir.path() );
+    QVERIFY( ripTrack( cache, 2, 1 ) );
+
+    QScopedPointer<K3b::AudioRipCache::Reader> reader( cache.createReader( m_toc, 2, 1 ) );
+    QVERIFY( reader );
+
+    // the last frame of the first block, read big endian
+    char frame[CD_FRAMESIZE_RAW];
+    QVERIFY( reader->seek( 74 ) );
+    QVERIFY( reader->readFrame( frame, false ) );
+    QCOMPARE( frame[0], frameData( 74 )[1] );
+    QCOMPARE( frame[1], frameData( 74 )[0] );
+
+    // continues with the second block
+    QVERIFY( reader->readFrame( frame ) );
+    QCOMPARE( QByteArray( frame, CD_FRAMESIZE_RAW ), frameData( 75 ) );
+}
+
+
+void AudioRipCacheTest::testOnlyAudioTracksAreCached()
+{
+    QTemporaryDir dir;
+    K3b::AudioRipCache cache( dir.path() );
+    QVERIFY( !cache.createWriter( m_toc, 3, 1 ) );
+}
+
+
+void AudioRipCacheTest::testOtherDiscDoesNotMatch()
+{
+    QTemporaryDir dir;
+    K3b::AudioRipCache cache( dir.path() );
+    QVERIFY( ripTrack( cache, 2, 1 ) );
+
+    // same audio track on a disc with another layout
+    K3b::Device::Toc otherToc = m_toc;
+    otherToc[2] = K3b::Device::Track( 280, 1000, K3b::Device::Track::TYPE_DATA );
+    QVERIFY( !cache.contains( otherToc, 2, 1 ) );
+}
+
+
+void AudioRipCacheTest::testParanoiaMode_data()
+{
+    QTest::addColumn<int>( "requestedMode" );
+    QTest::addColumn<bool>( "cached" );
+
+    // the track has been ripped with mode 2
+    QTest::newRow( "lower mode" ) << 0 << true;
+    QTest::newRow( "same mode" ) << 2 << true;
+    QTest::newRow( "higher mode" ) << 3 << false;
+}
+
+
+void AudioRipCacheTest::testParanoiaMode()
+{
+    QFETCH( int, requestedMode );
+    QFETCH( bool, cached );
+
+    QTemporaryDir dir;
+    K3b::AudioRipCache cache( dir.path() );
+    QVERIFY( ripTrack( cache, 1, 2 ) );
+
+    QCOMPARE( cache.contains( m_toc, 1, requestedMode ), cached );
+}
+
+
+void AudioRipCacheTest::testIncompleteTrackIsDiscarded()
+{
+    QTemporaryDir dir;
+    K3b::AudioRipCache cache( dir.path() );
+
+    {
+        QScopedPointer<K3b::AudioRipCache::Writer> writer( cache.createWriter( m_toc, 1, 1 ) );
+        QVERIFY( writer );
+        QVERIFY( writer->writeFrame( frameData( 0 ).constData() ) );
+        QVERIFY( !writer->commit() );
+    }
+    QVERIFY( !cache.contains( m_toc, 1, 1 ) );
+
+    {
+        // a complete track which is never committed
+        QScopedPointer<K3b::AudioRipCache::Writer> writer( cache.createWriter( m_toc, 1, 1 ) );
+        QVERIFY( writer );
+        for( int i = 0; i < 100; ++i )
+            QVERIFY( writer->writeFrame( frameData( i ).constData() ) );
+        QVERIFY( !writer->writeFrame( frameData( 100 ).constData() ) );
+    }
+    QVERIFY( !cache.contains( m_toc, 1, 1 ) );
+    QCOMPARE( cache.size(), qint64( 0 ) );
+}
+
+
+void AudioRipCacheTest::testDamagedEntryIsDropped()
+{
+    QTemporaryDir dir;
+    K3b::AudioRipCache cache( dir.path() );
+    QVERIFY( ripTrack( cache, 1, 1 ) );
+
+    // damage one sample in the second block
+    QDirIterator it( dir.path(), QStringList() << QLatin1String( "*.pcm" ), QDir::Files, QDirIterator::Subdirectories );
+    QVERIFY( it.hasNext() );
+    QFile f( it.next() );
+    QVERIFY( f.open( QIODevice::ReadWrite ) );
+    QVERIFY( f.seek( f.size() - 100 ) );
+    QVERIFY( f.putChar( 'x' ) );
+    f.close();
+
+    QScopedPointer<K3b::AudioRipCache::Reader> reader( cache.createReader( m_toc, 1, 1 ) );
+    QVERIFY( reader );
+
+    // the first block is still fine
+    char frame[CD_FRAMESIZE_RAW];
+    QVERIFY( reader->readFrame( frame ) );
+
+    QVERIFY( reader->seek( 80 ) );
+    QVERIFY( !reader->readFrame( frame ) );
+    QVERIFY( !cache.contains( m_toc, 1, 1 ) );
+}
+
+
+void AudioRipCacheTest::testLeastRecentlyUsedEntriesAreRemoved()
+{
+    QTemporaryDir dir;
+    K3b::AudioRipCache cache( dir.path() );
+    QVERIFY( ripTrack( cache, 1, 1 ) );
+
+    // the second track does not fit in addition to the first one
+    cache.setMaxSize( cache.size() + 100 );
+    QVERIFY( ripTrack( cache, 2, 1 ) );
+    QVERIFY( !cache.contains( m_toc, 1, 1 ) );
+    QVERIFY( cache.contains( m_toc, 2, 1 ) );
+}
+
+#include "moc_k3baudioripcachetest.cpp"
@@ -0,0 +1,43 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef K3B_AUDIO_RIP_CACHE_TEST_H
+#define K3B_AUDIO_RIP_CACHE_TEST_H
+
+#include "k3btoc.h"
+
+#include <QObject>
+
+namespace K3b {
+    class AudioRipCache;
+}
+
+class AudioRipCacheTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    AudioRipCacheTest();
+
+private slots:
+    void testReadBackRippedTrack();
+    void testSeekAndByteOrder();
+    void testOnlyAudioTracksAreCached();
+    void testOtherDiscDoesNotMatch();
+    void testParanoiaMode_data();
+    void testParanoiaMode();
+    void testIncompleteTrackIsDiscarded();
+    void testDamagedEntryIsDropped();
+    void testLeastRecentlyUsedEntriesAreRemoved();
+
+private:
+    bool ripTrack( K3b::AudioRipCache& cache, int track, int paranoiaMode );
+
+    // two audio tracks of 100 and 180 frames, followed by a data track
+    K3b::Device::Toc m_toc;
+};
+
+#endif // K3B_AUDIO_RIP_CACHE_TEST_H
@@ -0,0 +1,151 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bchecksumenginetest.h"
+#include "k3bchecksumengine.h"
+#include "k3bmd5job.h"
+
+#include <QCryptographicHash>
+#include <QSignalSpy>
+#include <QTest>
+
+QTEST_GUILESS_MAIN( ChecksumEngineTest )
+
+Q_DECLARE_METATYPE( K3b::ChecksumEngine::Algorithm )
+
+ChecksumEngineTest::ChecksumEngineTest()
+{
+}
+
+void ChecksumEngineTest::testKnownVectors_data()
+{
+    QTest::addColumn<K3b::ChecksumEngine::Algorithm>( "algorithm" );
+    QTest::addColumn<QByteArray>( "data" );
+    QTest::addColumn<QByteArray>( "checksum" );
+
+    QTest::newRow( "crc32" ) << K3b::ChecksumEngine::Crc32 << QByteArray( "123456789" )
+                             << QByteArray( "cbf43926" );
+    QTest::newRow( "crc32 empty" ) << K3b::ChecksumEngine::Crc32 << QByteArray()
+                                   << QByteArray( "00000000" );
+    QTest::newRow( "md5" ) << K3b::ChecksumEngine::Md5 << QByteArray( "abc" )
+                           << QByteArray( "900150983cd24fb0d6963f7d28e17f72" );
+    QTest::newRow( "md5 empty" ) << K3b::ChecksumEngine::Md5 << QByteArray()
+                                 << QByteArray( "d41d8cd98f00b204e9800998ecf8427e" );
+    QTest::newRow( "sha1" ) << K3b::ChecksumEngine::Sha1 << QByteArray( "abc" )
+                            << QByteArray( "a9993e364706816aba3e25717850c26c9cd0d89d" );
+    QTest::newRow( "sha256" ) << K3b::ChecksumEngine::Sha256 << QByteArray( "abc" )
+                              << QByteArray( "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" );
+    QTest::newRow( "sha512" ) << K3b::ChecksumEngine::Sha512 << QByteArray( "abc" )
+                              << QByteArray( "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+                                             "2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f" );
+}
+
+void ChecksumEngineTest::testKnownVectors()
+{
+    QFETCH( K3b::ChecksumEngine::Algorithm, algorithm );
+    QFETCH( QByteArray, data );
+    QFETCH( QByteArray, checksum );
+
+    K3b::ChecksumEngine engine( algorithm );
+    QCOMPARE( engine.algorithms(), K3b::ChecksumEngine::Algorithms( algorithm ) );
+
+    // feed the data byte by byte to cross buffer boundaries in the CRC slicing
+    for( int i = 0; i < data.size(); ++i )
+        engine.addData( data.constData() + i, 1 );
+
+    QCOMPARE( engine.result( algorithm ).toHex(), checksum );
+    QCOMPARE( engine.bytesProcessed(), quint64( data.size() ) );
+}
+
+void ChecksumEngineTest::testStaticCrc32()
+{
+    QCOMPARE( K3b::ChecksumEngine::crc32( "123456789", 9 ), quint32( 0xcbf43926 ) );
+    QCOMPARE( K3b::ChecksumEngine::crc32( "", 0 ), quint32( 0 ) );
+
+    QByteArray data( 100000, Qt::Uninitialized );
+    for( int i = 0; i < data.size(); ++i )
+        data[i] = char( i * 7 + ( i >> 8 ) );
+
+    K3b::ChecksumEngine engine( K3b::ChecksumEngine::Crc32 );
+    engine.addData( data.constData(), data.size() );
+    QCOMPARE( engine.result( K3b::ChecksumEngine::Crc32 ).toHex(),
+              QByteArray::number( K3b::ChecksumEngine::crc32( data.constData(), data.size() ), 16 ).rightJustified( 8, '0' ) );
+}
+
+void ChecksumEngineTest::testAllAlgorithmsInOnePass()
+{
+    // several engine buffers of 1 MiB, fed in odd chunk sizes
+    QByteArray data( 3*1024*1024 + 12345, Qt::Uninitialized );
+    for( int i = 0; i < data.size(); ++i )
+        data[i] = char( i ^ ( i >> 11 ) );
+
+    const K3b::ChecksumEngine::Algorithms algorithms = K3b::ChecksumEngine::Md5
+                                                       | K3b::ChecksumEngine::Sha1
+                                                       | K3b::ChecksumEngine::Sha256
+                                                       | K3b::ChecksumEngine::Sha512
+                                                       | K3b::ChecksumEngine::Crc32;
+    K3b::ChecksumEngine engine( algorithms );
+    QCOMPARE( engine.algorithms(), algorithms );
+
+    for( int pos = 0; pos < data.size(); pos += 65521 )
+        engine.addData( data.constData() + pos, qMin( 65521, data.size() - pos ) );
+
+    QCOMPARE( engine.bytesProcessed(), quint64( data.size() ) );
+    QCOMPARE( engine.result( K3b::ChecksumEngine::Md5 ), QCryptographicHash::hash( data, QCryptographicHash::Md5 ) );
+    QCOMPARE( engine.result( K3b::ChecksumEngine::Sha1 ), QCryptographicHash::hash( data, QCryptographicHash::Sha1 ) );
+    QCOMPARE( engine.result( K3b::ChecksumEngine::Sha256 ), QCryptographicHash::hash( data, QCryptographicHash::Sha256 ) );
+    QCOMPARE( engine.result( K3b::ChecksumEngine::Sha512 ), QCryptographicHash::hash( data, QCryptographicHash::Sha512 ) );
+
+    const quint32 crc = K3b::ChecksumEngine::crc32( data.constData(), data.size() );
+    const QByteArray crcResult = engine.result( K3b::ChecksumEngine::Crc32 );
+    QCOMPARE( crcResult.size(), 4 );
+    QCOMPARE( quint32( uchar( crcResult[0] ) ) << 24 | quint32( uchar( crcResult[1] ) ) << 16
+              | quint32( uchar( crcResult[2] ) ) << 8 | quint32( uchar( crcResult[3] ) ), crc );
+
+    // not requested
+    QVERIFY( engine.result( K3b::ChecksumEngine::Blake2b ).isEmpty() );
+}
+
+void ChecksumEngineTest::testReset()
+{
+    K3b::ChecksumEngine engine( K3b::ChecksumEngine::Md5 | K3b::ChecksumEngine::Crc32 );
+    engine.addData( "garbage", 7 );
+    engine.reset();
+    QCOMPARE( engine.bytesProcessed(), quint64( 0 ) );
+
+    engine.addData( "123456789", 9 );
+    QCOMPARE( engine.result( K3b::ChecksumEngine::Crc32 ).toHex(), QByteArray( "cbf43926" ) );
+
+    // results may be queried and more data added afterwards
+    engine.reset();
+    engine.addData( "ab", 2 );
+    QVERIFY( !engine.result( K3b::ChecksumEngine::Md5 ).isEmpty() );
+    engine.addData( "c", 1 );
+    QCOMPARE( engine.result( K3b::ChecksumEngine::Md5 ).toHex(), QByteArray( "900150983cd24fb0d6963f7d28e17f72" ) );
+}
+
+void ChecksumEngineTest::testUnsupportedAlgorithm()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    QSKIP( "BLAKE2b is supported with Qt 6" );
+#else
+    QVERIFY( !( K3b::ChecksumEngine::supportedAlgorithms() & K3b::ChecksumEngine::Blake2b ) );
+
+    K3b::ChecksumEngine engine( K3b::ChecksumEngine::Md5 | K3b::ChecksumEngine::Blake2b );
+    QCOMPARE( engine.algorithms(), K3b::ChecksumEngine::Algorithms( K3b::ChecksumEngine::Md5 ) );
+
+    // the job has to report the unsupported algorithm instead of an empty checksum
+    K3b::Md5Job job( 0 );
+    job.setAlgorithms( K3b::ChecksumEngine::Blake2b );
+    job.setFile( QStringLiteral( "does-not-matter" ) );
+    QSignalSpy finished( &job, SIGNAL(finished(bool)) );
+    job.start();
+    QCOMPARE( finished.count(), 1 );
+    QCOMPARE( finished.first().first().toBool(), false );
+    QVERIFY( job.hexDigest().isEmpty() );
+#endif
+}
+
+#include "moc_k3bchecksumenginetest.cpp"
@@ -0,0 +1,25 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef K3B_CHECKSUM_ENGINE_TEST_H
+#define K3B_CHECKSUM_ENGINE_TEST_H
+
+#include <QObject>
+
+class ChecksumEngineTest : public QObject
+{
+    Q_OBJECT
+public:
+    ChecksumEngineTest();
+private slots:
+    void testKnownVectors_data();
+    void testKnownVectors();
+    void testStaticCrc32();
+    void testAllAlgorithmsInOnePass();
+    void testReset();
+    void testUnsupportedAlgorithm();
+};
+
+#endif // K3B_CHECKSUM_ENGINE_TEST_H
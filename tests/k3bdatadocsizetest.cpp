@@ -0,0 +1,132 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bdatadocsizetest.h"
+#include "k3bdatadoc.h"
+#include "k3bdiritem.h"
+#include "k3bfileitem.h"
+
+#include <QFile>
+#include <QTest>
+
+#include <unistd.h>
+
+QTEST_GUILESS_MAIN( DataDocSizeTest )
+
+namespace {
+    // the project size counts complete blocks of 2048 bytes per file
+    KIO::filesize_t blockBytes( int blocks )
+    {
+        return KIO::filesize_t( blocks ) * 2048;
+    }
+}
+
+DataDocSizeTest::DataDocSizeTest()
+{
+}
+
+void DataDocSizeTest::initTestCase()
+{
+    QVERIFY( m_dir.isValid() );
+}
+
+QString DataDocSizeTest::writeFile( const QString& name, int size )
+{
+    const QString path = m_dir.filePath( name );
+    QFile f( path );
+    if( f.open( QIODevice::WriteOnly ) )
+        f.write( QByteArray( size, 'x' ) );
+    return path;
+}
+
+void DataDocSizeTest::testAddAndRemovePopulatedFolder()
+{
+    K3b::DataDoc doc;
+    doc.newDocument();
+    QCOMPARE( doc.size(), KIO::filesize_t( 0 ) );
+
+    // the folder is populated before it is added to the project
+    K3b::DirItem* dir = new K3b::DirItem( "folder" );
+    dir->addDataItem( new K3b::FileItem( writeFile( "add-a", 3000 ), doc ) ); // 2 blocks
+    K3b::DirItem* subDir = new K3b::DirItem( "sub folder" );
+    dir->addDataItem( subDir );
+    subDir->addDataItem( new K3b::FileItem( writeFile( "add-b", 5000 ), doc ) ); // 3 blocks
+    subDir->addDataItem( new K3b::FileItem( writeFile( "add-c", 100 ), doc ) ); // 1 block
+
+    doc.root()->addDataItem( dir );
+    QCOMPARE( doc.size(), blockBytes( 6 ) );
+    QCOMPARE( doc.length(), K3b::Msf( 6 ) );
+
+    // files added to the folder afterwards count as well
+    subDir->addDataItem( new K3b::FileItem( writeFile( "add-d", 2048 ), doc ) ); // 1 block
+    QCOMPARE( doc.size(), blockBytes( 7 ) );
+
+    doc.removeItem( subDir );
+    QCOMPARE( doc.size(), blockBytes( 2 ) );
+
+    doc.removeItem( dir );
+    QCOMPARE( doc.size(), KIO::filesize_t( 0 ) );
+    QCOMPARE( doc.length(), K3b::Msf( 0 ) );
+}
+
+void DataDocSizeTest::testMoveFolder()
+{
+    K3b::DataDoc doc;
+    doc.newDocument();
+
+    K3b::DirItem* target = doc.addEmptyDir( "target", doc.root() );
+    K3b::DirItem* dir = doc.addEmptyDir( "folder", doc.root() );
+    dir->addDataItem( new K3b::FileItem( writeFile( "move-a", 3000 ), doc ) ); // 2 blocks
+    K3b::DirItem* subDir = new K3b::DirItem( "sub folder" );
+    subDir->addDataItem( new K3b::FileItem( writeFile( "move-b", 5000 ), doc ) ); // 3 blocks
+    dir->addDataItem( subDir );
+    QCOMPARE( doc.size(), blockBytes( 5 ) );
+
+    doc.moveItem( dir, target );
+    QCOMPARE( dir->parent(), target );
+    QCOMPARE( doc.size(), blockBytes( 5 ) );
+
+    doc.moveItem( subDir, doc.root() );
+    QCOMPARE( doc.size(), blockBytes( 5 ) );
+
+    // only the moved files are gone with the folder
+    doc.removeItem( target );
+    QCOMPARE( doc.size(), blockBytes( 3 ) );
+
+    doc.removeItem( subDir );
+    QCOMPARE( doc.size(), KIO::filesize_t( 0 ) );
+}
+
+void DataDocSizeTest::testHardlinksCountedOnce()
+{
+    const QString path = writeFile( "link-a", 5000 ); // 3 blocks
+    const QString link1 = m_dir.filePath( "link-b" );
+    const QString link2 = m_dir.filePath( "link-c" );
+    QCOMPARE( ::link( QFile::encodeName( path ).constData(), QFile::encodeName( link1 ).constData() ), 0 );
+    QCOMPARE( ::link( QFile::encodeName( path ).constData(), QFile::encodeName( link2 ).constData() ), 0 );
+
+    K3b::DataDoc doc;
+    doc.newDocument();
+
+    K3b::FileItem* item = new K3b::FileItem( path, doc );
+    doc.root()->addDataItem( item );
+    QCOMPARE( doc.size(), blockBytes( 3 ) );
+
+    // two more links to the same file, in a folder added at once
+    K3b::DirItem* dir = new K3b::DirItem( "folder" );
+    dir->addDataItem( new K3b::FileItem( link1, doc ) );
+    dir->addDataItem( new K3b::FileItem( link2, doc ) );
+    doc.root()->addDataItem( dir );
+    QCOMPARE( doc.size(), blockBytes( 3 ) );
+
+    // the file is still there as long as one link is left
+    doc.removeItem( item );
+    QCOMPARE( doc.size(), blockBytes( 3 ) );
+
+    doc.removeItem( dir );
+    QCOMPARE( doc.size(), KIO::filesize_t( 0 ) );
+}
+
+#include "moc_k3bdatadocsizetest.cpp"
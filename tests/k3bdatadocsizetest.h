@@ -0,0 +1,34 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef K3B_DATA_DOC_SIZE_TEST_H
+#define K3B_DATA_DOC_SIZE_TEST_H
+
+#include <QObject>
+#include <QTemporaryDir>
+
+class DataDocSizeTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    DataDocSizeTest();
+
+private slots:
+    void initTestCase();
+    void testAddAndRemovePopulatedFolder();
+    void testMoveFolder();
+    void testHardlinksCountedOnce();
+
+private:
+    /**
+     * Write a file of @p size bytes to the temporary folder.
+     */
+    QString writeFile( const QString& name, int size );
+
+    QTemporaryDir m_dir;
+};
+
+#endif // K3B_DATA_DOC_SIZE_TEST_H
@@ -0,0 +1,240 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bdataitemmemorybenchmark.h"
+#include "k3bdatadoc.h"
+#include "k3bdiritem.h"
+#include "k3bfileitem.h"
+#include "k3bglobals.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QList>
+#include <QMimeType>
+#include <QTest>
+
+#include <string.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+QTEST_GUILESS_MAIN( DataItemMemoryBenchmark )
+
+namespace {
+
+    const int s_dirCount = 1000;
+    const int s_filesPerDir = 1000;
+
+    long s_baselineBytesPerItem = 0;
+
+    long residentSetSize()
+    {
+        // in KiB on Linux. The peak RSS from getrusage() cannot be used since
+        // both layouts are measured in the same process.
+        QFile f( QLatin1String( "/proc/self/statm" ) );
+        if( !f.open( QIODevice::ReadOnly ) )
+            return 0;
+        const QList<QByteArray> fields = f.readAll().split( ' ' );
+        if( fields.count() < 2 )
+            return 0;
+        return fields[1].toLong() * ( ::sysconf( _SC_PAGESIZE ) / 1024 );
+    }
+
+    void releaseFreedMemory()
+    {
+#ifdef __GLIBC__
+        // give the memory of the previous measurement back to the system so
+        // the next one does not reuse it
+        ::malloc_trim( 0 );
+#endif
+    }
+
+    /**
+     * The members of DataItem and FileItem as they were before the items
+     * were compacted. The baseline does not include the DirItem and DataDoc
+     * bookkeeping, so it underestimates the old memory use slightly.
+     */
+    class UncompactedFileItem
+    {
+    public:
+        struct Private {
+            int flags;
+        };
+
+        UncompactedFileItem( const k3b_struct_stat* stat, const QString& filePath )
+            : d( new Private ),
+              m_parentDir( 0 ),
+              m_sortWeight( 0 ),
+              m_bHideOnRockRidge( false ),
+              m_bHideOnJoliet( false ),
+              m_bRemoveable( true ),
+              m_bRenameable( true ),
+              m_bMovable( true ),
+              m_bHideable( true ),
+              m_bWriteToCd( true ),
+              m_replacedItemFromOldSession( 0 ),
+              m_size( stat->st_size ),
+              m_sizeFollowed( stat->st_size ),
+              m_localPath( filePath )
+        {
+            d->flags = 0;
+            m_k3bName = filePath.section( QLatin1Char( '/' ), -1 );
+            m_id.device = m_idFollowed.device = stat->st_dev;
+            m_id.inode = m_idFollowed.inode = stat->st_ino;
+        }
+
+        virtual ~UncompactedFileItem() { delete d; }
+
+        QString k3bName() const { return m_k3bName; }
+        QString localPath() const { return m_localPath; }
+
+    private:
+        struct Id {
+            dev_t device;
+            ino_t inode;
+        };
+
+        Private* d;
+
+        QString m_k3bName;
+        QString m_writtenName;
+        QString m_rawIsoName;
+        QString m_extraInfo;
+
+        void* m_parentDir;
+        long m_sortWeight;
+
+        bool m_bHideOnRockRidge;
+        bool m_bHideOnJoliet;
+        bool m_bRemoveable;
+        bool m_bRenameable;
+        bool m_bMovable;
+        bool m_bHideable;
+        bool m_bWriteToCd;
+
+        void* m_replacedItemFromOldSession;
+
+        KIO::filesize_t m_size;
+        KIO::filesize_t m_sizeFollowed;
+        Id m_id;
+        Id m_idFollowed;
+
+        QString m_localPath;
+
+        QMimeType m_mimeType;
+    };
+
+    k3b_struct_stat syntheticStat()
+    {
+        k3b_struct_stat st = syntheticStat();
+        return st;
+    }
+
+    QString syntheticDir( int i )
+    {
+        return QString::fromLatin1( "/home/user/synthetic/project/dir%1/" ).arg( i );
+    }
+
+    QString syntheticFile( int j )
+    {
+        return QString::fromLatin1( "file%1.dat" ).arg( j );
+    }
+
+    void createItems( K3b::DataDoc& doc )
+    {
+        // the stat constructor is what DataUrlAddingDialog and the project loading
+        // use, this way the benchmark does not depend on the local file system
+        k3b_struct_stat st;
+        ::memset( &st, 0, sizeof( st ) );
+        st.st_mode = S_IFREG | 0644;
+        st.st_dev = 1;
+
+        for( int i = 0; i < s_dirCount; ++i ) {
+            K3b::DirItem* dir = new K3b::DirItem( QString::fromLatin1( "dir%1" ).arg( i ) );
+            doc.root()->addDataItem( dir );
+
+            const QString dirPath = syntheticDir( i );
+            K3b::DirItem::Children items;
+            for( int j = 0; j < s_filesPerDir; ++j ) {
+                ++st.st_ino;
+                st.st_size = j * 1000;
+                items.append( new K3b::FileItem( &st, &st, dirPath + syntheticFile( j ), doc ) );
+            }
+            dir->addDataItems( items );
+        }
+    }
+
+} // namespace
+
+
+void DataItemMemoryBenchmark::benchmarkUncompactedLayout()
+{
+    releaseFreedMemory();
+    const long before = residentSetSize();
+
+    QList<QList<UncompactedFileItem*> > dirs;
+    QBENCHMARK_ONCE {
+        k3b_struct_stat st = syntheticStat();
+        for( int i = 0; i < s_dirCount; ++i ) {
+            const QString dirPath = syntheticDir( i );
+            QList<UncompactedFileItem*> items;
+            for( int j = 0; j < s_filesPerDir; ++j ) {
+                ++st.st_ino;
+                st.st_size = j * 1000;
+                items.append( new UncompactedFileItem( &st, dirPath + syntheticFile( j ) ) );
+            }
+            dirs.append( items );
+        }
+    }
+
+    const long after = residentSetSize();
+    const long count = long( s_dirCount ) * s_filesPerDir;
+    s_baselineBytesPerItem = ( after - before ) * 1024 / count;
+    qDebug() << "uncompacted layout: RSS before:" << before << "KiB after:" << after << "KiB,"
+             << s_baselineBytesPerItem << "bytes per file item";
+
+    QCOMPARE( dirs[7][42]->localPath(), syntheticDir( 7 ) + syntheticFile( 42 ) );
+
+    Q_FOREACH( const QList<UncompactedFileItem*>& items, dirs ) {
+        qDeleteAll( items );
+    }
+}
+
+
+void DataItemMemoryBenchmark::benchmarkCreate()
+{
+    releaseFreedMemory();
+    const long before = residentSetSize();
+
+    K3b::DataDoc doc;
+    doc.newDocument();
+
+    QBENCHMARK_ONCE {
+        createItems( doc );
+    }
+
+    const long after = residentSetSize();
+    const long count = long( s_dirCount ) * s_filesPerDir;
+    const long bytesPerItem = ( after - before ) * 1024 / count;
+    qDebug() << "compacted layout: RSS before:" << before << "KiB after:" << after << "KiB,"
+             << bytesPerItem << "bytes per file item";
+    if( s_baselineBytesPerItem > 0 )
+        qDebug() << "saved" << s_baselineBytesPerItem - bytesPerItem << "bytes per file item ("
+                 << ( s_baselineBytesPerItem - bytesPerItem ) * 100 / s_baselineBytesPerItem << "% )";
+
+    QCOMPARE( doc.root()->numFiles(), count );
+
+    K3b::DataItem* item = doc.root()->find( QLatin1String( "dir7" ) );
+    QVERIFY( item && item->isDir() );
+    item = static_cast<K3b::DirItem*>( item )->find( QLatin1String( "file42.dat" ) );
+    QVERIFY( item );
+    QCOMPARE( item->localPath(), QString::fromLatin1( "/home/user/synthetic/project/dir7/file42.dat" ) );
+
+    // renaming must not change the local file
+    item->setK3bName( QLatin1String( "renamed.dat" ) );
+    QCOMPARE( item->localPath(), QString::fromLatin1( "/home/user/synthetic/project/dir7/file42.dat" ) );
+}
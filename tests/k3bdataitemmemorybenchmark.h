@@ -0,0 +1,22 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef K3B_DATA_ITEM_MEMORY_BENCHMARK_H
+#define K3B_DATA_ITEM_MEMORY_BENCHMARK_H
+
+#include <QObject>
+
+class DataItemMemoryBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // runs first so the baseline is measured before the project exists
+    void benchmarkUncompactedLayout();
+    void benchmarkCreate();
+};
+
+#endif // K3B_DATA_ITEM_MEMORY_BENCHMARK_H
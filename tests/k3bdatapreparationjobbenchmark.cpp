@@ -0,0 +1,92 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bdatapreparationjobbenchmark.h"
+#include "k3bcore.h"
+#include "k3bdatadoc.h"
+#include "k3bdatapreparationjob.h"
+#include "k3bdiritem.h"
+#include "k3bisooptions.h"
+#include "k3bspecialdataitem.h"
+
+#include <QSignalSpy>
+#include <QTest>
+
+QTEST_MAIN( DataPreparationJobBenchmark )
+
+namespace {
+
+    /**
+     * Creates @p dirs directories with @p filesPerDir items each. With
+     * whitespace stripping every second item clashes with its predecessor
+     * so the collision resolution is exercised, too.
+     */
+    void createTree( K3b::DataDoc& doc, int dirs, int filesPerDir )
+    {
+        for( int i = 0; i < dirs; ++i ) {
+            K3b::DirItem* dir = dirs == 1 ? doc.root() : new K3b::DirItem( QString::fromLatin1( "dir%1" ).arg( i ) );
+            K3b::DirItem::Children items;
+            items.reserve( filesPerDir );
+            for( int j = 0; j < filesPerDir; ++j ) {
+                const QString name = ( j % 2 ? QString::fromLatin1( "file %1.txt" ) : QString::fromLatin1( "file%1.txt" ) ).arg( j / 2 );
+                items.append( new K3b::SpecialDataItem( 2048, name ) );
+            }
+            dir->addDataItems( items );
+            if( dir != doc.root() )
+                doc.root()->addDataItem( dir );
+        }
+    }
+
+} // namespace
+
+
+void DataPreparationJobBenchmark::initTestCase()
+{
+    m_core = new K3b::Core( this );
+}
+
+
+void DataPreparationJobBenchmark::cleanupTestCase()
+{
+    delete m_core;
+}
+
+
+void DataPreparationJobBenchmark::benchmarkRun_data()
+{
+    QTest::addColumn<int>( "dirs" );
+    QTest::addColumn<int>( "filesPerDir" );
+    QTest::newRow( "flat 10k" ) << 1 << 10000;
+    QTest::newRow( "flat 100k" ) << 1 << 100000;
+    QTest::newRow( "1k dirs x 100" ) << 1000 << 100;
+    QTest::newRow( "10k dirs x 100" ) << 10000 << 100;
+}
+
+
+void DataPreparationJobBenchmark::benchmarkRun()
+{
+    QFETCH( int, dirs );
+    QFETCH( int, filesPerDir );
+
+    K3b::DataDoc doc;
+    doc.newDocument();
+    K3b::IsoOptions options = doc.isoOptions();
+    options.setCreateJoliet( true );
+    options.setCreateRockRidge( true );
+    options.setWhiteSpaceTreatment( K3b::IsoOptions::strip );
+    doc.setIsoOptions( options );
+    createTree( doc, dirs, filesPerDir );
+
+    K3b::DataPreparationJob job( &doc, 0, 0 );
+    QSignalSpy spy( &job, SIGNAL(finished(bool)) );
+
+    QBENCHMARK_ONCE {
+        job.start();
+        QVERIFY( spy.wait( 600000 ) );
+    }
+
+    QCOMPARE( spy.first().first().toBool(), true );
+}
@@ -0,0 +1,28 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef K3B_DATA_PREPARATION_JOB_BENCHMARK_H
+#define K3B_DATA_PREPARATION_JOB_BENCHMARK_H
+
+#include <QObject>
+
+namespace K3b { class Core; }
+
+class DataPreparationJobBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void benchmarkRun_data();
+    void benchmarkRun();
+
+private:
+    K3b::Core* m_core;
+};
+
+#endif // K3B_DATA_PREPARATION_JOB_BENCHMARK_H
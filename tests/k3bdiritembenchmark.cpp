@@ -0,0 +1,114 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bdiritembenchmark.h"
+#include "k3bdatadoc.h"
+#include "k3bdiritem.h"
+#include "k3bspecialdataitem.h"
+
+#include <QTest>
+
+QTEST_GUILESS_MAIN( DirItemBenchmark )
+
+namespace {
+
+    void addItems( K3b::DirItem* dir, int count )
+    {
+        // mimic DataDoc::addUrlsToDir which checks for name clashes for every new item
+        for( int i = 0; i < count; ++i ) {
+            const QString name = QString::fromLatin1( "file%1" ).arg( i );
+            if( !K3b::DataDoc::nameAlreadyInDir( name, dir ) )
+                dir->addDataItem( new K3b::SpecialDataItem( 2048, name ) );
+        }
+    }
+
+    void addRows()
+    {
+        QTest::addColumn<int>( "count" );
+        QTest::newRow( "10k" ) << 10000;
+        QTest::newRow( "100k" ) << 100000;
+        QTest::newRow( "1M" ) << 1000000;
+    }
+
+} // namespace
+
+
+void DirItemBenchmark::benchmarkAdd_data()
+{
+    addRows();
+}
+
+
+void DirItemBenchmark::benchmarkAdd()
+{
+    QFETCH( int, count );
+
+    K3b::DataDoc doc;
+    doc.newDocument();
+    K3b::DirItem* dir = new K3b::DirItem( "dir" );
+    doc.root()->addDataItem( dir );
+
+    QBENCHMARK_ONCE {
+        addItems( dir, count );
+    }
+
+    QCOMPARE( dir->children().size(), count );
+}
+
+
+void DirItemBenchmark::benchmarkFind_data()
+{
+    addRows();
+}
+
+
+void DirItemBenchmark::benchmarkFind()
+{
+    QFETCH( int, count );
+
+    K3b::DataDoc doc;
+    doc.newDocument();
+    K3b::DirItem* dir = new K3b::DirItem( "dir" );
+    doc.root()->addDataItem( dir );
+    addItems( dir, count );
+
+    int found = 0;
+    QBENCHMARK_ONCE {
+        for( int i = 0; i < count; ++i ) {
+            if( dir->find( QString::fromLatin1( "file%1" ).arg( i ) ) )
+                ++found;
+        }
+    }
+
+    QCOMPARE( found, count );
+}
+
+
+void DirItemBenchmark::benchmarkRemove_data()
+{
+    QTest::addColumn<int>( "count" );
+    QTest::newRow( "10k" ) << 10000;
+    QTest::newRow( "200k" ) << 200000;
+}
+
+
+void DirItemBenchmark::benchmarkRemove()
+{
+    QFETCH( int, count );
+
+    K3b::DataDoc doc;
+    doc.newDocument();
+    K3b::DirItem* dir = new K3b::DirItem( "dir" );
+    doc.root()->addDataItem( dir );
+    addItems( dir, count );
+
+    QBENCHMARK_ONCE {
+        doc.removeItem( dir );
+    }
+
+    QVERIFY( doc.root()->children().isEmpty() );
+    QCOMPARE( doc.root()->numFiles(), 0L );
+}
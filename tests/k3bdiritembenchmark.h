@@ -0,0 +1,25 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef K3B_DIR_ITEM_BENCHMARK_H
+#define K3B_DIR_ITEM_BENCHMARK_H
+
+#include <QObject>
+
+class DirItemBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void benchmarkAdd_data();
+    void benchmarkAdd();
+    void benchmarkFind_data();
+    void benchmarkFind();
+    void benchmarkRemove_data();
+    void benchmarkRemove();
+};
+
+#endif // K3B_DIR_ITEM_BENCHMARK_H
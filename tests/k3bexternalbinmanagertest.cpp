@@ -3,12 +3,16 @@
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 
+#include <QFile>
+#include <QStandardPaths>
+#include <QTemporaryDir>
 #include <QTest>
 
 #include "k3bexternalbinmanagertest.h"
 #include "k3bcore.h"
 #include "k3bjob.h"
 #include "k3bexternalbinmanager.h"
+#include "k3bexternalbincache.h"
 #include "k3bburnprogressdialog.h"
 #include "k3bdefaultexternalprograms.h"
 
@@ -44,6 +48,57 @@ private:
     }
 };
 
+class TestBurnerProgram : public K3b::SimpleExternalProgram
+{
+public:
+    TestBurnerProgram() : K3b::SimpleExternalProgram("testburner") {}
+
+protected:
+    void parseFeatures(const QString& output, K3b::ExternalBin& bin) const override
+    {
+        if (output.contains("--fancy"))
+            bin.addFeature("fancy");
+    }
+};
+
+namespace {
+    // A fake program which logs each invocation
+    bool writeTestBurner(const QString& path, const QString& log, const QString& version)
+    {
+        QFile f(path);
+        if (!f.open(QIODevice::WriteOnly))
+            return false;
+        f.write(QString("#!/bin/sh\n"
+                        "echo \"$1\" >> \"%1\"\n"
+                        "case \"$1\" in\n"
+                        "  --version) echo \"testburner %2 (C) nobody\" ;;\n"
+                        "  --help) echo \"--fancy   be fancy\" ;;\n"
+                        "esac\n").arg(log, version).toLocal8Bit());
+        f.close();
+        return f.setPermissions(f.permissions() | QFileDevice::ExeOwner);
+    }
+
+    int invocations(const QString& log)
+    {
+        QFile f(log);
+        if (!f.open(QIODevice::ReadOnly))
+            return 0;
+        return f.readAll().count('\n');
+    }
+
+    QString searchTestBurner(const QString& dir)
+    {
+        K3b::ExternalBinManager manager;
+        manager.addProgram(new TestBurnerProgram);
+        manager.setSearchPath(QStringList() << dir);
+        manager.search();
+        const K3b::ExternalBin* bin = manager.binObject("testburner");
+        if (!bin)
+            return QString();
+        return bin->version().toString() + (bin->hasFeature("fancy") ? " fancy" : "");
+    }
+}
+
 QTEST_GUILESS_MAIN(ExternalBinManagerTest)
 
 ExternalBinManagerTest::ExternalBinManagerTest()
@@ -52,6 +107,12 @@ ExternalBinManagerTest::ExternalBinManagerTest()
 {
 }
 
+void ExternalBinManagerTest::initTestCase()
+{
+    // keep the cache of the real user untouched
+    QStandardPaths::setTestModeEnabled(true);
+}
+
 void ExternalBinManagerTest::testBinObject()
 {
     K3b::ExternalBinManager* binManager = new K3b::ExternalBinManager;
@@ -68,6 +129,41 @@ void ExternalBinManagerTest::testBinObject()
     //}
 }
 
+void ExternalBinManagerTest::testCache()
+{
+#ifdef Q_OS_WIN
+    QSKIP("requires a POSIX shell");
+#endif
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString program = dir.filePath("testburner");
+    const QString log = dir.filePath("log");
+    QVERIFY(writeTestBurner(program, log, "1.2.3"));
+
+    K3b::ExternalBinCache* cache = K3b::ExternalBinCache::instance();
+    cache->clear();
+
+    QCOMPARE(searchTestBurner(dir.path()), QString("1.2.3 fancy"));
+    QCOMPARE(invocations(log), 2);
+
+    // the second search, like the next startup, must not run the program again
+    QCOMPARE(searchTestBurner(dir.path()), QString("1.2.3 fancy"));
+    QCOMPARE(invocations(log), 2);
+
+    K3b::ExternalBinCache reloaded(cache->filename());
+    QCOMPARE(reloaded.count(), cache->count());
+
+    // an updated binary needs to be probed again
+    QVERIFY(writeTestBurner(program, log, "2.0.10"));
+    QCOMPARE(searchTestBurner(dir.path()), QString("2.0.10 fancy"));
+    QCOMPARE(invocations(log), 4);
+
+    // entries of vanished binaries are dropped
+    QVERIFY(QFile::remove(program));
+    QVERIFY(cache->save());
+    QCOMPARE(K3b::ExternalBinCache(cache->filename()).count(), 0);
+}
+
 void ExternalBinManagerTest::testMyBurnJob() 
 {
     QSKIP("currently segfaulting");
@@ -18,7 +18,9 @@ public:
     ExternalBinManagerTest();
 
 private Q_SLOTS:
+    void initTestCase();
     void testBinObject();
+    void testCache();
     void testMyBurnJob();
 
 private:
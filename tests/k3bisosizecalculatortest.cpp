@@ -0,0 +1,273 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bisosizecalculatortest.h"
+#include "k3bcore.h"
+#include "k3bdatadoc.h"
+#include "k3bdiritem.h"
+#include "k3bexternalbinmanager.h"
+#include "k3bfileitem.h"
+#include "k3bisoimager.h"
+#include "k3bisooptions.h"
+#include "k3bisosizecalculator.h"
+
+#include <QFile>
+#include <QSignalSpy>
+#include <QTest>
+
+#include <unistd.h>
+
+QTEST_MAIN( IsoSizeCalculatorTest )
+
+IsoSizeCalculatorTest::IsoSizeCalculatorTest()
+    : m_core( 0 ),
+      m_fileCount( 0 )
+{
+}
+
+
+void IsoSizeCalculatorTest::initTestCase()
+{
+    QVERIFY( m_dir.isValid() );
+
+    m_core = new K3b::Core( this );
+    m_core->externalBinManager()->search();
+    if( !m_core->externalBinManager()->binObject( "mkisofs" ) )
+        QSKIP( "mkisofs not found" );
+}
+
+
+void IsoSizeCalculatorTest::cleanupTestCase()
+{
+    delete m_core;
+}
+
+
+void IsoSizeCalculatorTest::addOptionRows()
+{
+    QTest::addColumn<bool>( "rockRidge" );
+    QTest::addColumn<bool>( "joliet" );
+    QTest::addColumn<bool>( "jolietLong" );
+    QTest::addColumn<int>( "isoLevel" );
+
+    QTest::newRow( "iso9660" ) << false << false << false << 1;
+    QTest::newRow( "rock ridge" ) << true << false << false << 2;
+    QTest::newRow( "joliet" ) << false << true << false << 2;
+    QTest::newRow( "rock ridge and joliet" ) << true << true << false << 2;
+    QTest::newRow( "long joliet names, level 3" ) << true << true << true << 3;
+}
+
+
+void IsoSizeCalculatorTest::initDoc( K3b::DataDoc& doc )
+{
+    QFETCH( bool, rockRidge );
+    QFETCH( bool, joliet );
+    QFETCH( bool, jolietLong );
+    QFETCH( int, isoLevel );
+
+    doc.newDocument();
+    K3b::IsoOptions options = doc.isoOptions();
+    options.setCreateRockRidge( rockRidge );
+    options.setCreateJoliet( joliet );
+    options.setJolietLong( jolietLong );
+    options.setISOLevel( isoLevel );
+    doc.setIsoOptions( options );
+}
+
+
+K3b::FileItem* IsoSizeCalculatorTest::newFile( K3b::DataDoc& doc, const QString& name, int size )
+{
+    const QString path = m_dir.filePath( QString::fromLatin1( "file%1" ).arg( m_fileCount++ ) );
+    QFile f( path );
+    if( f.open( QIODevice::WriteOnly ) )
+        f.write( QByteArray( size, 'x' ) );
+    return new K3b::FileItem( path, doc, name );
+}
+
+
+int IsoSizeCalculatorTest::mkisofsSize( K3b::DataDoc& doc )
+{
+    K3b::IsoImager imager( &doc, 0 );
+    imager.setExactSizeRequired( true );
+    QSignalSpy finished( &imager, SIGNAL(finished(bool)) );
+    imager.calculateSize();
+    if( finished.isEmpty() && !finished.wait( 60000 ) )
+        return -1;
+    return finished.first().first().toBool() ? imager.size() : -1;
+}
+
+
+void IsoSizeCalculatorTest::testFlatFolder_data()
+{
+    addOptionRows();
+}
+
+
+void IsoSizeCalculatorTest::testFlatFolder()
+{
+    K3b::DataDoc doc;
+    initDoc( doc );
+
+    // enough entries for the directories to span several sectors
+    for( int i = 0; i < 300; ++i ) {
+        const QString name = ( i % 3 ? QString::fromLatin1( "track%1.ogg" ) : QString::fromLatin1( "README%1" ) ).arg( i );
+        doc.root()->addDataItem( newFile( doc, name, i * 517 ) );
+    }
+
+    QCOMPARE( doc.isoSizeCalculator()->size().lba(), mkisofsSize( doc ) );
+}
+
+
+void IsoSizeCalculatorTest::testLongNames_data()
+{
+    addOptionRows();
+}
+
+
+void IsoSizeCalculatorTest::testLongNames()
+{
+    K3b::DataDoc doc;
+    initDoc( doc );
+
+    // long enough for the Rock Ridge entries to need a continuation area
+    // and to be truncated in the Joliet tree
+    K3b::DirItem* dir = new K3b::DirItem( QString::fromLatin1( "A folder with a name that is way longer than ISO9660 allows" ) );
+    for( int i = 0; i < 40; ++i ) {
+        const QString name = QString::fromLatin1( "%1 - a file name with more than two hundred characters which is only "
+                                                  "stored completely in the Rock Ridge NM entry, while ISO9660 and Joliet "
+                                                  "get truncated versions of it.flac" ).arg( i, 3, 10, QChar( '0' ) );
+        dir->addDataItem( newFile( doc, name, 4096 + i ) );
+    }
+    doc.root()->addDataItem( dir );
+
+    QCOMPARE( doc.isoSizeCalculator()->size().lba(), mkisofsSize( doc ) );
+}
+
+
+void IsoSizeCalculatorTest::testDeepTree_data()
+{
+    addOptionRows();
+}
+
+
+void IsoSizeCalculatorTest::testDeepTree()
+{
+    K3b::DataDoc doc;
+    initDoc( doc );
+
+    // deeper than the eight levels ISO9660 allows without relocation
+    K3b::DirItem* parent = doc.root();
+    for( int level = 0; level < 12; ++level ) {
+        K3b::DirItem* dir = new K3b::DirItem( QString::fromLatin1( "level%1" ).arg( level ) );
+        dir->addDataItem( newFile( doc, QString::fromLatin1( "data%1.bin" ).arg( level ), 10000 ) );
+        for( int i = 0; i < 3; ++i )
+            dir->addDataItem( new K3b::DirItem( QString::fromLatin1( "empty%1" ).arg( i ) ) );
+        parent->addDataItem( dir );
+        parent = dir;
+    }
+
+    QCOMPARE( doc.isoSizeCalculator()->size().lba(), mkisofsSize( doc ) );
+}
+
+
+void IsoSizeCalculatorTest::testHardlinks_data()
+{
+    addOptionRows();
+}
+
+
+void IsoSizeCalculatorTest::testHardlinks()
+{
+    K3b::DataDoc doc;
+    initDoc( doc );
+
+    K3b::FileItem* file = newFile( doc, QString::fromLatin1( "original.iso" ), 1000000 );
+    doc.root()->addDataItem( file );
+
+    K3b::DirItem* dir = new K3b::DirItem( QString::fromLatin1( "links" ) );
+    for( int i = 0; i < 3; ++i ) {
+        const QString link = m_dir.filePath( QString::fromLatin1( "link%1-%2" ).arg( m_fileCount++ ).arg( i ) );
+        QCOMPARE( ::link( QFile::encodeName( file->localPath() ).constData(), QFile::encodeName( link ).constData() ), 0 );
+        dir->addDataItem( new K3b::FileItem( link, doc, QString::fromLatin1( "link%1.iso" ).arg( i ) ) );
+    }
+    doc.root()->addDataItem( dir );
+
+    QCOMPARE( doc.isoSizeCalculator()->size().lba(), mkisofsSize( doc ) );
+}
+
+
+void IsoSizeCalculatorTest::testHiddenFiles_data()
+{
+    addOptionRows();
+}
+
+
+void IsoSizeCalculatorTest::testHiddenFiles()
+{
+    K3b::DataDoc doc;
+    initDoc( doc );
+
+    K3b::DirItem* dir = new K3b::DirItem( QString::fromLatin1( "hidden things" ) );
+    doc.root()->addDataItem( dir );
+    for( int i = 0; i < 50; ++i ) {
+        K3b::FileItem* file = newFile( doc, QString::fromLatin1( "file%1.txt" ).arg( i ), 3000 );
+        dir->addDataItem( file );
+        if( i % 2 )
+            file->setHideOnRockRidge( true );
+        if( i % 3 )
+            file->setHideOnJoliet( true );
+    }
+    dir->setHideOnRockRidge( true );
+
+    QCOMPARE( doc.isoSizeCalculator()->size().lba(), mkisofsSize( doc ) );
+}
+
+
+void IsoSizeCalculatorTest::testIncrementalChanges_data()
+{
+    addOptionRows();
+}
+
+
+void IsoSizeCalculatorTest::testIncrementalChanges()
+{
+    K3b::DataDoc doc;
+    initDoc( doc );
+
+    K3b::DirItem* dirs[3];
+    for( int i = 0; i < 3; ++i ) {
+        dirs[i] = new K3b::DirItem( QString::fromLatin1( "folder%1" ).arg( i ) );
+        for( int j = 0; j < 60; ++j )
+            dirs[i]->addDataItem( newFile( doc, QString::fromLatin1( "song%1.mp3" ).arg( j ), 5000 + j ) );
+        doc.root()->addDataItem( dirs[i] );
+    }
+    QCOMPARE( doc.isoSizeCalculator()->size().lba(), mkisofsSize( doc ) );
+
+    // adding files and a populated folder
+    for( int j = 0; j < 40; ++j )
+        dirs[1]->addDataItem( newFile( doc, QString::fromLatin1( "added%1.mp3" ).arg( j ), 7000 ) );
+    K3b::DirItem* subDir = new K3b::DirItem( QString::fromLatin1( "sub folder" ) );
+    subDir->addDataItem( newFile( doc, QString::fromLatin1( "nested.txt" ), 100 ) );
+    dirs[0]->addDataItem( subDir );
+    QCOMPARE( doc.isoSizeCalculator()->size().lba(), mkisofsSize( doc ) );
+
+    // renaming a file and a folder
+    dirs[1]->children().first()->setK3bName( QString::fromLatin1( "a much longer name which needs more room in every tree.mp3" ) );
+    subDir->setK3bName( QString::fromLatin1( "a renamed sub folder with a long name" ) );
+    QCOMPARE( doc.isoSizeCalculator()->size().lba(), mkisofsSize( doc ) );
+
+    // removing files and a folder
+    doc.removeItem( dirs[1]->children().last() );
+    doc.removeItem( dirs[2] );
+    QCOMPARE( doc.isoSizeCalculator()->size().lba(), mkisofsSize( doc ) );
+
+    // folders excluded from the image like the ones of an imported session
+    dirs[0]->setWriteToCd( false );
+    QCOMPARE( doc.isoSizeCalculator()->size().lba(), mkisofsSize( doc ) );
+    dirs[0]->setWriteToCd( true );
+    QCOMPARE( doc.isoSizeCalculator()->size().lba(), mkisofsSize( doc ) );
+}
+
+#include "moc_k3bisosizecalculatortest.cpp"
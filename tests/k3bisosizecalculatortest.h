@@ -0,0 +1,64 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef K3B_ISO_SIZE_CALCULATOR_TEST_H
+#define K3B_ISO_SIZE_CALCULATOR_TEST_H
+
+#include <QObject>
+#include <QTemporaryDir>
+
+namespace K3b {
+    class Core;
+    class DataDoc;
+    class FileItem;
+}
+
+/**
+ * Compares the in-process IsoSizeCalculator with mkisofs -print-size.
+ * Skipped if mkisofs cannot be found.
+ */
+class IsoSizeCalculatorTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    IsoSizeCalculatorTest();
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void testFlatFolder_data();
+    void testFlatFolder();
+    void testLongNames_data();
+    void testLongNames();
+    void testDeepTree_data();
+    void testDeepTree();
+    void testHardlinks_data();
+    void testHardlinks();
+    void testHiddenFiles_data();
+    void testHiddenFiles();
+    void testIncrementalChanges_data();
+    void testIncrementalChanges();
+
+private:
+    void addOptionRows();
+    void initDoc( K3b::DataDoc& doc );
+
+    /**
+     * A new file item named @p name for a new file of @p size bytes.
+     */
+    K3b::FileItem* newFile( K3b::DataDoc& doc, const QString& name, int size );
+
+    /**
+     * \return The size mkisofs reports for @p doc or -1 on error.
+     */
+    int mkisofsSize( K3b::DataDoc& doc );
+
+    K3b::Core* m_core;
+    QTemporaryDir m_dir;
+    int m_fileCount;
+};
+
+#endif // K3B_ISO_SIZE_CALCULATOR_TEST_H
@@ -0,0 +1,87 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bmaddecodersignaturetest.h"
+#include "k3bmaddecoder.h"
+
+#include <QTemporaryFile>
+#include <QTest>
+
+QTEST_GUILESS_MAIN( MadDecoderSignatureTest )
+
+namespace {
+
+    // MPEG 1 layer III, 128 kbit/s, 44.1 kHz
+    const char FRAME_HEADER[] = "\xff\xfb\x90\x64";
+
+    QByteArray frames()
+    {
+        return QByteArray( FRAME_HEADER, 4 ) + QByteArray( 413, '\0' );
+    }
+
+    QByteArray id3v2Tag( int size )
+    {
+        QByteArray tag( "ID3\x03\x00\x00", 6 );
+        tag.append( char( ( size >> 21 ) & 0x7f ) );
+        tag.append( char( ( size >> 14 ) & 0x7f ) );
+        tag.append( char( ( size >> 7 ) & 0x7f ) );
+        tag.append( char( size & 0x7f ) );
+        return tag + QByteArray( size, '\0' );
+    }
+
+} // namespace
+
+
+void MadDecoderSignatureTest::testFrameAtStart()
+{
+    K3bMadDecoderFactory factory;
+    QCOMPARE( factory.checkSignature( frames() ), K3b::AudioDecoderFactory::SignatureMatch );
+}
+
+
+void MadDecoderSignatureTest::testJunkBeforeFrame()
+{
+    // K3bMad::seekFirstHeader() skips more than 1 KiB of junk
+    K3bMadDecoderFactory factory;
+    QCOMPARE( factory.checkSignature( QByteArray( 2000, '\0' ) + frames() ),
+              K3b::AudioDecoderFactory::SignatureMatch );
+}
+
+
+void MadDecoderSignatureTest::testNoFrame()
+{
+    // the frame may follow later so this must not rule out the file
+    K3bMadDecoderFactory factory;
+    QCOMPARE( factory.checkSignature( QByteArray( 4096, '\0' ) ),
+              K3b::AudioDecoderFactory::SignatureUnknown );
+}
+
+
+void MadDecoderSignatureTest::testId3v2Tag_data()
+{
+    QTest::addColumn<int>( "tagSize" );
+    QTest::newRow( "within header" ) << 1000;
+    QTest::newRow( "beyond header" ) << 10000;
+}
+
+
+void MadDecoderSignatureTest::testId3v2Tag()
+{
+    QFETCH( int, tagSize );
+
+    QTemporaryFile file;
+    QVERIFY( file.open() );
+    file.write( id3v2Tag( tagSize ) + frames() );
+    file.close();
+
+    const QByteArray header = K3b::AudioDecoderFactory::readSignatureHeader( file.fileName() );
+    QVERIFY( header.startsWith( QByteArray( FRAME_HEADER, 4 ) ) );
+
+    K3bMadDecoderFactory factory;
+    QCOMPARE( factory.checkSignature( header ), K3b::AudioDecoderFactory::SignatureMatch );
+}
+
+#include "moc_k3bmaddecodersignaturetest.cpp"
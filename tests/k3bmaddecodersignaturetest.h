@@ -0,0 +1,24 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef K3B_MAD_DECODER_SIGNATURE_TEST_H
+#define K3B_MAD_DECODER_SIGNATURE_TEST_H
+
+#include <QObject>
+
+class MadDecoderSignatureTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testFrameAtStart();
+    void testJunkBeforeFrame();
+    void testNoFrame();
+    void testId3v2Tag_data();
+    void testId3v2Tag();
+};
+
+#endif // K3B_MAD_DECODER_SIGNATURE_TEST_H
@@ -0,0 +1,186 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bprojectloadsavebenchmark.h"
+#include "k3bdatadoc.h"
+#include "k3bdiritem.h"
+#include "k3bfileitem.h"
+
+#include <QBuffer>
+#include <QDir>
+#include <QDomDocument>
+#include <QDebug>
+#include <QDomElement>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTest>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+QTEST_GUILESS_MAIN( ProjectLoadSaveBenchmark )
+
+namespace {
+
+    const int s_dirCount = 100;
+    const int s_filesPerDir = 1000;
+
+    /**
+     * Makes the project serialization accessible, normally only ProjectManager uses it.
+     */
+    class BenchmarkDataDoc : public K3b::DataDoc
+    {
+    public:
+        using K3b::DataDoc::loadDocumentData;
+        using K3b::DataDoc::saveDocumentData;
+        using K3b::DataDoc::loadDocumentStream;
+        using K3b::DataDoc::saveDocumentStream;
+    };
+
+    // the same as ProjectManager::saveProject() and openProject() do
+    QByteArray saveStream( BenchmarkDataDoc& doc )
+    {
+        QBuffer buffer;
+        buffer.open( QIODevice::WriteOnly );
+        QXmlStreamWriter writer( &buffer );
+        writer.setAutoFormatting( true );
+        writer.setAutoFormattingIndent( 0 );
+        writer.writeStartDocument();
+        writer.writeDTD( "<!DOCTYPE k3b_data_project>" );
+        writer.writeStartElement( "k3b_data_project" );
+        doc.saveDocumentStream( writer );
+        writer.writeEndElement();
+        writer.writeEndDocument();
+        return buffer.data();
+    }
+
+    bool loadStream( BenchmarkDataDoc& doc, const QByteArray& data )
+    {
+        QXmlStreamReader reader( data );
+        return reader.readNextStartElement() && doc.loadDocumentStream( reader );
+    }
+
+    // the way projects were stored before
+    QByteArray saveDom( BenchmarkDataDoc& doc )
+    {
+        QDomDocument xmlDoc( "k3b_data_project" );
+        xmlDoc.appendChild( xmlDoc.createProcessingInstruction( "xml", "version=\"1.0\" encoding=\"UTF-8\"" ) );
+        QDomElement docElem = xmlDoc.createElement( "k3b_data_project" );
+        xmlDoc.appendChild( docElem );
+        doc.saveDocumentData( &docElem );
+        return xmlDoc.toByteArray( 0 );
+    }
+
+    bool loadDom( BenchmarkDataDoc& doc, const QByteArray& data )
+    {
+        QDomDocument xmlDoc;
+        if( !xmlDoc.setContent( data ) )
+            return false;
+        QDomElement root = xmlDoc.documentElement();
+        return doc.loadDocumentData( &root );
+    }
+
+    void createProject( K3b::DataDoc& doc, const QString& path )
+    {
+        doc.newDocument();
+        for( int i = 0; i < s_dirCount; ++i ) {
+            const QString dirPath = path + QString::fromLatin1( "/dir%1/" ).arg( i );
+            K3b::DirItem* dir = new K3b::DirItem( QString::fromLatin1( "dir%1" ).arg( i ) );
+            K3b::DirItem::Children items;
+            for( int j = 0; j < s_filesPerDir; ++j )
+                items.append( new K3b::FileItem( dirPath + QString::fromLatin1( "file%1.txt" ).arg( j ), doc ) );
+            dir->addDataItems( items );
+            doc.root()->addDataItem( dir );
+        }
+    }
+
+    void addRows()
+    {
+        QTest::addColumn<bool>( "streaming" );
+        QTest::newRow( "QDomDocument" ) << false;
+        QTest::newRow( "QXmlStream" ) << true;
+    }
+
+} // namespace
+
+
+void ProjectLoadSaveBenchmark::initTestCase()
+{
+    QVERIFY( m_dir.isValid() );
+
+    // the files have to exist since loading a project checks them
+    for( int i = 0; i < s_dirCount; ++i ) {
+        const QString dirPath = m_dir.path() + QString::fromLatin1( "/dir%1" ).arg( i );
+        QVERIFY( QDir().mkpath( dirPath ) );
+        for( int j = 0; j < s_filesPerDir; ++j ) {
+            QFile file( dirPath + QString::fromLatin1( "/file%1.txt" ).arg( j ) );
+            QVERIFY( file.open( QIODevice::WriteOnly ) );
+        }
+    }
+}
+
+
+void ProjectLoadSaveBenchmark::benchmarkSave_data()
+{
+    addRows();
+}
+
+
+void ProjectLoadSaveBenchmark::benchmarkSave()
+{
+    QFETCH( bool, streaming );
+
+    BenchmarkDataDoc doc;
+    createProject( doc, m_dir.path() );
+
+    QByteArray data;
+    QBENCHMARK_ONCE {
+        data = streaming ? saveStream( doc ) : saveDom( doc );
+    }
+
+    // both formats have to be readable by both loaders
+    BenchmarkDataDoc domDoc;
+    QVERIFY( loadDom( domDoc, data ) );
+    QCOMPARE( domDoc.root()->numFiles(), long( s_dirCount ) * s_filesPerDir );
+
+    BenchmarkDataDoc streamDoc;
+    QVERIFY( loadStream( streamDoc, data ) );
+    QCOMPARE( streamDoc.root()->numFiles(), long( s_dirCount ) * s_filesPerDir );
+    QCOMPARE( streamDoc.root()->numDirs(), long( s_dirCount ) );
+}
+
+
+void ProjectLoadSaveBenchmark::benchmarkLoad_data()
+{
+    addRows();
+}
+
+
+void ProjectLoadSaveBenchmark::benchmarkLoad()
+{
+    QFETCH( bool, streaming );
+
+    BenchmarkDataDoc doc;
+    createProject( doc, m_dir.path() );
+    const QByteArray data = saveStream( doc );
+
+    BenchmarkDataDoc loadedDoc;
+    bool success = false;
+    QBENCHMARK_ONCE {
+        success = streaming ? loadStream( loadedDoc, data ) : loadDom( loadedDoc, data );
+    }
+
+    QVERIFY( success );
+    QCOMPARE( loadedDoc.root()->numFiles(), long( s_dirCount ) * s_filesPerDir );
+
+    // the streaming loader checks the files in the background
+    QElapsedTimer timer;
+    timer.start();
+    loadedDoc.waitForFileResolution();
+    qDebug() << "files checked after" << timer.elapsed() << "ms";
+
+    QCOMPARE( loadedDoc.root()->numFiles(), long( s_dirCount ) * s_filesPerDir );
+    QCOMPARE( loadedDoc.size(), doc.size() );
+}
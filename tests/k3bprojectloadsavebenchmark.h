@@ -0,0 +1,28 @@
+/*
+    SPDX-FileCopyrightText: 2026 K3b developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef K3B_PROJECT_LOAD_SAVE_BENCHMARK_H
+#define K3B_PROJECT_LOAD_SAVE_BENCHMARK_H
+
+#include <QObject>
+#include <QTemporaryDir>
+
+class ProjectLoadSaveBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void benchmarkSave_data();
+    void benchmarkSave();
+    void benchmarkLoad_data();
+    void benchmarkLoad();
+
+private:
+    QTemporaryDir m_dir;
+};
+
+#endif // K3B_PROJECT_LOAD_SAVE_BENCHMARK_H